@@ -9,6 +9,19 @@
 
 namespace abc {
 
+typedef std::array<std::array<uint8_t, omp::HOLE_CARDS>, omp::COMBO_COUNT> rangeHands_t;
+
+// All the hands of hole cards: the hand h is made of the cards c0 > c1
+// with h = c0 * (c0 - 1) / 2 + c1, as in omp::EquityCalculator.
+inline constexpr rangeHands_t rangeHands = [] {
+	rangeHands_t hands{};
+	for (uint8_t c0 = 1; c0 < omp::CARD_COUNT; ++c0) {
+		for (uint8_t c1 = 0; c1 < c0; ++c1)
+			hands[c0 * (c0 - 1) / 2 + c1] = { c0, c1 };
+	}
+	return hands;
+}();
+
 // Class representing an abstract infoset.
 // It is like a regular infoset, but using abstracted
 // hands (with information abstraction) and abstracted actions
@@ -33,13 +46,12 @@ public:
 		dealer(maxPlayers - 1),
 		state(ante, bigBlind, {}, rngSeed),
 		actionAbc(betSizes),
-		actionSeqIndexer(maxPlayers, ante, bigBlind, initialStake, betSizes, actionSeqIndexerName)
+		actionSeqIndexer(ActionSeqIndexer::loadShared(
+			maxPlayers, ante, bigBlind, initialStake, betSizes, actionSeqIndexerName))
 	{
 		std::fill(initialStakes.begin(), initialStakes.begin() + maxPlayers, initialStake);
 		// Load information abstraction lookup tables.
 		handIndexer.loadLUT();
-		// Load action sequences minimal perfect hash functions.
-		actionSeqIndexer.loadMPHF();
 	}
 
 	AbstractInfoset& operator=(const AbstractInfoset& other)
@@ -133,6 +145,53 @@ public:
 		calculateActionSeqIds();
 	}
 
+	// Does not need the hand of the acting player, e.g. to consider all its hands.
+	void calculateActionSeqIds()
+	{
+		actionSeqIds.clear();
+
+		if (state.round == egn::PREFLOP) {
+			for (uint8_t a : actionAbc.legalActions) {
+				roundActions.push_back(a);
+				actionSeqIds.push_back(
+					actionSeqIndexer->index(state.round, roundActions));
+				roundActions.pop_back();
+			}
+		}
+
+		// For rounds other than preflop, include the number of players.
+		else {
+			for (uint8_t a : actionAbc.legalActions) {
+				roundActions.push_back(a);
+				roundActions.push_back(nPlayers);
+				actionSeqIds.push_back(
+					actionSeqIndexer->index(state.round, roundActions));
+				roundActions.pop_back();
+				roundActions.pop_back();
+			}
+		}
+	}
+
+	// Bucket of each hand h of rangeHands for the acting player in the current
+	// round and board. The hands holding a card of deadCards (bit 1 << card)
+	// or of the board are not live: live[h] is 0 and bcks[h] is not set.
+	void calculateRangeHandsIds(
+		uint64_t deadCards,
+		std::array<bckSize_t, omp::COMBO_COUNT>& bcks,
+		std::array<uint8_t, omp::COMBO_COUNT>& live) const
+	{
+		static const uint8_t nRoundBoardCards[egn::N_ROUNDS] = { 0, 3, 4, 5 };
+		for (uint8_t i = 0; i < nRoundBoardCards[state.round]; ++i)
+			deadCards |= 1ull << state.boardCards[i];
+
+		for (uint16_t h = 0; h < omp::COMBO_COUNT; ++h) {
+			const std::array<uint8_t, omp::HOLE_CARDS>& hand = rangeHands[h];
+			live[h] = !(deadCards & ((1ull << hand[0]) | (1ull << hand[1])));
+			if (live[h])
+				bcks[h] = handIndexer.handIndex(state.round, hand.data(), state.boardCards.data());
+		}
+	}
+
 	// Map the last action done in the given game state to an abstract action
 	// and return it (not the idx).
 	uint8_t mapActionToAbcAction(
@@ -156,6 +215,7 @@ public:
 	//   included for rounds other than preflop.
 	uint8_t roundIdx() const { return state.round; }
 	bckSize_t handIdx() const { return handsIds[state.actingPlayer]; }
+	bckSize_t handIdx(uint8_t player) const { return handsIds[player]; }
 	// Indices of the action sequences leading to each legal action
 	// with the number of players included for rounds other than preflop.
 	// Its size is nActions().
@@ -178,10 +238,10 @@ public:
 	size_t nActionSeqs(egn::Round round) const
 	{
 		switch (round) {
-		case egn::PREFLOP: return actionSeqIndexer.preflopMPHF.nbKeys();
-		case egn::FLOP: return actionSeqIndexer.flopMPHF.nbKeys();
-		case egn::TURN: return actionSeqIndexer.turnMPHF.nbKeys();
-		case egn::RIVER: return actionSeqIndexer.riverMPHF.nbKeys();
+		case egn::PREFLOP: return actionSeqIndexer->preflopMPHF.nbKeys();
+		case egn::FLOP: return actionSeqIndexer->flopMPHF.nbKeys();
+		case egn::TURN: return actionSeqIndexer->turnMPHF.nbKeys();
+		case egn::RIVER: return actionSeqIndexer->riverMPHF.nbKeys();
 		default: throw std::runtime_error("Unknown round.");
 		}
 	}
@@ -217,7 +277,7 @@ public:
 			for (uint8_t a : allLegalActions) {
 				roundActions.push_back(a);
 				allActionSeqIds.push_back(
-					actionSeqIndexer.index(state.round, roundActions));
+					actionSeqIndexer->index(state.round, roundActions));
 				roundActions.pop_back();
 			}
 		}
@@ -227,7 +287,7 @@ public:
 				roundActions.push_back(a);
 				roundActions.push_back(nPlayers);
 				allActionSeqIds.push_back(
-					actionSeqIndexer.index(state.round, roundActions));
+					actionSeqIndexer->index(state.round, roundActions));
 				roundActions.pop_back();
 				roundActions.pop_back();
 			}
@@ -285,32 +345,6 @@ protected:
 			state.round, state.hands[player].data(), state.boardCards.data());
 	}
 
-	void calculateActionSeqIds()
-	{
-		actionSeqIds.clear();
-
-		if (state.round == egn::PREFLOP) {
-			for (uint8_t a : actionAbc.legalActions) {
-				roundActions.push_back(a);
-				actionSeqIds.push_back(
-					actionSeqIndexer.index(state.round, roundActions));
-				roundActions.pop_back();
-			}
-		}
-
-		// For rounds other than preflop, include the number of players.
-		else {
-			for (uint8_t a : actionAbc.legalActions) {
-				roundActions.push_back(a);
-				roundActions.push_back(nPlayers);
-				actionSeqIds.push_back(
-					actionSeqIndexer.index(state.round, roundActions));
-				roundActions.pop_back();
-				roundActions.pop_back();
-			}
-		}
-	}
-
 	const uint8_t dealer;
 	egn::chips initialStake;
 	std::array<egn::chips, egn::MAX_PLAYERS> initialStakes{};
@@ -324,7 +358,8 @@ protected:
 	static abc::LossyIndexer<bckSize_t, nBckPreflop, nBckFlop, nBckTurn, nBckRiver> handIndexer;
 	std::array<bckSize_t, omp::MAX_PLAYERS> handsIds;
 
-	abc::ActionSeqIndexer actionSeqIndexer;
+	// Action sequences minimal perfect hash functions, shared by all the infosets.
+	std::shared_ptr<abc::ActionSeqIndexer> actionSeqIndexer;
 
 }; // AbstractInfoset
 
@@ -1,4 +1,5 @@
 #include "ActionAbstraction.h"
+#include <cmath>
 
 namespace abc {
 
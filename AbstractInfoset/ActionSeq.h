@@ -20,14 +20,14 @@ class StdActionSeqIterator;
 #pragma warning(disable: 4244)
 // Data structure storing a sequence of actions.
 // nBitsPerAction has to be a divisor of nBitsPerInt.
-template<unsigned nBitsPerAction = 4, unsigned maxSizeActionSeq = 32>
+template<unsigned nBits = 4, unsigned maxSize = 32>
 class ActionSeq
 {
 public:
-	typedef ActionSeqIterator<ActionSeq<nBitsPerAction, maxSizeActionSeq>> iter_t;
+	typedef ActionSeqIterator<ActionSeq<nBits, maxSize>> iter_t;
 
-	static const unsigned nBitsPerAction = nBitsPerAction;
-	static const unsigned maxSizeActionSeq = maxSizeActionSeq;
+	static const unsigned nBitsPerAction = nBits;
+	static const unsigned maxSizeActionSeq = maxSize;
 	static const unsigned nBitsPerInt = 64;
 	static const unsigned nInts = ceilIntDiv(nBitsPerAction * maxSizeActionSeq, nBitsPerInt);
 	static const unsigned nActionsPerInt = nBitsPerInt / nBitsPerAction;
@@ -245,7 +245,7 @@ private:
 	uint8_t currInt = 0;
 	uint8_t currBit = 0;
 
-	friend class iter_t;
+	friend iter_t;
 
 };
 #pragma warning(pop)
@@ -479,7 +479,7 @@ private:
 	bool onFirstInt = true;
 	uint8_t currBit = 0;
 
-	friend class iter_t;
+	friend iter_t;
 
 };
 #pragma warning(pop)
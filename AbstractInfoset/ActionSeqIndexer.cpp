@@ -27,6 +27,36 @@ std::string ActionSeqIndexer::getSizesPath(const std::string& indexerName)
 	return mphfDir + indexerName + "_ACTION_SEQ_SIZES.bin";
 }
 
+std::mutex ActionSeqIndexer::sharedMutex;
+std::unordered_map<std::string, std::weak_ptr<ActionSeqIndexer>> ActionSeqIndexer::sharedIndexers;
+
+std::shared_ptr<ActionSeqIndexer> ActionSeqIndexer::loadShared(
+	uint8_t maxPlayers,
+	egn::chips ante,
+	egn::chips bigBlind,
+	egn::chips initialStake,
+	const betSizes_t& betSizes,
+	const std::string& indexerName)
+{
+	// The users of other indexers wait during the loading, which only happens once per indexer.
+	std::lock_guard<std::mutex> lock(sharedMutex);
+	std::shared_ptr<ActionSeqIndexer> indexer = sharedIndexers[indexerName].lock();
+	if (!indexer) {
+		indexer = std::make_shared<ActionSeqIndexer>(
+			maxPlayers, ante, bigBlind, initialStake, betSizes, indexerName);
+		indexer->loadMPHF();
+		sharedIndexers[indexerName] = indexer;
+	}
+	return indexer;
+}
+
+std::shared_ptr<ActionSeqIndexer> ActionSeqIndexer::findShared(const std::string& indexerName)
+{
+	std::lock_guard<std::mutex> lock(sharedMutex);
+	const auto it = sharedIndexers.find(indexerName);
+	return (it == sharedIndexers.end()) ? nullptr : it->second.lock();
+}
+
 void ActionSeqIndexer::buildMPHF()
 {
 	// Collect all action sequences for all rounds.
@@ -7,6 +7,9 @@
 #include "../Utils/io.h"
 #include "../Utils/Constants.h"
 #include "../BBHash/BooPHF.h"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace abc {
 
@@ -34,6 +37,21 @@ public:
 
 	static std::string getSizesPath(const std::string& indexerName);
 
+	// Return the indexer of indexerName with its MPHFs loaded, shared by all its
+	// users in the process: it is loaded by the first one and freed with the last one.
+	// index only reads the MPHFs, so it can be called from several threads,
+	// but the traverser of a shared indexer must not be used concurrently.
+	static std::shared_ptr<ActionSeqIndexer> loadShared(
+		uint8_t maxPlayers,
+		egn::chips ante,
+		egn::chips bigBlind,
+		egn::chips initialStake,
+		const betSizes_t& betSizes,
+		const std::string& indexerName);
+
+	// Return the shared indexer of indexerName if it is in use, or nullptr.
+	static std::shared_ptr<ActionSeqIndexer> findShared(const std::string& indexerName);
+
 	uint64_t index(egn::Round round, const seq_t& actionSeq);
 
 	mphf_t preflopMPHF, flopMPHF, turnMPHF, riverMPHF;
@@ -51,6 +69,9 @@ private:
 	void loadTurnMPHF();
 	void loadRiverMPHF();
 
+	static std::mutex sharedMutex;
+	static std::unordered_map<std::string, std::weak_ptr<ActionSeqIndexer>> sharedIndexers;
+
 	const int nThreads;
 	const double gamma;
 
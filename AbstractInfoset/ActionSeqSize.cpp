@@ -2,8 +2,16 @@
 
 namespace abc {
 
+// The sizes are taken from the shared indexer if it is in use.
 ActionSeqSize::ActionSeqSize(const std::string& indexerName)
 {
+	if (const std::shared_ptr<ActionSeqIndexer> indexer = ActionSeqIndexer::findShared(indexerName)) {
+		preflopSize = indexer->preflopMPHF.nbKeys();
+		flopSize = indexer->flopMPHF.nbKeys();
+		turnSize = indexer->turnMPHF.nbKeys();
+		riverSize = indexer->riverMPHF.nbKeys();
+		return;
+	}
 	auto file = opt::fstream(ActionSeqIndexer::getSizesPath(indexerName), std::ios::in | std::ios::binary);
 	opt::loadVar(preflopSize, file);
 	opt::loadVar(flopSize, file);
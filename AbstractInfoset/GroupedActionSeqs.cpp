@@ -17,9 +17,9 @@ void GroupedActionSeqs::build(
 	egn::chips initialStake,
 	const betSizes_t& betSizes)
 {
-	ActionSeqIndexer indexer(maxPlayers, ante, bigBlind, initialStake, betSizes, groupedActionSeqsName);
-
-	indexer.loadMPHF();
+	const std::shared_ptr<ActionSeqIndexer> sharedIndexer = ActionSeqIndexer::loadShared(
+		maxPlayers, ante, bigBlind, initialStake, betSizes, groupedActionSeqsName);
+	ActionSeqIndexer& indexer = *sharedIndexer;
 
 	// Allocate memory for seqs and lens.
 	seqs = {
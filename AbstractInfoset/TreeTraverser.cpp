@@ -1,6 +1,7 @@
 #include "TreeTraverser.h"
 #include "../Utils/FastVector.h"
 #include "../Utils/Hash.h"
+#include <iomanip>
 
 namespace abc {
 
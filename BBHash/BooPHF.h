@@ -15,10 +15,24 @@
 #include <assert.h>
 #include <string.h>
 #include <memory> // for make_shared
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <pthread.h>
 
 namespace boomphf {
+
+#ifndef _WIN32
+	// The GCC builtins doing what the Interlocked functions of Windows do.
+	template<typename T, typename V>
+	inline T InterlockedOr(volatile T* p, V v) { return __sync_fetch_and_or(p, (T)v); }
+
+	template<typename T, typename V>
+	inline T InterlockedAnd(volatile T* p, V v) { return __sync_fetch_and_and(p, (T)v); }
+
+	template<typename T>
+	inline T InterlockedIncrement(volatile T* p) { return __sync_add_and_fetch(p, (T)1); }
+#endif
 	
 	inline unsigned int popcount_32(unsigned int x)
 	{
@@ -433,6 +447,7 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 	};
 	
 	static inline uint64_t fastrange64(uint64_t word, uint64_t p) {
+#ifdef _WIN32
 		uint64_t highProduct;
 		_umul128(word, p, &highProduct); // ignore output
 		return highProduct;
@@ -441,6 +456,9 @@ we need this 2-functors scheme because HashFunctors won't work with unordered_ma
 			unsigned __int64 Multiplicand,
 			unsigned __int64* HighProduct
 		);
+#else
+		return (uint64_t)(((__uint128_t)word * p) >> 64);
+#endif
 	}
 	
 	class level{
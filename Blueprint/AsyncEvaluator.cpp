@@ -0,0 +1,77 @@
+#include "AsyncEvaluator.h"
+
+namespace bp {
+
+AsyncEvaluator::AsyncEvaluator(unsigned nThreads, double duration) :
+	nThreads(nThreads),
+	duration(duration),
+	pendingNSnapshots(0),
+	hasPending(false),
+	isBusy(false),
+	mustStop(false),
+	thread(&AsyncEvaluator::run, this)
+{
+}
+
+AsyncEvaluator::~AsyncEvaluator()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		mustStop = true;
+	}
+	cv.notify_all();
+	thread.join();
+}
+
+void AsyncEvaluator::submit(strats_t&& strat, uint64_t nSnapshots)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pendingStrat = std::move(strat);
+		pendingNSnapshots = nSnapshots;
+		hasPending = true;
+	}
+	cv.notify_all();
+}
+
+bool AsyncEvaluator::collect(std::vector<Result>& res)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (results.empty()) return false;
+	res.insert(res.end(), results.begin(), results.end());
+	results.clear();
+	return true;
+}
+
+void AsyncEvaluator::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	cv.wait(lock, [this] { return !hasPending && !isBusy; });
+}
+
+void AsyncEvaluator::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		cv.wait(lock, [this] { return hasPending || mustStop; });
+		if (mustStop) return;
+
+		const strats_t strat = std::move(pendingStrat);
+		const uint64_t nSnapshots = pendingNSnapshots;
+		hasPending = false;
+		isBusy = true;
+		lock.unlock();
+
+		double gainAvg = 0;
+		double gainStd = 0;
+		BlueprintAIEvaluator::evalBlueprintAI(
+			strat, gainAvg, gainStd, duration, nThreads, 0);
+
+		lock.lock();
+		results.push_back({ (float)gainAvg, (float)gainStd, nSnapshots });
+		isBusy = false;
+		cv.notify_all();
+	}
+}
+
+} // bp
\ No newline at end of file
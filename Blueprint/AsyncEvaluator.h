@@ -0,0 +1,61 @@
+#ifndef BP_ASYNCEVALUATOR_H
+#define BP_ASYNCEVALUATOR_H
+
+#include "EvalBlueprintAI.h"
+#include <mutex>
+#include <condition_variable>
+
+namespace bp {
+
+// Evaluate the strategies in a background thread while the training goes on.
+// A strategy submitted during an evaluation waits for it to finish,
+// replacing the older strategy waiting if any.
+class AsyncEvaluator
+{
+public:
+	struct Result
+	{
+		float gainAvg;
+		float gainStd;
+		uint64_t nSnapshots;
+	};
+
+	// Each evaluation uses nThreads threads during duration seconds.
+	AsyncEvaluator(unsigned nThreads, double duration);
+	~AsyncEvaluator();
+
+	AsyncEvaluator(const AsyncEvaluator&) = delete;
+	AsyncEvaluator& operator=(const AsyncEvaluator&) = delete;
+
+	// nSnapshots is the number of snapshots averaged into strat.
+	void submit(strats_t&& strat, uint64_t nSnapshots);
+
+	// Move the results of the finished evaluations to res.
+	// Return false if there was none.
+	bool collect(std::vector<Result>& res);
+
+	// Wait for the end of all the evaluations.
+	void wait();
+
+private:
+	void run();
+
+	const unsigned nThreads;
+	const double duration;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	strats_t pendingStrat;
+	uint64_t pendingNSnapshots;
+	bool hasPending;
+	bool isBusy;
+	bool mustStop;
+	std::vector<Result> results;
+
+	std::thread thread;
+
+}; // AsyncEvaluator
+
+} // bp
+
+#endif // BP_ASYNCEVALUATOR_H
\ No newline at end of file
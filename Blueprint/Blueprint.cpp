@@ -9,11 +9,40 @@ Blueprint::Blueprint(
 
 	bpGameName(blueprintGameName),
 	bpName(blueprintName(blueprintGameName, blueprintBuildName)),
-	rng{ (!rngSeed) ? std::random_device{}() : rngSeed }
+	extStrat(nullptr),
+	sampler(rngSeed)
 {
 }
 
 void Blueprint::loadStrat()
+{
+	if (!std::filesystem::exists(stratFilePath(bpName))) {
+		loadStratRounds();
+		return;
+	}
+	mapStratFile(stratFilePath(bpName));
+}
+
+void Blueprint::loadQuantizedStrat()
+{
+	mapStratFile(quantizedStratFilePath(bpName));
+}
+
+void Blueprint::loadPrunedStrat()
+{
+	mapStratFile(prunedStratFilePath(bpName));
+}
+
+void Blueprint::mapStratFile(const std::string& path)
+{
+	const abc::ActionSeqSize seqSizes(bpGameName);
+	stratFile.map(path, stratConfigHash(
+		bpGameName,
+		{ N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER },
+		{ seqSizes.preflopSize, seqSizes.flopSize, seqSizes.turnSize, seqSizes.riverSize }));
+}
+
+void Blueprint::loadStratRounds()
 {
 	const abc::ActionSeqSize seqSizes(bpGameName);
 
@@ -42,9 +71,38 @@ void Blueprint::loadRegrets()
 		std::vector<std::vector<regret_t>>(N_BCK_RIVER, std::vector<regret_t>(seqSizes.riverSize))
 	};
 
-	// Load the regrets from the checkpoint file.
-	auto file = opt::fstream(bp::checkpointPath(bpName), std::ios::in | std::ios::binary);
+	// Load the regrets from the checkpoint shards if any, or from the checkpoint file.
+	if (hasRegretShards(bpName)) {
+		for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+			loadRoundShards(regrets[r], bpName, r);
+		return;
+	}
+	opt::BinaryReader file(bp::checkpointPath(bpName));
 	opt::load3DVector(regrets, file);
+}
+
+void Blueprint::loadRoundRegrets(uint8_t roundId)
+{
+	const abc::ActionSeqSize seqSizes(bpGameName);
+	const std::array<size_t, egn::N_ROUNDS> nBcks = { N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER };
+	const std::array<size_t, egn::N_ROUNDS> nSeqs = {
+		seqSizes.preflopSize, seqSizes.flopSize, seqSizes.turnSize, seqSizes.riverSize };
+
+	// Allocate memory for the regrets of the round only.
+	regrets.assign(egn::N_ROUNDS, {});
+	regrets[roundId].assign(nBcks[roundId], std::vector<regret_t>(nSeqs[roundId]));
+
+	if (hasRegretShards(bpName)) {
+		loadRoundShards(regrets[roundId], bpName, roundId);
+		return;
+	}
+
+	// Skip the previous rounds in the checkpoint file.
+	size_t offset = 0;
+	for (uint8_t r = 0; r < roundId; ++r) offset += nBcks[r] * nSeqs[r] * sizeof(regret_t);
+	auto file = opt::fstream(bp::checkpointPath(bpName), std::ios::in | std::ios::binary);
+	file.seekg(offset);
+	opt::load2DVector(regrets[roundId], file);
 	file.close();
 }
 
@@ -2,6 +2,8 @@
 #define BP_BLUEPRINT_H
 
 #include "Constants.h"
+#include "RegretShards.h"
+#include "StratFile.h"
 #include "../AbstractInfoset/ActionSeqSize.h"
 #include <random>
 
@@ -9,28 +11,80 @@ namespace bp {
 
 typedef std::vector<std::vector<std::vector<strat_t>>> strats_t;
 
+class Blueprint;
+
+// Sampling state of one caller of a blueprint. The blueprint is not modified
+// when sampling actions, so one loaded blueprint can be shared by the callers
+// of all the threads, each one with its own sampler.
+class BlueprintSampler
+{
+public:
+	// Set rngSeed to 0 to set a random seed.
+	BlueprintSampler(unsigned rngSeed = 0) :
+		rng{ (!rngSeed) ? std::random_device{}() : rngSeed }
+	{
+	}
+
+	template<class Info>
+	uint8_t chooseAction(const Blueprint& blueprint, Info& abcInfo);
+
+private:
+	typedef omp::XoroShiro128Plus Rng;
+
+	template<class Info>
+	void calculateCumProbas(const Blueprint& blueprint, const Info& abcInfo);
+
+	Rng rng;
+	opt::FastRandomChoiceRNGRescale<16> actionRandChoice;
+	std::vector<strat_t> cumProbas;
+
+}; // BlueprintSampler
+
+// The strategy is only read once loaded, so a blueprint can be shared by
+// the threads sampling actions with their own BlueprintSampler.
 class Blueprint
 {
 public:
+	// rngSeed seeds the sampler used by chooseAction(abcInfo).
 	// Set rngSeed to 0 to set a random seed.
 	Blueprint(
 		const std::string& blueprintGameName,
 		const std::string& blueprintBuildName,
 		unsigned rngSeed = 0);
 
+	// Map the strategy file if there is one, so that the strategy is shared
+	// with the other processes. Otherwise, load each round in strat.
 	void loadStrat();
+	// Map the strategy file quantized to 4 bits, written by PackBlueprintStrat.
+	void loadQuantizedStrat();
+	// Map the strategy file without the rows rarely reached, written by PruneBlueprintStrat.
+	void loadPrunedStrat();
+	// Load each round in strat, e.g. to go through all of it.
+	void loadStratRounds();
+	// Use a strategy held by the caller, which must outlive the blueprint,
+	// instead of loading it. It can be shared by several blueprints.
+	void useStrat(const strats_t* sharedStrat) { extStrat = sharedStrat; }
 	void loadRegrets();
+	// Only allocate and load the regrets of round roundId.
+	void loadRoundRegrets(uint8_t roundId);
+
+	strat_t getProba(uint8_t roundId, size_t bckIdx, uint64_t actionSeqIdx) const
+	{
+		if (extStrat) return (*extStrat)[roundId][bckIdx][actionSeqIdx];
+		if (stratFile.isMapped()) return stratFile.proba(roundId, bckIdx, actionSeqIdx);
+		return strat[roundId][bckIdx][actionSeqIdx];
+	}
 
 	template<class Info>
 	strat_t getProbaWithSeq(const Info& abcInfo, uint64_t actionSeqIdx) const
 	{
-		return strat[abcInfo.roundIdx()][abcInfo.handIdx()][actionSeqIdx];
+		return getProba(abcInfo.roundIdx(), abcInfo.handIdx(), actionSeqIdx);
 	}
 
 	template<class Info>
 	strat_t getProba(const Info& abcInfo, uint8_t actionId) const
 	{
-		return strat[abcInfo.roundIdx()][abcInfo.handIdx()][abcInfo.actionSeqIds[actionId]];
+		return getProba(abcInfo.roundIdx(), abcInfo.handIdx(), abcInfo.actionSeqIds[actionId]);
 	}
 
 	template<class Info>
@@ -41,93 +95,189 @@ public:
 
 	template<class Info>
 	std::vector<uint8_t> calculateProbasPerc(const Info& abcInfo) const
+	{
+		std::vector<uint8_t> probas(abcInfo.nActions());
+		calculateProbasPerc(abcInfo, probas.data());
+		return probas;
+	}
+
+	// Same writing the abcInfo.nActions() probas in probas, without allocating.
+	template<class Info>
+	void calculateProbasPerc(const Info& abcInfo, uint8_t probas[]) const
 	{
 		// We apply the following weird procedure so that the sum of
 		// the probas will be exactly equal to 100, getting around
 		// rounding issues.
-		std::vector<uint8_t> probas(abcInfo.nActions());
+		const uint8_t nActions = abcInfo.nActions();
 		probas[0] = getProba(abcInfo, 0);
-		for (uint8_t a = 1; a < probas.size(); ++a)
+		for (uint8_t a = 1; a < nActions; ++a)
 			probas[a] = probas[a - 1] + getProba(abcInfo, a);
-		for (uint8_t a = 0; a < probas.size(); ++a)
-			probas[a] = (uint8_t)std::round(100.0 * probas[a] / probas.back());
-		for (uint8_t a = (uint8_t)probas.size() - 1; a > 0; --a)
+		for (uint8_t a = 0; a < nActions; ++a)
+			probas[a] = (uint8_t)std::round(100.0 * probas[a] / probas[nActions - 1]);
+		for (uint8_t a = nActions - 1; a > 0; --a)
 			probas[a] -= probas[a - 1];
-		return probas;
 	}
 
+	// Probabilities of the legal actions of the infoset of abcInfo for all the
+	// hands that its acting player can hold: probas[h * abcInfo.nActions() + a]
+	// for the hand h of abc::rangeHands. The strategy is read once per distinct
+	// bucket. The rows of the hands holding a card of deadCards (bit 1 << card)
+	// or of the board are 0. The action sequences of abcInfo must be up to date.
+	template<class Info>
+	void calculateRangeProbas(Info& abcInfo, uint64_t deadCards, std::vector<float>& probas) const;
+
+	// Legal action closest to the average bet of the strategy of the hand bucket
+	// bckIdx over all the actions, including the unavailable raises, played when
+	// the probas of the legal actions are all 0 (see BlueprintSampler::chooseAction).
+	template<class Info>
+	uint8_t closestLegalAction(Info& abcInfo, size_t bckIdx) const;
+
+	// Use the sampler of the blueprint, for the callers owning it.
 	template<class Info>
 	uint8_t chooseAction(Info& abcInfo)
 	{
-		calculateCumProbas(abcInfo);
-
-		// The sum of probas of legal actions can be null if no legal regular
-		// raise is available while all the weight was on the raises.
-		// It can happen if the pot amount is so big that the allinSize becomes
-		// small. In this case, we return the closest legal action to the average
-		// bet calculated from all the actions including the unavailable raises.
-		if (cumProbas.back() == 0) {
-
-			// Calculate the blueprint's average bet weighted by the
-			// probas of each action.
-			float sumBets = 0;
-			uint8_t sum = 0;
-			std::vector<uint8_t> actions;
-			std::vector<uint64_t> actionSeqIds;
-			abcInfo.calculateAllActionSeqIds(actions, actionSeqIds);
-			for (uint8_t i = 0; i < actions.size(); ++i) {
-				const uint8_t p = getProbaWithSeq(abcInfo, actionSeqIds[i]);
-				const egn::chips bet = abcInfo.actionToBet(actions[i]);
-				sumBets += (float)p * bet;
-				sum += p;
-			}
-			// Sanity check.
-			//if (sum != sumStrat)
-			//	throw std::runtime_error("The sum of probas is not 1.");
-			const egn::chips avgBet = (egn::chips)std::round(sumBets / sum);
-
-			// Find the closest legal action to avgBet.
-			uint8_t closestActionId = 0;
-			egn::dchips minDiff = (std::numeric_limits<egn::dchips>::max)();
-			for (uint8_t i = 0; i < abcInfo.nActions(); ++i) {
-				const egn::chips bet = abcInfo.actionToBet(abcInfo.actionAbc.legalActions[i]);
-				const egn::dchips diff = std::abs((egn::dchips)bet - (egn::dchips)avgBet);
-				if (diff < minDiff) {
-					closestActionId = i;
-					minDiff = diff;
-				}
-			}
-
-			return closestActionId;
-		}
-
-		return (uint8_t)actionRandChoice(cumProbas, rng);
+		return sampler.chooseAction(*this, abcInfo);
 	}
 
 	strats_t strat;
 	regrets_t regrets;
 
 private:
-	typedef omp::XoroShiro128Plus Rng;
+	friend class BlueprintSampler;
 
-	template<class Info>
-	void calculateCumProbas(const Info& abcInfo)
-	{
-		cumProbas.resize(abcInfo.nActions());
-		cumProbas[0] = getProba(abcInfo, 0);
-		for (uint8_t a = 1; a < cumProbas.size(); ++a)
-			cumProbas[a] = cumProbas[a - 1] + getProba(abcInfo, a);
-	}
+	void mapStratFile(const std::string& path);
 
 	const std::string bpGameName;
 	const std::string bpName;
 
-	Rng rng;
-	opt::FastRandomChoiceRNGRescale<16> actionRandChoice;
-	std::vector<strat_t> cumProbas;
+	const strats_t* extStrat;
+	StratFile stratFile;
+
+	BlueprintSampler sampler;
 
 }; // Blueprint
 
+template<class Info>
+uint8_t BlueprintSampler::chooseAction(const Blueprint& blueprint, Info& abcInfo)
+{
+	// The cumulated probabilities of the strategy file can be used
+	// when all the actions of the infoset are legal.
+	if (blueprint.stratFile.isMapped() && blueprint.stratFile.encoding() == STRAT_U8 && !blueprint.extStrat) {
+		const uint8_t r = abcInfo.roundIdx();
+		const uint64_t seqIdx = abcInfo.actionSeqIds[0];
+		if (blueprint.stratFile.infosetLen(r, seqIdx) == abcInfo.nActions()) {
+			const strat_t* cumStrat =
+				blueprint.stratFile.cumRow(r, abcInfo.handIdx()) + blueprint.stratFile.infosetPos(r, seqIdx);
+			return (uint8_t)actionRandChoice(std::span(cumStrat, abcInfo.nActions()), rng);
+		}
+	}
+
+	calculateCumProbas(blueprint, abcInfo);
+
+	// The sum of probas of legal actions can be null if no legal regular
+	// raise is available while all the weight was on the raises.
+	// It can happen if the pot amount is so big that the allinSize becomes
+	// small. In this case, we return the closest legal action to the average
+	// bet calculated from all the actions including the unavailable raises.
+	if (cumProbas.back() == 0)
+		return blueprint.closestLegalAction(abcInfo, abcInfo.handIdx());
+
+	return (uint8_t)actionRandChoice(cumProbas, rng);
+}
+
+template<class Info>
+void Blueprint::calculateRangeProbas(Info& abcInfo, uint64_t deadCards, std::vector<float>& probas) const
+{
+	typedef decltype(abcInfo.handIdx()) bck_t;
+
+	const uint8_t r = abcInfo.roundIdx();
+	const uint8_t nActions = abcInfo.nActions();
+	std::array<bck_t, omp::COMBO_COUNT> bcks;
+	std::array<uint8_t, omp::COMBO_COUNT> live;
+	abcInfo.calculateRangeHandsIds(deadCards, bcks, live);
+
+	// Many hands share a bucket, so the probabilities are
+	// calculated for the distinct buckets of the live hands.
+	std::vector<bck_t> distinctBcks;
+	distinctBcks.reserve(omp::COMBO_COUNT);
+	for (uint16_t h = 0; h < omp::COMBO_COUNT; ++h) {
+		if (live[h]) distinctBcks.push_back(bcks[h]);
+	}
+	std::sort(distinctBcks.begin(), distinctBcks.end());
+	distinctBcks.erase(std::unique(distinctBcks.begin(), distinctBcks.end()), distinctBcks.end());
+
+	std::vector<float> bckProbas(distinctBcks.size() * nActions, 0);
+	for (size_t k = 0; k < distinctBcks.size(); ++k) {
+		float* p = bckProbas.data() + k * nActions;
+		sumStrat_t sum = 0;
+		for (uint8_t a = 0; a < nActions; ++a) {
+			const strat_t proba = getProba(r, distinctBcks[k], abcInfo.actionSeqIds[a]);
+			p[a] = proba;
+			sum += proba;
+		}
+		if (sum) {
+			for (uint8_t a = 0; a < nActions; ++a) p[a] /= sum;
+		}
+		else {
+			std::fill(p, p + nActions, 0.0f);
+			p[closestLegalAction(abcInfo, distinctBcks[k])] = 1;
+		}
+	}
+
+	probas.assign(omp::COMBO_COUNT * nActions, 0);
+	for (uint16_t h = 0; h < omp::COMBO_COUNT; ++h) {
+		if (!live[h]) continue;
+		const size_t k = std::lower_bound(distinctBcks.begin(), distinctBcks.end(), bcks[h]) - distinctBcks.begin();
+		std::copy_n(bckProbas.data() + k * nActions, nActions, probas.data() + h * nActions);
+	}
+}
+
+template<class Info>
+uint8_t Blueprint::closestLegalAction(Info& abcInfo, size_t bckIdx) const
+{
+	// Calculate the blueprint's average bet weighted by the
+	// probas of each action.
+	const uint8_t r = abcInfo.roundIdx();
+	float sumBets = 0;
+	uint8_t sum = 0;
+	std::vector<uint8_t> actions;
+	std::vector<uint64_t> actionSeqIds;
+	abcInfo.calculateAllActionSeqIds(actions, actionSeqIds);
+	for (uint8_t i = 0; i < actions.size(); ++i) {
+		const uint8_t p = getProba(r, bckIdx, actionSeqIds[i]);
+		const egn::chips bet = abcInfo.actionToBet(actions[i]);
+		sumBets += (float)p * bet;
+		sum += p;
+	}
+	// Sanity check.
+	//if (sum != sumStrat)
+	//	throw std::runtime_error("The sum of probas is not 1.");
+	const egn::chips avgBet = (egn::chips)std::round(sumBets / sum);
+
+	// Find the closest legal action to avgBet.
+	uint8_t closestActionId = 0;
+	egn::dchips minDiff = (std::numeric_limits<egn::dchips>::max)();
+	for (uint8_t i = 0; i < abcInfo.nActions(); ++i) {
+		const egn::chips bet = abcInfo.actionToBet(abcInfo.actionAbc.legalActions[i]);
+		const egn::dchips diff = std::abs((egn::dchips)bet - (egn::dchips)avgBet);
+		if (diff < minDiff) {
+			closestActionId = i;
+			minDiff = diff;
+		}
+	}
+
+	return closestActionId;
+}
+
+template<class Info>
+void BlueprintSampler::calculateCumProbas(const Blueprint& blueprint, const Info& abcInfo)
+{
+	cumProbas.resize(abcInfo.nActions());
+	cumProbas[0] = blueprint.getProba(abcInfo, 0);
+	for (uint8_t a = 1; a < cumProbas.size(); ++a)
+		cumProbas[a] = cumProbas[a - 1] + blueprint.getProba(abcInfo, a);
+}
+
 } // bp
 
 #endif // BP_BLUEPRINT_H
\ No newline at end of file
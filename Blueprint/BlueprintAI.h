@@ -38,7 +38,7 @@ public:
 		const abc::betSizes_t& betSizes,
 		const std::string& blueprintGameName,
 		egn::chips realBigBlind,
-		Blueprint* blueprint,
+		const Blueprint* blueprint,
 		unsigned rngSeed = 0) :
 
 		abcInfo(
@@ -52,7 +52,8 @@ public:
 
 		blueprint(blueprint),
 
-		rng{ (!rngSeed) ? std::random_device{}() : rngSeed }
+		rng{ (!rngSeed) ? std::random_device{}() : rngSeed },
+		sampler((unsigned)rng())
 	{
 		setBB(realBigBlind);
 	}
@@ -106,7 +107,7 @@ public:
 		// Choose an action.
 		abcInfo.updateStateIds();
 		const uint8_t a = abcInfo.actionAbc.legalActions[
-			blueprint->chooseAction(abcInfo)];
+			sampler.chooseAction(*blueprint, abcInfo)];
 		abcInfo.setStateAction(a);
 
 		// Set state's action.
@@ -236,8 +237,10 @@ public:
 
 private:
 
-	Blueprint* blueprint;
+	// The blueprint can be shared by the AIs of several threads.
+	const Blueprint* blueprint;
 	abc::ActionAbstraction::Rng rng;
+	BlueprintSampler sampler;
 
 	float realOverAbcBB;
 
@@ -2,19 +2,38 @@
 
 namespace bp {
 
-BlueprintAIAdvisor::BlueprintAIAdvisor(unsigned rngSeed) :
-	blueprint(
+std::unique_ptr<Blueprint> BlueprintAIAdvisor::loadBlueprint()
+{
+	auto blueprint = std::make_unique<Blueprint>(
 		bp::BP_GAME_NAMESPACE::BLUEPRINT_GAME_NAME,
-		bp::BP_BUILD_NAMESPACE::BLUEPRINT_BUILD_NAME,
-		rngSeed),
+		bp::BP_BUILD_NAMESPACE::BLUEPRINT_BUILD_NAME);
+	if (prunedStrat) blueprint->loadPrunedStrat();
+	else if (quantizedStrat) blueprint->loadQuantizedStrat();
+	else blueprint->loadStrat();
+	return blueprint;
+}
+
+BlueprintAIAdvisor::BlueprintAIAdvisor(unsigned rngSeed) :
+	ownedBlueprint(loadBlueprint()),
+	blueprint(ownedBlueprint.get()),
 
 	blueprintAI(BLUEPRINT_AI_BUILDER(
 		bp::BP_GAME_NAMESPACE,
 		bp::BIG_BLIND,
-		&blueprint,
+		blueprint,
+		rngSeed))
+{
+}
+
+BlueprintAIAdvisor::BlueprintAIAdvisor(const Blueprint* sharedBlueprint, unsigned rngSeed) :
+	blueprint(sharedBlueprint),
+
+	blueprintAI(BLUEPRINT_AI_BUILDER(
+		bp::BP_GAME_NAMESPACE,
+		bp::BIG_BLIND,
+		blueprint,
 		rngSeed))
 {
-	blueprint.loadStrat();
 }
 
 void BlueprintAIAdvisor::startNewHand(
@@ -38,6 +57,32 @@ void BlueprintAIAdvisor::startNewHand(
 	blueprintAI.reset(state);
 }
 
+void BlueprintAIAdvisor::startNewHand(
+	egn::chips ante, egn::chips bb,
+	const egn::chips stakes[],
+	uint8_t dealer,
+	uint8_t myPosition,
+	const uint8_t myHand[],
+	const uint8_t boardCards[],
+	uint8_t nBoardCards)
+{
+	state.setAnte(ante);
+	state.setBigBlind(bb);
+
+	for (uint8_t i = 0; i < bp::MAX_PLAYERS; ++i)
+		state.stakes[i] = stakes[i];
+
+	currBoardCards = "";
+	state.setHoleCards(myPosition, myHand);
+	// The board is given to blueprintAI when it is reset.
+	for (uint8_t i = 0; i < nBoardCards; ++i)
+		state.boardCards[i] = boardCards[i];
+
+	state.startNewHand(dealer, false);
+
+	blueprintAI.reset(state);
+}
+
 void BlueprintAIAdvisor::updateBoardCards(const char* newCards)
 {
 	currBoardCards += std::string(newCards);
@@ -60,13 +105,85 @@ void BlueprintAIAdvisor::getAdvices()
 {
 	blueprintAI.act(state, aiAction, aiBet);
 
-	nActions = blueprintAI.abcInfo.nActions();
+	blueprint->calculateProbasPerc(blueprintAI.abcInfo, probas);
 
-	const std::vector<uint8_t> probasVect =
-		blueprint.calculateProbasPerc(blueprintAI.abcInfo);
-	std::copy(probasVect.begin(), probasVect.end(), probas);
+	setActions();
+}
+
+AdviceStatus BlueprintAIAdvisor::adviseSpot(
+	egn::chips ante, egn::chips bb,
+	const egn::chips stakes[],
+	uint8_t dealer,
+	uint8_t myPosition,
+	const uint8_t myHand[],
+	const uint8_t boardCards[],
+	uint8_t nBoardCards,
+	const uint8_t historyActions[],
+	const egn::chips historyBets[],
+	uint32_t nHistory)
+{
+	static const uint8_t nRoundBoardCards[egn::N_ROUNDS] = { 0, 3, 4, 5 };
+
+	if (dealer >= MAX_PLAYERS || myPosition >= MAX_PLAYERS || nBoardCards > omp::BOARD_CARDS)
+		return ADVICE_INVALID;
+	// The seats without chips are empty, but the advised player must have some.
+	if (!bb || !stakes[myPosition] || std::count_if(stakes, stakes + MAX_PLAYERS, [](egn::chips s) { return s != 0; }) < 2)
+		return ADVICE_INVALID;
+	// The cards index the lookup tables, so they must be valid and distinct.
+	uint64_t usedCards = 0;
+	for (uint8_t i = 0; i < omp::HOLE_CARDS + nBoardCards; ++i) {
+		const uint8_t c = (i < omp::HOLE_CARDS) ? myHand[i] : boardCards[i - omp::HOLE_CARDS];
+		if (c >= omp::CARD_COUNT || (usedCards >> c & 1)) return ADVICE_INVALID;
+		usedCards |= 1ull << c;
+	}
+	for (uint32_t i = 0; i < nHistory; ++i) {
+		if (historyActions[i] >= egn::N_ACTIONS) return ADVICE_INVALID;
+	}
+
+	try {
+		startNewHand(ante, bb, stakes, dealer, myPosition, myHand, boardCards, nBoardCards);
+		for (uint32_t i = 0; i < nHistory && !state.finished; ++i) {
+			// An illegal action or bet would corrupt the chips of the state.
+			if (!isLegal(historyActions[i], historyBets[i])) return ADVICE_INVALID;
+			update(historyActions[i], historyBets[i]);
+		}
+		if (state.finished || state.actingPlayer != myPosition)
+			return ADVICE_NOT_ACTING;
+		if (nBoardCards < nRoundBoardCards[state.round])
+			return ADVICE_INVALID;
+		getAdvices();
+	}
+	catch (const std::exception&) {
+		return ADVICE_ERROR;
+	}
+	return ADVICE_OK;
+}
+
+bool BlueprintAIAdvisor::isLegal(uint8_t action, egn::chips bet) const
+{
+	if (std::find(state.actions.begin(), state.actions.begin() + state.nActions, egn::Action(action))
+		== state.actions.begin() + state.nActions)
+		return false;
+	return action != egn::RAISE || bet == state.allin || (bet >= state.minRaise && bet <= state.allin);
+}
+
+void BlueprintAIAdvisor::getRangeAdvices(uint64_t deadCards, std::vector<float>& rangeProbas)
+{
+	// See BlueprintAI::act.
+	if (!blueprintAI.abcInfo.state.isActing(state.actingPlayer))
+		throw std::runtime_error("The acting player is all-in in the abstract game.");
+
+	blueprintAI.abcInfo.calculateActionSeqIds();
+	blueprint->calculateRangeProbas(blueprintAI.abcInfo, deadCards, rangeProbas);
+
+	setActions();
+}
+
+void BlueprintAIAdvisor::setActions()
+{
+	nActions = blueprintAI.abcInfo.nActions();
 
-	const std::vector<uint8_t> actionsVect =
+	const std::vector<uint8_t>& actionsVect =
 		blueprintAI.abcInfo.actionAbc.legalActions;
 	std::copy(actionsVect.begin(), actionsVect.end(), actions);
 
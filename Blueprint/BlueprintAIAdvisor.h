@@ -3,6 +3,7 @@
 
 #include "BlueprintAI.h"
 #include "../UserPlayer/UserPlayer.h"
+#include <memory>
 
 namespace bp {
 
@@ -10,19 +11,70 @@ typedef bp::BlueprintAI<bp::bckSize_t,
 	bp::N_BCK_PREFLOP, bp::N_BCK_FLOP,
 	bp::N_BCK_TURN, bp::N_BCK_RIVER> blueprintAI_t;
 
+enum AdviceStatus : uint8_t
+{
+	ADVICE_OK,
+	// An argument is out of its range.
+	ADVICE_INVALID,
+	// The hand is finished or the advised player is not acting after the history.
+	ADVICE_NOT_ACTING,
+	// The history could not be replayed.
+	ADVICE_ERROR
+};
+
 class BlueprintAIAdvisor
 {
 public:
+	// Load the blueprint chosen by the constants,
+	// e.g. to share it between the advisors of several threads.
+	static std::unique_ptr<Blueprint> loadBlueprint();
+
+	// Load its own blueprint.
 	BlueprintAIAdvisor(unsigned rngSeed = 0);
+	// Use a blueprint loaded by the caller, which must outlive the advisor.
+	BlueprintAIAdvisor(const Blueprint* sharedBlueprint, unsigned rngSeed = 0);
+
 	void startNewHand(
 		egn::chips ante, egn::chips bb,
 		const egn::chips stakes[],
 		uint8_t dealer,
 		uint8_t myPosition,
 		const char* myHand);
+	// Same with the cards given by their indices, and the nBoardCards board
+	// cards already known, e.g. to be advised at any point of a hand.
+	void startNewHand(
+		egn::chips ante, egn::chips bb,
+		const egn::chips stakes[],
+		uint8_t dealer,
+		uint8_t myPosition,
+		const uint8_t myHand[],
+		const uint8_t boardCards[],
+		uint8_t nBoardCards);
 	void updateBoardCards(const char* newCards);
 	void update(int action, egn::chips bet);
 	void getAdvices();
+	// Start a new hand with the nBoardCards known board cards, replay its nHistory
+	// actions (egn::Action) since the blinds with their bets (only read for the
+	// raises), and get the advices of myPosition, who must then be acting.
+	// The board must hold at least the cards of the round reached.
+	// The history must be legal: each action among those of the state and each
+	// raise between minRaise and allin. Seats without chips are empty.
+	// Return the status instead of throwing an exception, e.g. for a server.
+	AdviceStatus adviseSpot(
+		egn::chips ante, egn::chips bb,
+		const egn::chips stakes[],
+		uint8_t dealer,
+		uint8_t myPosition,
+		const uint8_t myHand[],
+		const uint8_t boardCards[],
+		uint8_t nBoardCards,
+		const uint8_t historyActions[],
+		const egn::chips historyBets[],
+		uint32_t nHistory);
+	// Probabilities of the actions of getAdvices for all the hands that the acting
+	// player can hold, in rangeProbas[h * nActions + a] for the hand h of abc::rangeHands
+	// (see Blueprint::calculateRangeProbas). aiAction and aiBet are not set.
+	void getRangeAdvices(uint64_t deadCards, std::vector<float>& rangeProbas);
 
 	egn::GameState state;
 
@@ -35,9 +87,15 @@ public:
 	egn::chips bets[maxNAbcActions];
 
 private:
+	// Set nActions, actions and bets for the legal actions of blueprintAI.
+	void setActions();
+	// Whether the action, with its bet for a raise, is legal in state.
+	bool isLegal(uint8_t action, egn::chips bet) const;
+
 	std::string currBoardCards;
 
-	Blueprint blueprint;
+	std::unique_ptr<Blueprint> ownedBlueprint;
+	const Blueprint* blueprint;
 	blueprintAI_t blueprintAI;
 
 }; // BlueprintAIAdvisor
@@ -4,14 +4,17 @@ namespace bp {
 
 const std::string BlueprintCalculator::printSep(20, '_');
 
-opt::FastRandomChoice<8> BlueprintCalculator::pruneRandChoice;
-opt::FastRandomChoiceRNGRescale<16> BlueprintCalculator::actionRandChoice;
 const opt::FastRandomChoice<> BlueprintCalculator::cumWeightsRescaler;
 
-BlueprintCalculator::BlueprintCalculator(unsigned rngSeed, bool verbose) :
+BlueprintCalculator::BlueprintCalculator(
+	unsigned rngSeed, bool verbose,
+	bool saveMetrics, unsigned workerId) :
 
-	rng{ (!rngSeed) ? std::random_device{}() : rngSeed },
+	pinned(pinProcess(workerId)),
+	rng{ (!rngSeed) ? std::random_device{}() : workerSeed(rngSeed, workerId) },
 	verbose(verbose),
+	saveMetrics(saveMetrics),
+	workerId(workerId),
 	pruneCumWeights(buildPruneCumWeights()),
 
 	abcInfo(
@@ -21,8 +24,9 @@ BlueprintCalculator::BlueprintCalculator(unsigned rngSeed, bool verbose) :
 		INITIAL_STAKE,
 		BET_SIZES,
 		BLUEPRINT_GAME_NAME,
-		rngSeed),
+		workerSeed(rngSeed, workerId)),
 
+	preflopStratSum(nullptr),
 	gpSeqs(BLUEPRINT_GAME_NAME),
 	gpSeqsInv(BLUEPRINT_GAME_NAME),
 
@@ -31,70 +35,231 @@ BlueprintCalculator::BlueprintCalculator(unsigned rngSeed, bool verbose) :
 	nextSnapshotId(1),
 	lastCheckpointIter(0),
 
+	mappedCkpt(checkpointRegretsPath(), checkpointStatePath(), checkpointJournalPath()),
+
+	ctrl(nullptr),
+	flushedNodesCount(0),
+	flushedNodesUniqueCount(0),
+
 	nodesCount(0),
 	nodesUniqueCount(0),
-	totUniqueNodes(getNUniqueNodes())
+	totUniqueNodes(getNUniqueNodes()),
+
+	roundNodesCount{},
+	prunedSubtrees{},
+	exploredSubtrees{},
+	exploredSubtreeNodes{},
+	nPrunedIters(0),
+	lastMetricsIter(0),
+	lastMetricsDuration(0),
+	snapshotDuration(0),
+	avgSnapshotsDuration(0),
+	evalDuration(0),
+	checkpointDuration(0),
+	newEval(false),
+	vrRawSqErr(0),
+	vrCvSqErr(0)
 {
-	// Allocate memory for the regrets.
-	regrets = {
-		std::vector<std::vector<regret_t>>(N_BCK_PREFLOP, std::vector<regret_t>(abcInfo.nActionSeqs(egn::PREFLOP))),
-		std::vector<std::vector<regret_t>>(N_BCK_FLOP, std::vector<regret_t>(abcInfo.nActionSeqs(egn::FLOP))),
-		std::vector<std::vector<regret_t>>(N_BCK_TURN, std::vector<regret_t>(abcInfo.nActionSeqs(egn::TURN))),
-		std::vector<std::vector<regret_t>>(N_BCK_RIVER, std::vector<regret_t>(abcInfo.nActionSeqs(egn::RIVER)))
-	};
+	if (workerId >= nTrainProcesses)
+		throw std::runtime_error("Worker id greater than the number of processes.");
+	if (sparseRegretsThreshold != 0 && (nTrainProcesses > 1 || regretsOnDisk))
+		throw std::runtime_error("Sparse regrets need a single process with the regrets in RAM.");
+	if (mappedCheckpoint && (nTrainProcesses > 1 || regretsOnDisk || sparseRegretsThreshold != 0))
+		throw std::runtime_error("A mapped checkpoint needs a single process with dense regrets in RAM.");
+	if (compressedCheckpoint && (mappedCheckpoint || sparseRegretsThreshold != 0))
+		throw std::runtime_error("A compressed checkpoint needs dense regrets not mapped from the checkpoint.");
 
+	// Allocate memory for the regrets.
+	regrets.setLayout(
+		{ N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER },
+		{
+			abcInfo.nActionSeqs(egn::PREFLOP),
+			abcInfo.nActionSeqs(egn::FLOP),
+			abcInfo.nActionSeqs(egn::TURN),
+			abcInfo.nActionSeqs(egn::RIVER)
+		});
 	gpSeqs.load();
 	gpSeqsInv.load();
+	// The masks are shared like the regrets, so they must be known before attaching them.
+	regrets.setPruneMasks(gpSeqs.seqs, gpSeqs.lens, pruneThreshold);
+	ownedPreflopStratSum.assign(preflopStratSize(), 0);
+	preflopStratSum = ownedPreflopStratSum.data();
+	if (isLeader()) {
+		// Create save folders.
+		std::filesystem::create_directory(blueprintDir());
+		std::filesystem::create_directory(blueprintTmpDir());
+	}
+	bool hasMappedState = false;
+	if (nTrainProcesses > 1) attachSharedRegrets();
+	else if (regretsOnDisk) regrets.mapFile(regretsPath(), nHotRegretRounds);
+	else if (mappedCheckpoint) {
+		hasMappedState = mappedCkpt.recover(regrets, checkpointPath());
+		mappedCkpt.map(regrets);
+	}
+	// Sparse regrets are allocated when loaded, with only their dense columns.
+	else if (sparseRegretsThreshold == 0) regrets.allocate();
+	regrets.setSparseThreshold(sparseRegretsThreshold);
+	if (isLeader() && regrets.isAllocated()) regrets.place(regretsNumaPolicy);
+	setDiscountFactors();
+	for (uint8_t r = 0; r < vrBaselineRounds; ++r)
+		baselines[r].assign(regrets.nBcks(r) * regrets.rowSize(r), 0);
+
+	if (isLeader()) {
+		// If a checkpoint file is found, resume from it.
+		// A classic checkpoint is also read when compressedCheckpoint is true
+		// and no shard was written yet, and is converted at the next save.
+		const bool hasShards = compressedCheckpoint && hasRegretShards(blueprintName());
+		auto checkpointFile = std::fstream(
+			(mappedCheckpoint || hasShards) ? checkpointStatePath() : checkpointPath(),
+			std::ios::in | std::ios::binary);
+		if (mappedCheckpoint && hasMappedState != (bool)checkpointFile)
+			throw std::runtime_error("The state of the mapped checkpoint could not be read.");
+		if (checkpointFile) {
+			// Verify that the constants are the same as the ones used in the checkpoint.
+			verifyConstants();
+			// The regrets of a mapped checkpoint are already there.
+			if (mappedCheckpoint) loadState(checkpointFile);
+			else if (hasShards) {
+				ShardsHeader header;
+				header.load(checkpointFile);
+				loadRegretShards(regrets, blueprintName(), header);
+				loadState(checkpointFile);
+			}
+			else loadCheckpoint(checkpointFile);
+			if (preflopStratPeriod) loadPreflopStratSum();
+		}
+		// Otherwise, start from the regrets of a coarser blueprint if WarmStartBlueprint wrote them.
+		else if (std::filesystem::exists(warmStartPath())) {
+			auto warmStartFile = opt::fstream(warmStartPath(), std::ios::in | std::ios::binary);
+			regrets.load(warmStartFile);
+			warmStartFile.close();
+			// A mapped checkpoint must write all of them at its first commit.
+			regrets.markAllDirty();
+		}
+		checkpointFile.close();
+		if (sparseRegretsThreshold != 0) {
+			// Without regrets to load, the table starts dense.
+			if (!regrets.isAllocated()) regrets.allocate();
+			regrets.place(regretsNumaPolicy);
+		}
+		// The regrets are saved and loaded fully discounted.
+		regrets.resetEpochs(discountEpoch(currIter));
+		if (nextSnapshotId > 1 && !std::filesystem::exists(snapshotPath(1, egn::RIVER)))
+			throw std::runtime_error("The snapshots were not taken with the same compressedSnapshots.");
+		writeConstants();
 
-	// Create save folders.
-	std::filesystem::create_directory(blueprintDir());
-	std::filesystem::create_directory(blueprintTmpDir());
-
-	// If a checkpoint file is found, resume from it.
-	auto checkpointFile = std::fstream(checkpointPath(), std::ios::in | std::ios::binary);
-	if (checkpointFile) {
-		// Verify that the constants are the same as the ones used in the checkpoint.
-		verifyConstants();
-		loadCheckpoint(checkpointFile);
+		if (nTrainProcesses > 1) publishSharedState();
 	}
-	checkpointFile.close();
-	writeConstants();
+	else waitSharedState();
+
+	startTime = opt::getTime();
+	lastMetricsIter = currIter;
+	lastMetricsDuration = extraDuration;
+	if (saveMetrics && isLeader()) metricsWriter.open(metricsPath());
+	if (nEvalThreads && isLeader())
+		evaluator = std::make_unique<AsyncEvaluator>(nEvalThreads, evalStratDuration);
 }
 
 void BlueprintCalculator::buildStrategy()
 {
 	startTime = opt::getTime();
-	while (currIter < endIter) oneIter();
+	if (nTrainProcesses == 1) {
+		while (currIter < endIter) oneIter();
+	}
+	else buildStrategyShared();
+	if (!isLeader()) return;
+	// Print the last evaluations. They are not in the checkpoint of endIter,
+	// which is not written again for them.
+	if (evaluator) {
+		evaluator->wait();
+		collectEvaluations();
+	}
 	printFinalStats();
 }
 
 void BlueprintCalculator::oneIter()
+{
+	traverseIter();
+	if (mustDiscount(currIter)) applyDiscounting();
+	++currIter;
+	runPeriodicTasks();
+}
+
+// Do the traversals of the iteration currIter for all players.
+void BlueprintCalculator::traverseIter()
 {
 	bool mustPrune = currIter >= pruneBeginIter && pruneRandChoice(pruneCumWeights, rng) == 0;
+	if (mustPrune) ++nPrunedIters;
 
 	for (uint8_t traverser = 0; traverser < MAX_PLAYERS; ++traverser) {
 		if (mustPrune) traverseMCCFRP(traverser);
 		else traverseMCCFR(traverser);
 	}
 
-	if (currIter && currIter < discountEndIter && currIter % discountPeriod == 0)
-		applyDiscounting();
+	if (preflopStratPeriod && currIter % preflopStratPeriod == 0) {
+		for (uint8_t traverser = 0; traverser < MAX_PLAYERS; ++traverser)
+			updatePreflopStrat(traverser);
+	}
+}
 
-	++currIter;
+// Return whether the regrets must be discounted after the traversals of iteration iter.
+bool BlueprintCalculator::mustDiscount(uint64_t iter)
+{
+	return iter && iter < discountStopIter && iter % discountPeriod == 0;
+}
+
+// Return the number of discountings done once n iterations are done.
+uint32_t BlueprintCalculator::discountEpoch(uint64_t n)
+{
+	if (n == 0 || discountStopIter == 0) return 0;
+	return (uint32_t)((std::min)(n - 1, discountStopIter - 1) / discountPeriod);
+}
+
+// Give the regrets the factors of all the discountings of the training.
+void BlueprintCalculator::setDiscountFactors()
+{
+	const uint32_t nEpochs = discountEpoch(endIter + 1) + 1;
+	std::vector<double> posFactors(nEpochs, 1), negFactors(nEpochs, 1);
+	for (uint32_t k = 1; k < nEpochs; ++k) {
+		if (discountMode == DISCOUNT_DCFR) {
+			posFactors[k] = std::pow(k, dcfrAlpha) / (std::pow(k, dcfrAlpha) + 1);
+			negFactors[k] = std::pow(k, dcfrBeta) / (std::pow(k, dcfrBeta) + 1);
+		}
+		else posFactors[k] = negFactors[k] = 1 - 1 / (double)(k + 1);
+	}
+	regrets.setDiscountFactors(posFactors, negFactors);
+}
 
+// Take the snapshots, save the checkpoint and print the progress
+// if currIter iterations have been done.
+void BlueprintCalculator::runPeriodicTasks()
+{
 	if (currIter >= snapshotBeginIter && (currIter - snapshotBeginIter) % snapshotPeriod == 0) {
+		opt::time_t t = opt::getTime();
 		takeSnapshot();
+		snapshotDuration += opt::getDuration(t);
 		if ((nextSnapshotId - 1) % avgSnapshotsPeriod == 0 || (nextSnapshotId - 1) == nSnapshots) {
 			// Perform the calculations for the final strategy
 			// and save it to the disk.
+			t = opt::getTime();
 			averageSnapshots();
+			avgSnapshotsDuration += opt::getDuration(t);
+			t = opt::getTime();
 			evaluateStrategy();
+			evalDuration += opt::getDuration(t);
 		}
 	}
-	if (currIter % checkpointPeriod == 0 || currIter == endIter)
+	if (evaluator) collectEvaluations();
+	if (currIter % checkpointPeriod == 0 || currIter == endIter) {
+		const opt::time_t t = opt::getTime();
 		updateCheckpoint();
-	if (verbose && (currIter % printPeriod == 0 || currIter == endIter))
-		printProgress();
+		checkpointDuration += opt::getDuration(t);
+	}
+	if (currIter % printPeriod == 0 || currIter == endIter) {
+		if (saveMetrics) writeMetrics();
+		if (verbose) printProgress();
+		resetPeriodStats();
+	}
 }
 
 std::array<uint16_t, 2> BlueprintCalculator::buildPruneCumWeights()
@@ -104,19 +269,62 @@ std::array<uint16_t, 2> BlueprintCalculator::buildPruneCumWeights()
 	return res;
 }
 
+// Each worker must sample different hands.
+unsigned BlueprintCalculator::workerSeed(unsigned rngSeed, unsigned workerId)
+{
+	return rngSeed ? rngSeed + workerId : 0;
+}
+
+// Pin the process so that the pages first touched by its members are local.
+bool BlueprintCalculator::pinProcess(unsigned workerId)
+{
+	if (!pinTrainProcesses) return false;
+	if (!opt::pinToNumaNode(workerId % opt::numaNodesCount()))
+		throw std::runtime_error("Process could not be pinned to its NUMA node.");
+	return true;
+}
+
+// Return the smallest x >= n such that x >= offset and (x - offset) % period == 0.
+static uint64_t nextPeriodicIter(uint64_t n, uint64_t offset, uint64_t period)
+{
+	if (n <= offset) return offset;
+	return offset + (n - offset + period - 1) / period * period;
+}
+
+// Return the smallest number of done iterations greater than or equal to n
+// after which the discounting or runPeriodicTasks have some work to do.
+uint64_t BlueprintCalculator::nextTasksIter(uint64_t n) const
+{
+	if (n > endIter) return TrainControl::IDLE;
+	uint64_t res = endIter;
+	// The discounting of iteration k * discountPeriod is done
+	// when k * discountPeriod + 1 iterations are done.
+	const uint64_t d = nextPeriodicIter(n, discountPeriod + 1, discountPeriod);
+	if (d - 1 < discountStopIter) res = (std::min)(res, d);
+	res = (std::min)(res, nextPeriodicIter(n, snapshotBeginIter, snapshotPeriod));
+	res = (std::min)(res, nextPeriodicIter(n, checkpointPeriod, checkpointPeriod));
+	res = (std::min)(res, nextPeriodicIter(n, printPeriod, printPeriod));
+	return res;
+}
+
 uint8_t BlueprintCalculator::nActions() const
 {
 	return abcInfo.nActions();
 }
 
-regret_t& BlueprintCalculator::getRegret(uint8_t actionId)
+regret_t& BlueprintCalculator::regretRef(uint8_t actionId)
 {
-	return regrets[abcInfo.roundIdx()][abcInfo.handIdx()][abcInfo.actionSeqIds[actionId]];
+	return regrets(abcInfo.roundIdx(), abcInfo.handIdx(), abcInfo.actionSeqIds[actionId]);
 }
 
 const regret_t BlueprintCalculator::getRegret(uint8_t actionId) const
 {
-	return regrets[abcInfo.roundIdx()][abcInfo.handIdx()][abcInfo.actionSeqIds[actionId]];
+	return regrets.get(abcInfo.roundIdx(), abcInfo.handIdx(), abcInfo.actionSeqIds[actionId]);
+}
+
+void BlueprintCalculator::markDirty(uint8_t actionId)
+{
+	regrets.markDirty(abcInfo.roundIdx(), abcInfo.handIdx(), abcInfo.actionSeqIds[actionId]);
 }
 
 void BlueprintCalculator::calculateCumRegrets()
@@ -145,20 +353,97 @@ int64_t BlueprintCalculator::calculateSumRegrets() const
 	return sum;
 }
 
+// The rows of the regrets are discounted when they are next accessed.
 void BlueprintCalculator::applyDiscounting()
 {
-	// currIter is divisible by discountPeriod.
-	float d = 1 - 1 / (float)(currIter / discountPeriod + 1);
+	regrets.setEpoch(regrets.epoch() + 1);
+	if (preflopStratPeriod) discountPreflopStrat(regrets.epoch());
+}
+
+// The counts of the average strategy are discounted like the weights of the
+// iterations in it, which grow like t^dcfrGamma with DCFR.
+void BlueprintCalculator::discountPreflopStrat(uint32_t epoch)
+{
+	double d = epoch / (double)(epoch + 1);
+	if (discountMode == DISCOUNT_DCFR) d = std::pow(d, dcfrGamma);
+	for (size_t i = 0; i < preflopStratSize(); ++i)
+		preflopStratSum[i] = (uint32_t)std::round(preflopStratSum[i] * d);
+}
+
+// Sample one action at each preflop infoset of traverser with the current
+// strategy and count it, exploring all the actions of the other players.
+// The counts are incremented atomically since the processes share them.
+void BlueprintCalculator::updatePreflopStrat(uint8_t traverser)
+{
+	hist.clear();
+	abcInfo.resetStakes();
+	abcInfo.startNewHand(true);
+	hist.push_back(abcInfo);
 
-	// Discount regrets.
-	for (auto& roundRegrets : regrets) {
-		for (auto& handRegrets : roundRegrets) {
-			for (regret_t& regret : handRegrets)
-				regret = (regret_t)std::round(regret * d);
+	// Do a DFS.
+	while (hist.size()) {
+		abcInfo = hist.back();
+		hist.pop_back();
+		if (abcInfo.state.finished || !abcInfo.state.isAlive(traverser)
+			|| abcInfo.state.round != egn::PREFLOP) continue;
+
+		regrets.refreshRow(egn::PREFLOP, abcInfo.handIdx());
+		if (abcInfo.state.actingPlayer == traverser) {
+			calculateCumRegrets();
+#pragma warning(suppress: 4244)
+			const uint8_t a = actionRandChoice(cumRegrets, rng);
+			uint32_t& count = preflopStratSum[
+				abcInfo.handIdx() * regrets.rowSize(egn::PREFLOP) + abcInfo.actionSeqIds[a]];
+			std::atomic_ref<uint32_t>(count).fetch_add(1, std::memory_order_relaxed);
+			abcInfo.nextState(a, true);
+			hist.push_back(abcInfo);
+		}
+		else {
+			const abcInfo_t node = abcInfo;
+			for (uint8_t a = 0; a < node.nActions(); ++a) {
+				abcInfo = node;
+				abcInfo.nextState(a, true);
+				hist.push_back(abcInfo);
+			}
 		}
 	}
 }
 
+size_t BlueprintCalculator::preflopStratSize() const
+{
+	return preflopStratPeriod ? regrets.nBcks(egn::PREFLOP) * regrets.rowSize(egn::PREFLOP) : 0;
+}
+
+// The file replaces the previous one only once fully written.
+// Written before the checkpoint, and committed once it is (see preflopStratSumFile).
+void BlueprintCalculator::savePreflopStratSum() const
+{
+	opt::BinaryWriter file(preflopStratSumPath() + ".tmp");
+	file.writeVar(currIter);
+	file.write(preflopStratSum, preflopStratSize() * sizeof(uint32_t));
+	file.close();
+}
+
+void BlueprintCalculator::commitPreflopStratSum() const
+{
+	std::filesystem::rename(preflopStratSumPath() + ".tmp", preflopStratSumPath());
+}
+
+// The runs resumed from a checkpoint without the counts have none yet.
+void BlueprintCalculator::loadPreflopStratSum()
+{
+	const std::string path = preflopStratSumFile(preflopStratSumPath(), currIter);
+	if (path.empty()) {
+		if (std::filesystem::exists(preflopStratSumPath()))
+			throw std::runtime_error("The preflop counts are not the ones of the checkpoint.");
+		return;
+	}
+	opt::BinaryReader file(path);
+	uint64_t iter;
+	file.readVar(iter);
+	file.read(preflopStratSum, preflopStratSize() * sizeof(uint32_t));
+}
+
 void BlueprintCalculator::traverseMCCFR(uint8_t traverser)
 {
 	stack.clear();
@@ -167,6 +452,8 @@ void BlueprintCalculator::traverseMCCFR(uint8_t traverser)
 	// lastChild will only deal with children of nodes where traverser plays.
 	lastChild.clear();
 	expVals.clear();
+	oppNodes.clear();
+	edges.clear();
 
 	abcInfo.resetStakes();
 	abcInfo.startNewHand(true);
@@ -185,7 +472,7 @@ void BlueprintCalculator::traverseMCCFR(uint8_t traverser)
 			if (lastChild.empty()) return;
 
 			// Add leaf's expected value on stack.
-			expVals.push_back(abcInfo.state.reward(traverser));
+			expVals.push_back(endEdge(abcInfo.state.reward(traverser)));
 
 			// Go back to the latest node having children not visited yet while
 			// backpropagating the expected value and updating the regrets.
@@ -198,17 +485,21 @@ void BlueprintCalculator::traverseMCCFR(uint8_t traverser)
 				// we can average them into the parent node's expected value.
 				egn::dchips v = calculateExpectedValue();
 				// Update the regrets.
+				prunedMask_t& mask = prunedMask();
 				for (uint8_t a = 0; a < nActions(); ++a) {
-					getRegret(a) += expVals.back() - v;
-					if (getRegret(a) < minRegret)
-						getRegret(a) = minRegret;
-					else if (getRegret(a) > maxRegret)
+					regret_t& regret = regretRef(a);
+					regret += expVals.back() - v;
+					if (regret < minRegret)
+						regret = minRegret;
+					else if (regret > maxRegret)
 						throw std::runtime_error("Regret overflow");
+					markDirty(a);
+					regrets.updatePrunedBit(mask, a, regret);
 					expVals.pop_back();
 				}
 				// All leafs visited and traverser's regrets updated: end of MCCFR traversal.
 				if (lastChild.empty()) return;
-				expVals.push_back(v);
+				expVals.push_back(endEdge(v));
 
 				// Go back to the previous parent.
 				hist.pop_back();
@@ -219,6 +510,7 @@ void BlueprintCalculator::traverseMCCFR(uint8_t traverser)
 
 			// Go to the next node.
 			const uint8_t a = stack.back();
+			beginEdge();
 			incrNodesCount(a);
 			abcInfo.nextState(a, true);
 			stack.pop_back();
@@ -227,12 +519,14 @@ void BlueprintCalculator::traverseMCCFR(uint8_t traverser)
 
 		// Current node has children.
 		else {
+			regrets.refreshRow(abcInfo.roundIdx(), abcInfo.handIdx());
 			if (abcInfo.state.actingPlayer == traverser) {
 				// Add all actions.
 				for (uint8_t a = 0; a < nActions() - 1; ++a)
 					stack.push_back(a);
 				// Go to the next node.
 				const uint8_t a = nActions() - 1;
+				beginEdge();
 				incrNodesCount(a);
 				abcInfo.nextState(a, true);
 				// There will always be at least two legal actions, so this is never the last.
@@ -242,8 +536,10 @@ void BlueprintCalculator::traverseMCCFR(uint8_t traverser)
 				// Sample an action with the current strategy.
 				calculateCumRegrets();
 #pragma warning(suppress: 4244)
+				const uint8_t a = actionRandChoice(cumRegrets, rng);
+				pushOppNode(traverser, a);
 				// Go to the next node.
-				abcInfo.nextState(actionRandChoice(cumRegrets, rng), true);
+				abcInfo.nextState(a, true);
 			}
 		}
 	}
@@ -260,8 +556,10 @@ void BlueprintCalculator::traverseMCCFRP(uint8_t traverser)
 	// lastChild will only deal with children of nodes where traverser plays.
 	lastChild.clear();
 	expVals.clear();
-	// visited will only deal with children of nodes where traverser plays.
-	visited.clear();
+	// skippedMasks will only contain the pruned actions of the nodes of hist.
+	skippedMasks.clear();
+	oppNodes.clear();
+	edges.clear();
 
 	abcInfo.resetStakes();
 	abcInfo.startNewHand(true);
@@ -280,7 +578,7 @@ void BlueprintCalculator::traverseMCCFRP(uint8_t traverser)
 			if (lastChild.empty()) return;
 
 			// Add leaf's expected value on stack.
-			expVals.push_back(abcInfo.state.reward(traverser));
+			expVals.push_back(endEdge(abcInfo.state.reward(traverser)));
 
 			// Go back to the latest node having children not visited yet while
 			// backpropagating the expected value and updating the regrets.
@@ -293,21 +591,25 @@ void BlueprintCalculator::traverseMCCFRP(uint8_t traverser)
 				// we can average them into the parent node's expected value.
 				egn::dchips v = calculateExpectedValueP();
 				// Update the regrets.
+				prunedMask_t& mask = prunedMask();
+				const prunedMask_t skipped = skippedMasks.back();
 				for (uint8_t a = 0; a < nActions(); ++a) {
-					if (visited.rbegin()[nActions() - 1 - a]) {
-						getRegret(a) += expVals.back() - v;
-						if (getRegret(a) < minRegret)
-							getRegret(a) = minRegret;
-						else if (getRegret(a) > maxRegret)
+					if (!(skipped >> a & 1)) {
+						regret_t& regret = regretRef(a);
+						regret += expVals.back() - v;
+						if (regret < minRegret)
+							regret = minRegret;
+						else if (regret > maxRegret)
 							throw std::runtime_error("Regret overflow");
+						markDirty(a);
+						regrets.updatePrunedBit(mask, a, regret);
 						expVals.pop_back();
 					}
 				}
 				// All leafs visited and traverser's regrets updated: end of MCCFR traversal.
 				if (lastChild.empty()) return;
-				// Remove the last nActions elements.
-				visited.resize(visited.size() - nActions());
-				expVals.push_back(v);
+				skippedMasks.pop_back();
+				expVals.push_back(endEdge(v));
 
 				// Go back to the previous parent.
 				hist.pop_back();
@@ -318,6 +620,7 @@ void BlueprintCalculator::traverseMCCFRP(uint8_t traverser)
 
 			// Go to the next node.
 			const uint8_t a = stack.back();
+			beginEdge();
 			incrNodesCount(a);
 			abcInfo.nextState(a, true);
 			stack.pop_back();
@@ -327,25 +630,31 @@ void BlueprintCalculator::traverseMCCFRP(uint8_t traverser)
 
 		// Current node has children.
 		else {
+			regrets.refreshRow(abcInfo.roundIdx(), abcInfo.handIdx());
 			if (abcInfo.state.actingPlayer == traverser) {
+				// Actions whose regret is below the pruning threshold.
+				const prunedMask_t pruned = (abcInfo.state.round == egn::RIVER) ? 0 : prunedMask();
+				prunedMask_t skipped = 0;
 				// Add all actions.
 				bool first = true;
 				for (uint8_t a = 0; a < nActions(); ++a) {
 					const auto action = abcInfo.actionAbc.legalActions[a];
 					// Prune only if the action is not on the last betting
 					// round or does not lead to a terminal node.
-					visited.push_back(action == abc::FOLD || action == abc::ALLIN
-						|| abcInfo.state.round == egn::RIVER
-						|| getRegret(a) > pruneThreshold
-						|| (action == abc::CALL && abcInfo.state.call == abcInfo.state.stakes[traverser]));
-					if (visited.back()) {
+					if (!(pruned >> a & 1)
+						|| action == abc::FOLD || action == abc::ALLIN
+						|| (action == abc::CALL && abcInfo.state.call == abcInfo.state.stakes[traverser])) {
 						stack.push_back(a);
 						firstAction.push_back(first);
 						first = false;
 					}
+					else skipped |= (prunedMask_t)(1u << a);
 				}
+				skippedMasks.push_back(skipped);
+				prunedSubtrees[abcInfo.roundIdx()] += std::popcount(skipped);
 				// Go to the next node.
 				const uint8_t a = stack.back();
+				beginEdge();
 				incrNodesCount(a);
 				abcInfo.nextState(a, true);
 				stack.pop_back();
@@ -356,8 +665,10 @@ void BlueprintCalculator::traverseMCCFRP(uint8_t traverser)
 				// Sample an action with the current strategy.
 				calculateCumRegrets();
 #pragma warning(suppress: 4244)
+				const uint8_t a = actionRandChoice(cumRegrets, rng);
+				pushOppNode(traverser, a);
 				// Go to the next node.
-				abcInfo.nextState(actionRandChoice(cumRegrets, rng), true);
+				abcInfo.nextState(a, true);
 			}
 		}
 	}
@@ -392,9 +703,10 @@ egn::dchips BlueprintCalculator::calculateExpectedValueP() const
 
 	// If no regret is positive, all actions have the same proba,
 	// so we take the arithmetic mean of the expected values.
+	const prunedMask_t skipped = skippedMasks.back();
 	if (s == 0) {
 		for (uint8_t a = 0; a < nActions(); ++a) {
-			if (visited.rbegin()[nActions() - 1 - a])
+			if (!(skipped >> a & 1))
 				v += expVals.rbegin()[s++];
 		}
 	}
@@ -402,7 +714,7 @@ egn::dchips BlueprintCalculator::calculateExpectedValueP() const
 	else {
 		uint8_t i = 0;
 		for (uint8_t a = 0; a < nActions(); ++a) {
-			if (visited.rbegin()[nActions() - 1 - a]) {
+			if (!(skipped >> a & 1)) {
 				if (getRegret(a) > 0)
 					v += (int64_t)getRegret(a) * expVals.rbegin()[i];
 				++i;
@@ -413,9 +725,70 @@ egn::dchips BlueprintCalculator::calculateExpectedValueP() const
 	return (egn::dchips)(v / s);
 }
 
+prunedMask_t& BlueprintCalculator::prunedMask()
+{
+	return regrets.prunedMask(abcInfo.roundIdx(), abcInfo.handIdx(), abcInfo.actionSeqIds[0]);
+}
+
+// Called when the traverser goes down one of its actions.
+void BlueprintCalculator::beginEdge()
+{
+	edges.push_back({ oppNodes.size(), nodesCount, abcInfo.roundIdx() });
+}
+
+// Called with the sampled value v of the last edge begun once its subtree is done.
+// The sizes of the explored subtrees estimate the nodes saved by the pruned ones.
+egn::dchips BlueprintCalculator::endEdge(egn::dchips v)
+{
+	const Edge& edge = edges.back();
+	++exploredSubtrees[edge.roundId];
+	exploredSubtreeNodes[edge.roundId] += nodesCount - edge.nodesBegin;
+	if (vrBaselineRounds) v = correctValue(v, edge.oppNodesBegin);
+	edges.pop_back();
+	return v;
+}
+
+// Remember the opponent's node where actionId was sampled,
+// with the expectation of its baselines under the current strategy.
+void BlueprintCalculator::pushOppNode(uint8_t traverser, uint8_t actionId)
+{
+	const uint8_t r = abcInfo.roundIdx();
+	if (r >= vrBaselineRounds || edges.empty()) return;
+
+	float* rowBaselines = baselines[r].data() + abcInfo.handIdx(traverser) * regrets.rowSize(r);
+	double expBaseline = 0;
+	for (uint8_t a = 0; a < nActions(); ++a) {
+		const uint64_t weight = cumRegrets[a] - (a ? cumRegrets[a - 1] : 0);
+		expBaseline += (double)weight * rowBaselines[abcInfo.actionSeqIds[a]];
+	}
+	oppNodes.push_back({
+		rowBaselines + abcInfo.actionSeqIds[actionId],
+		(float)(expBaseline / cumRegrets.back()) });
+}
+
+// Return the value of the edge of the traverser ending with the sampled value v.
+// From the deepest opponent's node of the edge, the value of the node is
+// estimated by its expected baseline plus the error of the baseline of the
+// sampled action, which is then moved towards the sampled value.
+egn::dchips BlueprintCalculator::correctValue(egn::dchips v, size_t oppNodesBegin)
+{
+	double value = v;
+	for (size_t i = oppNodes.size(); i-- > oppNodesBegin;) {
+		OppNode& node = oppNodes[i];
+		const double err = value - *node.baseline;
+		vrRawSqErr += (value - node.expBaseline) * (value - node.expBaseline);
+		vrCvSqErr += err * err;
+		value = node.expBaseline + err;
+		*node.baseline += (float)(vrBaselineRate * err);
+	}
+	oppNodes.resize(oppNodesBegin);
+	return (egn::dchips)std::round(value);
+}
+
 void BlueprintCalculator::incrNodesCount(uint8_t actionId)
 {
 	++nodesCount;
+	++roundNodesCount[abcInfo.roundIdx()];
 	if (getRegret(actionId) == 0) ++nodesUniqueCount;
 }
 
@@ -430,123 +803,264 @@ uint64_t BlueprintCalculator::getNUniqueNodes() const
 // Save the current strategy of each round on the disk.
 void BlueprintCalculator::takeSnapshot()
 {
-	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+	if (compressedSnapshots && lastSnapshot.back().empty()) loadLastSnapshot();
+
+	// The rounds are saved in parallel.
+	regrets.adviseSequential(true);
+	regrets.refreshAll();
+	std::vector<std::thread> threads;
+	for (uint8_t r = firstSnapshotRound + 1; r < egn::N_ROUNDS; ++r)
+		threads.emplace_back(&BlueprintCalculator::snapshotRound, this, r);
+	snapshotRound(firstSnapshotRound);
+	for (auto& t : threads) t.join();
+	regrets.adviseSequential(false);
 
-		// Open the file.
-		auto file = opt::fstream(
-			snapshotPath(nextSnapshotId, r), std::ios::out | std::ios::binary);
+	++nextSnapshotId;
+}
+
+void BlueprintCalculator::snapshotRound(uint8_t roundId)
+{
+	const uint8_t r = roundId;
+
+	// Open the file.
+	std::optional<opt::BinaryWriter> file;
+	std::optional<opt::ZstdWriter> writer;
+	if (compressedSnapshots) writer.emplace(snapshotPath(nextSnapshotId, r));
+	else file.emplace(snapshotPath(nextSnapshotId, r));
+
+	// Each thread needs its own buffers.
+	std::vector<uint64_t> cumRegrets;
+	std::vector<strat_t> handStrats(regrets.rowSize(r));
+
+	// Write in the file.
+	// Loop over all the regrets of the round.
+	for (bckSize_t handIdx = 0; handIdx < regrets.nBcks(r); ++handIdx) {
+
+		abc::GroupedActionSeqs::seqIdx_t currSeq = 0;
+
+		for (const uint8_t nLegalActions : gpSeqs.lens[r]) {
+
+			// Calculate the cumulated sums of the positive regrets
+			// of the legal actions.
+			cumRegrets.resize(nLegalActions);
+			const abc::GroupedActionSeqs::seqIdx_t firstSeq = currSeq;
+			auto seqIdx = gpSeqs.seqs[r][currSeq];
+			regret_t regret = regrets.get(r, handIdx, seqIdx);
+			cumRegrets[0] = (regret > 0) ? regret : 0;
+			++currSeq;
+			for (uint8_t a = 1; a < nLegalActions; ++a) {
+				seqIdx = gpSeqs.seqs[r][currSeq];
+				regret = regrets.get(r, handIdx, seqIdx);
+				if (regret > 0)
+					cumRegrets[a] = cumRegrets[a - 1] + regret;
+				else
+					cumRegrets[a] = cumRegrets[a - 1];
+				++currSeq;
+			}
+			// If no regret is positive, the strategy is to choose
+			// with a uniform distribution.
+			if (cumRegrets.back() == 0) {
+				for (uint8_t i = 0; i < cumRegrets.size(); ++i)
+					cumRegrets[i] = i + 1;
+			}
 
-		// Write in the file.
-		// Loop over all the regrets of the round.
-		for (bckSize_t handIdx = 0;  handIdx < regrets[r].size(); ++handIdx) {
+			// Normalize the regrets.
+			cumWeightsRescaler.rescaleCumWeights(cumRegrets, sumStrat);
+			handStrats[firstSeq] = (strat_t)cumRegrets[0];
+			for (uint8_t i = 1; i < nLegalActions; ++i)
+				handStrats[firstSeq + i] = (strat_t)(cumRegrets[i] - cumRegrets[i - 1]);
+		}
 
-			abc::GroupedActionSeqs::seqIdx_t currSeq = 0;
+		if (!compressedSnapshots) {
+			file->write(std::span(handStrats));
+			continue;
+		}
 
-			for (const uint8_t nLegalActions : gpSeqs.lens[r]) {
+		// Write the XOR with the last snapshot, mostly made of zeros.
+		strat_t* lastStrats = lastSnapshot[r].data() + handIdx * handStrats.size();
+		for (size_t i = 0; i < handStrats.size(); ++i) {
+			const strat_t strat = handStrats[i];
+			handStrats[i] ^= lastStrats[i];
+			lastStrats[i] = strat;
+		}
+		writer->write(handStrats.data(), handStrats.size() * sizeof(strat_t));
+	}
 
-				// Calculate the cumulated sums of the positive regrets
-				// of the legal actions.
-				cumRegrets.resize(nLegalActions);
-				auto seqIdx = gpSeqs.seqs[r][currSeq];
-				regret_t regret = regrets[r][handIdx][seqIdx];
-				cumRegrets[0] = (regret > 0) ? regret : 0;
-				++currSeq;
-				for (uint8_t a = 1; a < nLegalActions; ++a) {
-					seqIdx = gpSeqs.seqs[r][currSeq];
-					regret = regrets[r][handIdx][seqIdx];
-					if (regret > 0)
-						cumRegrets[a] = cumRegrets[a - 1] + regret;
-					else
-						cumRegrets[a] = cumRegrets[a - 1];
-					++currSeq;
-				}
-				// If no regret is positive, the strategy is to choose
-				// with a uniform distribution.
-				if (cumRegrets.back() == 0) {
-					for (uint8_t i = 0; i < cumRegrets.size(); ++i)
-						cumRegrets[i] = i + 1;
-				}
+	if (compressedSnapshots) writer->close();
+	else file->close();
+}
 
-				// Normalize the regrets and write them in the file.
-				cumWeightsRescaler.rescaleCumWeights(cumRegrets, sumStrat);
-				strat_t strat = (strat_t)cumRegrets[0];
-				opt::saveVar(strat, file);
-				for (uint8_t i = 1; i < nLegalActions; ++i) {
-					strat = (strat_t)(cumRegrets[i] - cumRegrets[i - 1]);
-					opt::saveVar(strat, file);
-				}
+// Decode the last compressed snapshot, e.g. after resuming from a checkpoint.
+void BlueprintCalculator::loadLastSnapshot()
+{
+	for (uint8_t r = firstSnapshotRound; r < egn::N_ROUNDS; ++r) {
+		lastSnapshot[r].assign(regrets.nBcks(r) * regrets.rowSize(r), 0);
+		std::vector<strat_t> delta(regrets.rowSize(r));
+		for (unsigned snapshotId = 1; snapshotId < nextSnapshotId; ++snapshotId) {
+			opt::ZstdReader reader(snapshotPath(snapshotId, r));
+			for (size_t b = 0; b < regrets.nBcks(r); ++b) {
+				reader.read(delta.data(), delta.size() * sizeof(strat_t));
+				strat_t* lastStrats = lastSnapshot[r].data() + b * delta.size();
+				for (size_t i = 0; i < delta.size(); ++i) lastStrats[i] ^= delta[i];
 			}
 		}
-
-		file.close();
 	}
+}
 
-	++nextSnapshotId;
+// Weight of a snapshot in the average strategy, matching the weight
+// of the iterations in the regrets with the discounting mode.
+static sumStrat_t snapshotWeight(unsigned snapshotId)
+{
+	if (discountMode == DISCOUNT_PLURIBUS) return 1;
+	static const double maxWeight = 256;
+	const double t = (double)(snapshotBeginIter + (snapshotId - 1) * snapshotPeriod) / endIter;
+	const double w = std::round(maxWeight * std::pow(t, (discountMode == DISCOUNT_LINEAR) ? 1 : dcfrGamma));
+	return (std::max)((sumStrat_t)w, (sumStrat_t)1);
 }
 
 // Average the snapshots into the final strategy for each round
 // and save it to the disk.
 void BlueprintCalculator::averageSnapshots()
 {
+	// The averaged strategy is also kept in memory for the evaluator.
+	if (evaluator) avgStrat.assign(egn::N_ROUNDS, {});
+
+	// Like the number of snapshots with equal weights, the sum
+	// of the weights is the one of all the snapshots of the training.
+	sumStrat_t sumWeights = 0;
+	for (unsigned snapshotId = 1; snapshotId <= nSnapshots; ++snapshotId)
+		sumWeights += snapshotWeight(snapshotId);
+
 	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
 
 		// Allocate memory for the snapshots' strategies.
 		std::vector<std::vector<sumStrat_t>> strats(
 			abcInfo.nBcks(egn::Round(r)), std::vector<sumStrat_t>(abcInfo.nActionSeqs(egn::Round(r))));
 
-		// Calculate the sum of the snapshots' strategies.
-		for (unsigned snapshotId = 1; snapshotId < nextSnapshotId; ++snapshotId) {
+		// The preflop strategy is already normalized from its counts.
+		if (r < firstSnapshotRound) averagePreflopStrat(strats);
 
-			// Open the snapshot.
-			auto snapshotFile = opt::fstream(
-				snapshotPath(snapshotId, r), std::ios::in | std::ios::binary);
-
-			// Add the snapshot's strategy to the total sum.
+		// Calculate the sum of the snapshots' strategies.
+		else if (compressedSnapshots) {
+			// A compressed snapshot is the XOR of its file with the previous one,
+			// so all of them are decoded together, hand by hand.
+			std::vector<std::unique_ptr<opt::ZstdReader>> readers;
+			for (unsigned snapshotId = 1; snapshotId < nextSnapshotId; ++snapshotId)
+				readers.push_back(std::make_unique<opt::ZstdReader>(snapshotPath(snapshotId, r)));
+			std::vector<strat_t> snapshot, delta;
 			for (auto& handStrats : strats) {
-				for (auto& accStrat : handStrats) {
-					strat_t strat;
-					opt::loadVar(strat, snapshotFile);
-					accStrat += strat;
+				snapshot.assign(handStrats.size(), 0);
+				delta.resize(handStrats.size());
+				for (size_t readerIdx = 0; readerIdx < readers.size(); ++readerIdx) {
+					const sumStrat_t w = snapshotWeight((unsigned)readerIdx + 1);
+					readers[readerIdx]->read(delta.data(), delta.size() * sizeof(strat_t));
+					for (size_t i = 0; i < handStrats.size(); ++i) {
+						snapshot[i] ^= delta[i];
+						handStrats[i] += w * snapshot[i];
+					}
+				}
+			}
+		}
+		else {
+			std::vector<strat_t> snapshot;
+			for (unsigned snapshotId = 1; snapshotId < nextSnapshotId; ++snapshotId) {
+
+				// Open the snapshot.
+				opt::BinaryReader snapshotFile(snapshotPath(snapshotId, r));
+				const sumStrat_t w = snapshotWeight(snapshotId);
+
+				// Add the snapshot's strategy to the total sum.
+				for (auto& handStrats : strats) {
+					snapshot.resize(handStrats.size());
+					snapshotFile.read(std::span(snapshot));
+					for (size_t i = 0; i < handStrats.size(); ++i)
+						handStrats[i] += w * snapshot[i];
 				}
 			}
-
-			snapshotFile.close();
 		}
 
-		// Normalize the snapshots' strategies by dividing by nSnapshots.
-		// We apply the following weird procedure so that the sum of
-		// the strategy values will be exactly equal to sumStrat, getting around
-		// rounding issues.
-		for (auto& handStrats : strats) {
-			abc::GroupedActionSeqs::seqIdx_t seqIdx = 0;
-			for (const uint8_t nLegalActions : gpSeqs.lens[r]) {
-				for (size_t i = seqIdx + 1; i < seqIdx + nLegalActions; ++i)
-					handStrats[i] += handStrats[i - 1];
-				for (size_t i = seqIdx; i < seqIdx + nLegalActions; ++i)
-					handStrats[i] = (sumStrat_t)std::round((double)handStrats[i] / nSnapshots);
-				for (size_t i = seqIdx + nLegalActions - 1; i > seqIdx; --i)
-					handStrats[i] -= handStrats[i - 1];
-				seqIdx += nLegalActions;
+		if (r >= firstSnapshotRound) {
+			// Normalize the snapshots' strategies by dividing by the sum of their weights.
+			// We apply the following weird procedure so that the sum of
+			// the strategy values will be exactly equal to sumStrat, getting around
+			// rounding issues.
+			for (auto& handStrats : strats) {
+				abc::GroupedActionSeqs::seqIdx_t seqIdx = 0;
+				for (const uint8_t nLegalActions : gpSeqs.lens[r]) {
+					for (size_t i = seqIdx + 1; i < seqIdx + nLegalActions; ++i)
+						handStrats[i] += handStrats[i - 1];
+					for (size_t i = seqIdx; i < seqIdx + nLegalActions; ++i)
+						handStrats[i] = (sumStrat_t)std::round((double)handStrats[i] / sumWeights);
+					for (size_t i = seqIdx + nLegalActions - 1; i > seqIdx; --i)
+						handStrats[i] -= handStrats[i - 1];
+					seqIdx += nLegalActions;
+				}
 			}
 		}
 
 		// Open the file.
-		auto file = opt::fstream(stratPath(r), std::ios::out | std::ios::binary);
+		opt::BinaryWriter file(stratPath(r));
 
 		// Write the average of the snapshots' strategies.
+		std::vector<strat_t> avgStrats;
 		for (auto& handStrats : strats) {
-			for (size_t seqIdx = 0; seqIdx < handStrats.size(); ++seqIdx) {
-				strat_t strat = (strat_t)handStrats[gpSeqsInv.invSeqs[r][seqIdx]];
-				opt::saveVar(strat, file);
-			}
+			avgStrats.resize(handStrats.size());
+			for (size_t seqIdx = 0; seqIdx < handStrats.size(); ++seqIdx)
+				avgStrats[seqIdx] = (strat_t)handStrats[gpSeqsInv.invSeqs[r][seqIdx]];
+			file.write(std::span(avgStrats));
+			if (evaluator) avgStrat[r].push_back(avgStrats);
 		}
 
 		file.close();
 	}
+
+	// Pack the rounds in the file mapped by the blueprint AIs.
+	packStratFile(
+		BLUEPRINT_GAME_NAME, blueprintName(),
+		{ N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER },
+		{
+			abcInfo.nActionSeqs(egn::PREFLOP),
+			abcInfo.nActionSeqs(egn::FLOP),
+			abcInfo.nActionSeqs(egn::TURN),
+			abcInfo.nActionSeqs(egn::RIVER)
+		});
+}
+
+// Normalize the counts of the preflop actions in the order of gpSeqs.
+void BlueprintCalculator::averagePreflopStrat(std::vector<std::vector<sumStrat_t>>& strats) const
+{
+	const size_t rowSize = regrets.rowSize(egn::PREFLOP);
+	std::vector<uint64_t> cumCounts;
+	for (bckSize_t handIdx = 0; handIdx < strats.size(); ++handIdx) {
+		const uint32_t* counts = preflopStratSum + handIdx * rowSize;
+		abc::GroupedActionSeqs::seqIdx_t currSeq = 0;
+		for (const uint8_t nLegalActions : gpSeqs.lens[egn::PREFLOP]) {
+			cumCounts.resize(nLegalActions);
+			const abc::GroupedActionSeqs::seqIdx_t firstSeq = currSeq;
+			for (uint8_t a = 0; a < nLegalActions; ++a) {
+				cumCounts[a] = (a ? cumCounts[a - 1] : 0) + counts[gpSeqs.seqs[egn::PREFLOP][currSeq]];
+				++currSeq;
+			}
+			// An infoset never reached is played uniformly.
+			if (cumCounts.back() == 0) {
+				for (uint8_t i = 0; i < cumCounts.size(); ++i)
+					cumCounts[i] = i + 1;
+			}
+			cumWeightsRescaler.rescaleCumWeights(cumCounts, sumStrat);
+			strats[handIdx][firstSeq] = (sumStrat_t)cumCounts[0];
+			for (uint8_t i = 1; i < nLegalActions; ++i)
+				strats[handIdx][firstSeq + i] = (sumStrat_t)(cumCounts[i] - cumCounts[i - 1]);
+		}
+	}
 }
 
 void BlueprintCalculator::evaluateStrategy()
 {
+	if (evaluator) {
+		evaluator->submit(std::move(avgStrat), nextSnapshotId - 1);
+		return;
+	}
+
 	double gainAvg = 0;
 	double gainStd = 0;
 	BlueprintAIEvaluator::evalBlueprintAI(
@@ -554,6 +1068,20 @@ void BlueprintCalculator::evaluateStrategy()
 	gainsAvg.push_back((float)gainAvg);
 	gainsStd.push_back((float)gainStd);
 	nSnapshotsUsedForEval.push_back(nextSnapshotId - 1);
+	newEval = true;
+}
+
+// Add the results of the evaluations done in the background.
+void BlueprintCalculator::collectEvaluations()
+{
+	std::vector<AsyncEvaluator::Result> results;
+	if (!evaluator->collect(results)) return;
+	for (const auto& res : results) {
+		gainsAvg.push_back(res.gainAvg);
+		gainsStd.push_back(res.gainStd);
+		nSnapshotsUsedForEval.push_back(res.nSnapshots);
+	}
+	newEval = true;
 }
 
 void BlueprintCalculator::writeConstants() const
@@ -599,6 +1127,13 @@ void BlueprintCalculator::writeConstants() const
 	WRITE_VAR(file, evalStratDuration);
 	file << "\n";
 	WRITE_VAR(file, endIter);
+	file << "\n";
+	WRITE_VAR(file, discountMode);
+	WRITE_VAR(file, dcfrAlpha);
+	WRITE_VAR(file, dcfrBeta);
+	WRITE_VAR(file, dcfrGamma);
+	file << "\n";
+	WRITE_VAR(file, preflopStratPeriod);
 
 	file.close();
 }
@@ -636,6 +1171,18 @@ void BlueprintCalculator::verifyConstants() const
 	verifyOneConstant(file, discountEndIter);
 	verifyOneConstant(file, discountPeriod);
 
+	// The constants added since are found by name, and the runs written before
+	// them have their old behaviour.
+	// The discount factors of the lazy rows depend on the mode and its parameters.
+	verifyNamedConstant(file, "discountMode", discountMode, DISCOUNT_PLURIBUS);
+	if (discountMode == DISCOUNT_DCFR) {
+		verifyNamedConstant(file, "dcfrAlpha", dcfrAlpha, dcfrAlpha);
+		verifyNamedConstant(file, "dcfrBeta", dcfrBeta, dcfrBeta);
+		verifyNamedConstant(file, "dcfrGamma", dcfrGamma, dcfrGamma);
+	}
+	// The counts of the preflop strategy are not comparable between periods.
+	verifyNamedConstant(file, "preflopStratPeriod", preflopStratPeriod, (uint64_t)0);
+
 	file.close();
 }
 
@@ -652,14 +1199,73 @@ void BlueprintCalculator::verifyOneConstant(std::ifstream& file, const T& v) con
 		throw std::runtime_error("A constant differs from the one used in the checkpoint.");
 }
 
+// oldValue is the one of the runs whose constants file does not have name.
+template<typename T>
+void BlueprintCalculator::verifyNamedConstant(std::ifstream& file, const char* name, const T& v, const T& oldValue) const
+{
+	std::string line = opt::findVarLine(file, name);
+	if (line.empty()) {
+		std::ostringstream os;
+		opt::writeVar(os, oldValue, name);
+		line = os.str();
+	}
+
+	std::ostringstream os;
+	opt::writeVar(os, v, name);
+
+	if (opt::extractVarValue(line) != opt::extractVarValue(os.str()))
+		throw std::runtime_error("A constant differs from the one used in the checkpoint.");
+}
+
 void BlueprintCalculator::updateCheckpoint()
 {
 	lastCheckpointIter = currIter;
+	regrets.refreshAll();
+	if (preflopStratPeriod) savePreflopStratSum();
+
+	if (mappedCheckpoint) {
+		auto file = opt::fstream(mappedCkpt.stateTmpPath(), std::ios::out | std::ios::binary);
+		saveState(file);
+		file.close();
+		mappedCkpt.commit(regrets);
+	}
+	else if (compressedCheckpoint) {
+		// The renamed state file commits the new shards, which it lists.
+		const ShardsHeader header = saveRegretShards(regrets, blueprintName());
+		const std::string stateTmpPath = checkpointStatePath() + ".tmp";
+		auto file = opt::fstream(stateTmpPath, std::ios::out | std::ios::binary);
+		header.save(file);
+		saveState(file);
+		file.close();
+		if (!file)
+			throw std::runtime_error("The checkpoint state could not be written.");
+		if (!opt::syncPath(stateTmpPath))
+			throw std::runtime_error("The checkpoint state could not be synced.");
+		std::filesystem::rename(stateTmpPath, checkpointStatePath());
+		opt::syncPath(blueprintTmpDir());
+		removeOldRegretShards(blueprintName());
+		// A converted classic checkpoint would be outdated.
+		std::filesystem::remove(checkpointPath());
+	}
+	else {
+		auto file = opt::fstream(checkpointPath(), std::ios::out | std::ios::binary);
+		regrets.save(file);
+		saveState(file);
+		file.close();
+	}
 
-	auto file = opt::fstream(checkpointPath(), std::ios::out | std::ios::binary);
+	if (preflopStratPeriod) commitPreflopStratSum();
+}
 
-	opt::save3DVector(regrets, file);
+void BlueprintCalculator::loadCheckpoint(std::fstream& file)
+{
+	regrets.load(file);
+	loadState(file);
+}
 
+// Save everything in the checkpoint after the regrets.
+void BlueprintCalculator::saveState(std::fstream& file) const
+{
 	rng.save(file);
 	pruneRandChoice.save(file);
 	actionRandChoice.save(file);
@@ -681,14 +1287,10 @@ void BlueprintCalculator::updateCheckpoint()
 		opt::save1DVector(gainsStd, file);
 		opt::save1DVector(nSnapshotsUsedForEval, file);
 	}
-
-	file.close();
 }
 
-void BlueprintCalculator::loadCheckpoint(std::fstream& file)
+void BlueprintCalculator::loadState(std::fstream& file)
 {
-	opt::load3DVector(regrets, file);
-
 	rng.load(file);
 	pruneRandChoice.load(file);
 	actionRandChoice.load(file);
@@ -714,6 +1316,188 @@ void BlueprintCalculator::loadCheckpoint(std::fstream& file)
 	}
 }
 
+bool BlueprintCalculator::isLeader() const
+{
+	return workerId == 0;
+}
+
+// Map the shared memory segment holding the control block followed by the regrets.
+// The leader creates it while the followers wait for it to exist.
+void BlueprintCalculator::attachSharedRegrets()
+{
+	// The pruned masks and the preflop counts follow the regrets.
+	const size_t masksOffset = trainControlSize + regrets.nBytes();
+	const size_t preflopStratOffset = (masksOffset + regrets.masksBytes() + 63) / 64 * 64;
+	const size_t size = preflopStratOffset + preflopStratSize() * sizeof(uint32_t);
+	if (isLeader()) {
+		// Remove the segment left by a previous run which crashed.
+		opt::MemoryMap::removeShared(sharedRegretsName());
+		sharedMem.createShared(sharedRegretsName(), size);
+	}
+	else {
+		if (verbose) std::cout << "Waiting for the leader...\n";
+		while (!sharedMem.openShared(sharedRegretsName(), size))
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	ctrl = (TrainControl*)sharedMem.data();
+	regrets.attach((regret_t*)((char*)sharedMem.data() + trainControlSize));
+	if (regrets.nRows() > maxRegretRows)
+		throw std::runtime_error("Too many hand buckets for the shared memory.");
+	regrets.attachEpochs(ctrl->rowEpochs);
+	regrets.attachMasks((prunedMask_t*)((char*)sharedMem.data() + masksOffset));
+	opt::freeVectMem(ownedPreflopStratSum);
+	preflopStratSum = (uint32_t*)((char*)sharedMem.data() + preflopStratOffset);
+}
+
+// Called by the leader once the regrets have been loaded from the checkpoint.
+void BlueprintCalculator::publishSharedState()
+{
+	ctrl->regretsSize = regrets.size();
+	ctrl->nextIter = currIter;
+	ctrl->doneIter = currIter;
+	ctrl->iterLimit = nextTasksIter(currIter + 1);
+	ctrl->discountEpoch = regrets.epoch();
+	ctrl->nodesCount = nodesCount;
+	ctrl->nodesUniqueCount = nodesUniqueCount;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		ctrl->roundNodesCount[r] = 0;
+		ctrl->prunedSubtrees[r] = 0;
+		ctrl->exploredSubtrees[r] = 0;
+		ctrl->exploredSubtreeNodes[r] = 0;
+	}
+	ctrl->nPrunedIters = 0;
+	for (unsigned i = 0; i < maxTrainProcesses; ++i) {
+		ctrl->workerIters[i] = TrainControl::IDLE;
+		ctrl->heartbeats[i] = 0;
+	}
+	flushedNodesCount = nodesCount;
+	flushedNodesUniqueCount = nodesUniqueCount;
+	// Must be the last write, the followers start as soon as they see it.
+	ctrl->magic = TrainControl::MAGIC;
+}
+
+void BlueprintCalculator::waitSharedState()
+{
+	while (ctrl->magic != TrainControl::MAGIC)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	if (ctrl->regretsSize != regrets.size())
+		throw std::runtime_error("The shared regrets do not have the expected size.");
+	currIter = ctrl->doneIter;
+	regrets.setEpoch((uint32_t)ctrl->discountEpoch);
+	nodesCount = flushedNodesCount = ctrl->nodesCount;
+	nodesUniqueCount = flushedNodesUniqueCount = ctrl->nodesUniqueCount;
+}
+
+// Every process claims the next iteration and does its traversals on the shared
+// regrets. The updates of the regrets are not atomic: like in Hogwild!, two
+// processes writing the same regret at the same time may lose one of the updates,
+// which is rare enough not to matter given the number of infosets.
+// The discounting, the snapshots, the checkpoints and the prints are done by
+// the leader alone when all the iterations before them are done.
+void BlueprintCalculator::buildStrategyShared()
+{
+	while (true) {
+		uint64_t iter = ctrl->nextIter;
+		// No iteration can be claimed from endIter, whatever iterLimit
+		// (the leader may have moved it past endIter or set it to IDLE).
+		if (iter >= endIter && !isLeader()) break;
+		if (iter >= ctrl->iterLimit || iter >= endIter) {
+			if (isLeader()) runSharedTasks(iter);
+			else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			if (iter >= endIter) break;
+			continue;
+		}
+		if (!ctrl->nextIter.compare_exchange_weak(iter, iter + 1)) continue;
+
+		ctrl->heartbeats[workerId] = TrainControl::nowMs();
+		ctrl->workerIters[workerId] = iter;
+		currIter = iter;
+		// The leader may have discounted the regrets since the last iteration.
+		regrets.setEpoch((uint32_t)ctrl->discountEpoch);
+		traverseIter();
+		flushSharedCounters();
+
+		// If the leader gave the iteration up because this process
+		// took too long, it has already been counted as done.
+		uint64_t expected = iter;
+		if (ctrl->workerIters[workerId].compare_exchange_strong(expected, TrainControl::IDLE))
+			++ctrl->doneIter;
+	}
+	if (isLeader()) opt::MemoryMap::removeShared(sharedRegretsName());
+}
+
+// Run the tasks due after iter iterations once they are all done.
+void BlueprintCalculator::runSharedTasks(uint64_t iter)
+{
+	while (ctrl->doneIter < iter) {
+		releaseDeadWorkers();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	syncSharedCounters();
+
+	currIter = iter - 1;
+	if (mustDiscount(currIter)) {
+		applyDiscounting();
+		ctrl->discountEpoch = regrets.epoch();
+	}
+	++currIter;
+	runPeriodicTasks();
+
+	ctrl->iterLimit = nextTasksIter(currIter + 1);
+}
+
+// Count as done the iterations of the followers which stopped giving signs of life.
+void BlueprintCalculator::releaseDeadWorkers()
+{
+	const uint64_t now = TrainControl::nowMs();
+	for (unsigned i = 1; i < nTrainProcesses; ++i) {
+		uint64_t iter = ctrl->workerIters[i];
+		if (iter == TrainControl::IDLE || now - ctrl->heartbeats[i] < workerTimeoutMs) continue;
+		if (ctrl->workerIters[i].compare_exchange_strong(iter, TrainControl::IDLE)) {
+			++ctrl->doneIter;
+			std::cout << "Worker " << i << " timed out on iteration " << iter << ".\n";
+		}
+	}
+}
+
+// Add the statistics of the last iteration to the shared ones.
+void BlueprintCalculator::flushSharedCounters()
+{
+	ctrl->nodesCount += nodesCount - flushedNodesCount;
+	ctrl->nodesUniqueCount += nodesUniqueCount - flushedNodesUniqueCount;
+	flushedNodesCount = nodesCount;
+	flushedNodesUniqueCount = nodesUniqueCount;
+
+	// The leader keeps its own statistics of the period for the metrics.
+	if (isLeader()) return;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		ctrl->roundNodesCount[r] += roundNodesCount[r];
+		ctrl->prunedSubtrees[r] += prunedSubtrees[r];
+		ctrl->exploredSubtrees[r] += exploredSubtrees[r];
+		ctrl->exploredSubtreeNodes[r] += exploredSubtreeNodes[r];
+		roundNodesCount[r] = 0;
+		prunedSubtrees[r] = 0;
+		exploredSubtrees[r] = 0;
+		exploredSubtreeNodes[r] = 0;
+	}
+	ctrl->nPrunedIters += nPrunedIters;
+	nPrunedIters = 0;
+}
+
+// Collect the statistics of all the processes in the leader.
+void BlueprintCalculator::syncSharedCounters()
+{
+	nodesCount = flushedNodesCount = ctrl->nodesCount;
+	nodesUniqueCount = flushedNodesUniqueCount = ctrl->nodesUniqueCount;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		roundNodesCount[r] += ctrl->roundNodesCount[r].exchange(0);
+		prunedSubtrees[r] += ctrl->prunedSubtrees[r].exchange(0);
+		exploredSubtrees[r] += ctrl->exploredSubtrees[r].exchange(0);
+		exploredSubtreeNodes[r] += ctrl->exploredSubtreeNodes[r].exchange(0);
+	}
+	nPrunedIters += ctrl->nPrunedIters.exchange(0);
+}
+
 void BlueprintCalculator::printProgress() const
 {
 	std::cout << blueprintName() << "\n";
@@ -736,16 +1520,28 @@ void BlueprintCalculator::printProgress() const
 			opt::remainingTime(currIter, pruneBeginIter, startTime, extraDuration));
 	else std::cout << "pruning";
 
-	if (currIter < discountEndIter)
+	if (currIter < discountStopIter)
 		std::cout << " | discount end: " << opt::prettyDuration(
-			opt::remainingTime(currIter, discountEndIter, startTime, extraDuration)) << "\n\n";
+			opt::remainingTime(currIter, discountStopIter, startTime, extraDuration)) << "\n\n";
 	else std::cout << " | no discount\n\n";
 
 	std::cout
 		<< "nodes: " << opt::prettyNumDg(nodesCount, 3)
 		<< " | unique nodes: " << opt::prettyNumDg(nodesUniqueCount, 3)
 		<< " / " << opt::prettyNumDg(totUniqueNodes, 3)
-		<< " (" << opt::prettyPerc(nodesUniqueCount, totUniqueNodes) << ")\n\n";
+		<< " (" << opt::prettyPerc(nodesUniqueCount, totUniqueNodes) << ")\n";
+
+	std::cout
+		<< "regrets: " << opt::prettyNum(regrets.memoryUsed(), 1, true) << "o"
+		<< " / " << opt::prettyNum(regrets.nBytes(), 1, true) << "o dense\n";
+
+	std::cout << "pruned subtrees:";
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		std::cout << (r ? " |" : "") << " " << egn::roundToString(r) << " "
+			<< opt::prettyNumDg(prunedSubtrees[r], 3)
+			<< " (~" << opt::prettyNumDg(savedNodes(r), 3) << " nodes)";
+	}
+	std::cout << "\n\n";
 
 	std::cout << "VM: " << opt::vmUsedByMeStr(1) << " | RAM: " << opt::ramUsedByMeStr(1) << "\n";
 
@@ -769,4 +1565,71 @@ void BlueprintCalculator::printFinalStats() const
 	std::cout << "\nDuration: " << opt::prettyDuration(extraDuration + opt::getDuration(startTime)) << "\n";
 }
 
+// Append one JSON line with the statistics of the last print period
+// to the metrics file. The line is written by metricsWriter's thread.
+void BlueprintCalculator::writeMetrics()
+{
+	const double duration = extraDuration + opt::getDuration(startTime);
+	const double periodDuration = duration - lastMetricsDuration;
+	const uint64_t periodIters = currIter - lastMetricsIter;
+
+	std::array<double, egn::N_ROUNDS> nodesPerSec, roundSavedNodes;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		nodesPerSec[r] = roundNodesCount[r] / periodDuration;
+		roundSavedNodes[r] = savedNodes(r);
+	}
+
+	opt::JsonLine line;
+	line.add("iter", currIter)
+		.add("time", duration)
+		.add("itPerSec", periodIters / periodDuration)
+		.addArray("nodesPerSec", nodesPerSec)
+		.add("nodes", nodesCount)
+		.add("uniqueNodes", nodesUniqueCount)
+		.add("uniqueNodesRatio", (double)nodesUniqueCount / totUniqueNodes)
+		.add("pruneRatio", periodIters ? (double)nPrunedIters / periodIters : 0.0)
+		.addArray("prunedSubtrees", prunedSubtrees)
+		.addArray("savedNodes", roundSavedNodes)
+		.add("snapshotDuration", snapshotDuration)
+		.add("avgSnapshotsDuration", avgSnapshotsDuration)
+		.add("evalDuration", evalDuration)
+		.add("checkpointDuration", checkpointDuration)
+		.add("regretsMemory", (uint64_t)regrets.memoryUsed())
+		.add("vrVarianceRatio", vrRawSqErr ? vrCvSqErr / vrRawSqErr : 1.0)
+		.add("ram", (uint64_t)opt::physMemUsedByMe())
+		.add("vm", (uint64_t)opt::virtualMemUsedByMe());
+	if (newEval) {
+		line.add("evalSnapshots", nSnapshotsUsedForEval.back())
+			.add("gainAvg", gainsAvg.back())
+			.add("gainStd", gainsStd.back());
+	}
+	metricsWriter.write(line.str());
+	lastMetricsIter = currIter;
+	lastMetricsDuration = duration;
+}
+
+// Estimate the nodes skipped by the pruned subtrees of roundId during the period
+// with the average size of the subtrees explored from the same round.
+double BlueprintCalculator::savedNodes(uint8_t roundId) const
+{
+	if (!exploredSubtrees[roundId]) return 0;
+	return (double)prunedSubtrees[roundId] * exploredSubtreeNodes[roundId] / exploredSubtrees[roundId];
+}
+
+void BlueprintCalculator::resetPeriodStats()
+{
+	roundNodesCount.fill(0);
+	prunedSubtrees.fill(0);
+	exploredSubtrees.fill(0);
+	exploredSubtreeNodes.fill(0);
+	nPrunedIters = 0;
+	snapshotDuration = 0;
+	avgSnapshotsDuration = 0;
+	evalDuration = 0;
+	checkpointDuration = 0;
+	newEval = false;
+	vrRawSqErr = 0;
+	vrCvSqErr = 0;
+}
+
 } // bp
\ No newline at end of file
@@ -2,7 +2,12 @@
 #define BP_BLUEPRINTCALCULATOR_H
 
 #include "Constants.h"
+#include "RegretTable.h"
+#include "MappedCheckpoint.h"
+#include "RegretShards.h"
+#include "TrainControl.h"
 #include "EvalBlueprintAI.h"
+#include "AsyncEvaluator.h"
 #include "../AbstractInfoset/AbstractInfoset.h"
 #include "../AbstractInfoset/AbstractInfosetDebug.h"
 #include "../AbstractInfoset/GroupedActionSeqsInv.h"
@@ -10,8 +15,16 @@
 #include "../Utils/Progression.h"
 #include "../Utils/HardwareUsage.h"
 #include "../Utils/ioVar.h"
+#include "../Utils/AsyncWriter.h"
+#include "../Utils/JsonLine.h"
+#include "../Utils/MemoryMap.h"
 #include "../Utils/VectorMemory.h"
+#include "../Utils/Compression.h"
 #include <filesystem>
+#include <thread>
+#include <optional>
+#include <memory>
+#include <bit>
 
 namespace bp {
 
@@ -19,15 +32,29 @@ typedef abc::AbstractInfoset<bckSize_t, N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N
 
 class BlueprintCalculator
 {
+	// Declared first so that the process is pinned before the other members
+	// load the lookup tables and start their threads, which inherit the affinity.
+	const bool pinned;
+
 public:
 
 	// Set rngSeed to 0 to set a random seed.
-	BlueprintCalculator(unsigned rngSeed = 0, bool verbose = true);
+	// If saveMetrics is true, training statistics are appended to
+	// the metrics file at every print period.
+	// workerId is the id of the process when nTrainProcesses > 1.
+	BlueprintCalculator(
+		unsigned rngSeed = 0, bool verbose = true,
+		bool saveMetrics = true, unsigned workerId = 0);
 
 	// Conduct MCCFR and save the final strategy to the disk.
 	void buildStrategy();
 	void oneIter();
 
+	// Whether the regrets are discounted after the traversals of iteration iter.
+	static bool mustDiscount(uint64_t iter);
+	// Number of discountings done once n iterations are done.
+	static uint32_t discountEpoch(uint64_t n);
+
 	uint64_t currIter;
 
 	abcInfo_t abcInfo;
@@ -37,54 +64,115 @@ private:
 	typedef omp::XoroShiro128Plus Rng;
 
 	std::array<uint16_t, 2> buildPruneCumWeights();
+	static unsigned workerSeed(unsigned rngSeed, unsigned workerId);
+	static bool pinProcess(unsigned workerId);
+
+	void traverseIter();
+	void setDiscountFactors();
+	void runPeriodicTasks();
+	uint64_t nextTasksIter(uint64_t n) const;
 
 	uint8_t nActions() const;
-	regret_t& getRegret(uint8_t actionId);
+	// Only for the updates: a sparse regret is inserted on its first access.
+	regret_t& regretRef(uint8_t actionId);
 	const regret_t getRegret(uint8_t actionId) const;
+	void markDirty(uint8_t actionId);
+	prunedMask_t& prunedMask();
 	void calculateCumRegrets();
 	int64_t calculateSumRegrets() const;
 
 	void applyDiscounting();
+	void discountPreflopStrat(uint32_t epoch);
+	void updatePreflopStrat(uint8_t traverser);
+	size_t preflopStratSize() const;
+	void savePreflopStratSum() const;
+	void commitPreflopStratSum() const;
+	void loadPreflopStratSum();
 	void traverseMCCFR(uint8_t traverser);
 	void traverseMCCFRP(uint8_t traverser);
 	egn::dchips calculateExpectedValue() const;
 	egn::dchips calculateExpectedValueP() const;
 
+	void beginEdge();
+	egn::dchips endEdge(egn::dchips v);
+	void pushOppNode(uint8_t traverser, uint8_t actionId);
+	egn::dchips correctValue(egn::dchips v, size_t oppNodesBegin);
+
 	void incrNodesCount(uint8_t actionId);
 	uint64_t getNUniqueNodes() const;
 
 	void takeSnapshot();
+	void snapshotRound(uint8_t roundId);
+	void loadLastSnapshot();
 	void averageSnapshots();
+	void averagePreflopStrat(std::vector<std::vector<sumStrat_t>>& strats) const;
 	void evaluateStrategy();
+	void collectEvaluations();
 
 	void writeConstants() const;
 	void verifyConstants() const;
 	template<typename T>
 	void verifyOneConstant(std::ifstream& file, const T& v) const;
+	template<typename T>
+	void verifyNamedConstant(std::ifstream& file, const char* name, const T& v, const T& oldValue) const;
 
 	void updateCheckpoint();
 	void loadCheckpoint(std::fstream& file);
+	void saveState(std::fstream& file) const;
+	void loadState(std::fstream& file);
+
+	bool isLeader() const;
+	void attachSharedRegrets();
+	void publishSharedState();
+	void waitSharedState();
+	void buildStrategyShared();
+	void runSharedTasks(uint64_t iter);
+	void releaseDeadWorkers();
+	void flushSharedCounters();
+	void syncSharedCounters();
 
 	void printProgress() const;
 	void printStratEval() const;
 	void printFinalStats() const;
 
+	void writeMetrics();
+	double savedNodes(uint8_t roundId) const;
+	void resetPeriodStats();
+
 	bool verbose;
+	bool saveMetrics;
+	const unsigned workerId;
 
 	Rng rng;
-	static opt::FastRandomChoice<8> pruneRandChoice;
-	static opt::FastRandomChoiceRNGRescale<16> actionRandChoice;
+	opt::FastRandomChoice<8> pruneRandChoice;
+	opt::FastRandomChoiceRNGRescale<16> actionRandChoice;
 	static const opt::FastRandomChoice<> cumWeightsRescaler;
 	const std::array<uint16_t, 2> pruneCumWeights;
 	std::vector<uint64_t> cumRegrets;
 
-	regrets_t regrets;
+	RegretTable regrets;
+	// Used when mappedCheckpoint is true.
+	MappedCheckpoint mappedCkpt;
+
+	// Used when nTrainProcesses > 1.
+	opt::MemoryMap sharedMem;
+	TrainControl* ctrl;
+	uint64_t flushedNodesCount;
+	uint64_t flushedNodesUniqueCount;
+	static const uint64_t workerTimeoutMs = 60000;
 
 	double extraDuration;
 	opt::time_t startTime;
 	unsigned nextSnapshotId;
+	// Used when compressedSnapshots is true.
+	std::array<std::vector<strat_t>, egn::N_ROUNDS> lastSnapshot;
 	uint64_t lastCheckpointIter;
 
+	// Counts of the actions sampled at the preflop infosets, with the
+	// layout of the preflop regrets. Used when preflopStratPeriod is not 0.
+	std::vector<uint32_t> ownedPreflopStratSum;
+	uint32_t* preflopStratSum;
+
 	abc::GroupedActionSeqs gpSeqs;
 	abc::GroupedActionSeqsInv gpSeqsInv;
 
@@ -94,7 +182,30 @@ private:
 	opt::FastVector<abcInfo_t> hist;
 	std::vector<bool> lastChild;
 	std::vector<egn::dchips> expVals;
-	std::vector<bool> visited;
+	// Actions skipped by pruning at the nodes of hist, one bit per action.
+	std::vector<prunedMask_t> skippedMasks;
+
+	// Used when vrBaselineRounds > 0.
+	struct OppNode
+	{
+		float* baseline;
+		// Expected baseline of the node under the current strategy.
+		float expBaseline;
+	};
+	std::array<std::vector<float>, egn::N_ROUNDS> baselines;
+	// Opponents' nodes sampled on the edges of the traverser being explored.
+	std::vector<OppNode> oppNodes;
+
+	// Edges of the traverser being explored.
+	struct Edge
+	{
+		// Index of the first opponent's node of the edge.
+		size_t oppNodesBegin;
+		// nodesCount before the edge.
+		uint64_t nodesBegin;
+		uint8_t roundId;
+	};
+	std::vector<Edge> edges;
 
 	uint64_t nodesCount;
 	uint64_t nodesUniqueCount;
@@ -102,6 +213,30 @@ private:
 
 	std::vector<float> gainsAvg, gainsStd;
 	std::vector<uint64_t> nSnapshotsUsedForEval;
+	// Used when nEvalThreads > 0.
+	std::unique_ptr<AsyncEvaluator> evaluator;
+	strats_t avgStrat;
+
+	// Statistics of the current print period written to the metrics file.
+	opt::AsyncWriter metricsWriter;
+	std::array<uint64_t, egn::N_ROUNDS> roundNodesCount;
+	// Children of the traverser skipped by the pruning, and number and
+	// total size of the subtrees explored, per round of their parent.
+	std::array<uint64_t, egn::N_ROUNDS> prunedSubtrees;
+	std::array<uint64_t, egn::N_ROUNDS> exploredSubtrees;
+	std::array<uint64_t, egn::N_ROUNDS> exploredSubtreeNodes;
+	uint64_t nPrunedIters;
+	uint64_t lastMetricsIter;
+	double lastMetricsDuration;
+	double snapshotDuration;
+	double avgSnapshotsDuration;
+	double evalDuration;
+	double checkpointDuration;
+	bool newEval;
+	// Squared errors of the sampled values against the expected baselines,
+	// without and with the correction. Their ratio measures the variance reduction.
+	double vrRawSqErr;
+	double vrCvSqErr;
 
 	static const std::string printSep;
 
@@ -0,0 +1,285 @@
+#include "CheckpointMerger.h"
+
+namespace bp {
+
+CheckpointMerger::CheckpointMerger(
+	const std::vector<std::string>& runDirs,
+	const std::vector<double>& weights,
+	unsigned nThreads) :
+
+	runDirs(runDirs),
+	weights(weights),
+	nThreads((std::max)(nThreads, 1u))
+{
+	if (runDirs.empty())
+		throw std::runtime_error("No run to merge.");
+	if (!weights.empty() && weights.size() != runDirs.size())
+		throw std::runtime_error("There must be one weight per run.");
+	// The merged checkpoint would overwrite the one of the run.
+	for (const std::string& runDir : runDirs) {
+		if (std::filesystem::weakly_canonical(runDir) == std::filesystem::weakly_canonical(blueprintDir()))
+			throw std::runtime_error("A run cannot be in the directory of the merged blueprint.");
+	}
+
+	const abc::ActionSeqSize seqSizes(BLUEPRINT_GAME_NAME);
+	regrets.setLayout(
+		{ N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER },
+		{ seqSizes.preflopSize, seqSizes.flopSize, seqSizes.turnSize, seqSizes.riverSize });
+}
+
+void CheckpointMerger::merge()
+{
+	verifyConstants();
+	loadRunStates();
+
+	// Weight each run by its number of iterations by default.
+	if (weights.empty()) {
+		for (const RunState& state : states)
+			weights.push_back((double)state.currIter);
+	}
+	double sumWeights = 0;
+	for (const double w : weights) sumWeights += w;
+	if (sumWeights <= 0)
+		throw std::runtime_error("The sum of the weights must be positive.");
+	for (double& w : weights) w /= sumWeights;
+
+	// A resume would pick a mapped or sharded checkpoint, or a journal,
+	// already there before the merged one.
+	if (std::filesystem::exists(blueprintTmpDir()) && !std::filesystem::is_empty(blueprintTmpDir()))
+		throw std::runtime_error("The tmp directory of the merged blueprint must be empty.");
+
+	std::filesystem::create_directory(blueprintDir());
+	std::filesystem::create_directory(blueprintTmpDir());
+
+	// The schedule of the merged run (iteration, snapshots, evaluations)
+	// is the one of the most advanced run.
+	const size_t refIdx = refRunIdx();
+	const uint64_t nodesUniqueCount = mergeRegrets(checkpointPath());
+	writeRunState(checkpointPath(), refIdx, nodesUniqueCount);
+	if (preflopStratPeriod) mergePreflopStratSums(refIdx);
+	copySnapshots(refIdx);
+	std::filesystem::copy_file(
+		runConstantPath(0), constantPath(), std::filesystem::copy_options::overwrite_existing);
+}
+
+// All the runs must have the constants of the current blueprint.
+void CheckpointMerger::verifyConstants() const
+{
+	std::ifstream refFile(runConstantPath(0));
+	std::string line;
+	std::getline(refFile, line);
+	std::ostringstream os;
+	WRITE_VAR(os, BLUEPRINT_GAME_NAME);
+	if (opt::extractVarValue(line) != opt::extractVarValue(os.str()))
+		throw std::runtime_error("The runs are not of the current blueprint.");
+
+	for (size_t i = 1; i < runDirs.size(); ++i) {
+		refFile.clear();
+		refFile.seekg(0);
+		std::ifstream file(runConstantPath(i));
+		std::string refLine;
+		while (std::getline(refFile, refLine)) {
+			if (!std::getline(file, line) || line != refLine)
+				throw std::runtime_error("A constant differs between the runs.");
+		}
+	}
+}
+
+void CheckpointMerger::loadRunStates()
+{
+	states.resize(runDirs.size());
+	for (size_t i = 0; i < runDirs.size(); ++i) {
+		// Mapped and compressed checkpoints are not supported.
+		if (!std::filesystem::exists(runCheckpointPath(i)))
+			throw std::runtime_error("A run has no checkpoint in the classic format.");
+		auto file = opt::fstream(runCheckpointPath(i), std::ios::in | std::ios::binary);
+		file.seekg(regrets.nBytes());
+
+		// Skip the random generators, saved in the same order
+		// as in BlueprintCalculator::updateCheckpoint.
+		omp::XoroShiro128Plus rng(0);
+		opt::FastRandomChoice<8> pruneRandChoice;
+		opt::FastRandomChoiceRNGRescale<16> actionRandChoice;
+		egn::GameState state;
+		rng.load(file);
+		pruneRandChoice.load(file);
+		actionRandChoice.load(file);
+		state.loadRng(file);
+
+		RunState& s = states[i];
+		s.rngStatesSize = (uint64_t)file.tellg() - regrets.nBytes();
+		opt::loadVar(s.currIter, file);
+		opt::loadVar(s.duration, file);
+		opt::loadVar(s.nextSnapshotId, file);
+		opt::loadVar(s.lastCheckpointIter, file);
+		opt::loadVar(s.nodesCount, file);
+		opt::loadVar(s.nodesUniqueCount, file);
+		size_t gainsAvgSize;
+		opt::loadVar(gainsAvgSize, file);
+		if (gainsAvgSize != 0) {
+			s.gainsAvg.resize(gainsAvgSize);
+			s.gainsStd.resize(gainsAvgSize);
+			s.nSnapshotsUsedForEval.resize(gainsAvgSize);
+			opt::load1DVector(s.gainsAvg, file);
+			opt::load1DVector(s.gainsStd, file);
+			opt::load1DVector(s.nSnapshotsUsedForEval, file);
+		}
+		if (!file)
+			throw std::runtime_error("The checkpoint of a run does not match the current blueprint.");
+		file.close();
+	}
+}
+
+size_t CheckpointMerger::refRunIdx() const
+{
+	size_t res = 0;
+	for (size_t i = 1; i < states.size(); ++i) {
+		if (states[i].currIter > states[res].currIter) res = i;
+	}
+	return res;
+}
+
+// Write the weighted average of the regrets of the runs at the beginning
+// of the file at path. The regrets are split in chunks shared by nThreads
+// threads. Return the number of non-zero merged regrets.
+uint64_t CheckpointMerger::mergeRegrets(const std::string& path) const
+{
+	std::vector<opt::MemoryMap> inputs(runDirs.size());
+	std::vector<const regret_t*> inRegrets(runDirs.size());
+	for (size_t i = 0; i < runDirs.size(); ++i) {
+		inputs[i].mapFile(runCheckpointPath(i), 0, true);
+		if (inputs[i].size() < regrets.nBytes())
+			throw std::runtime_error("The checkpoint of a run does not match the current blueprint.");
+		inRegrets[i] = (const regret_t*)inputs[i].data();
+	}
+
+	opt::MemoryMap output;
+	output.mapFile(path, regrets.nBytes());
+	regret_t* outRegrets = (regret_t*)output.data();
+
+	const size_t nChunks = (regrets.size() + chunkSize - 1) / chunkSize;
+	std::atomic<size_t> nextChunk = 0;
+	std::vector<uint64_t> nNonZeros(nThreads, 0);
+
+	auto mergeChunks = [&](unsigned threadIdx) {
+		for (size_t c = nextChunk++; c < nChunks; c = nextChunk++) {
+			const size_t end = (std::min)((c + 1) * chunkSize, regrets.size());
+			for (size_t j = c * chunkSize; j < end; ++j) {
+				double x = 0;
+				for (size_t i = 0; i < inRegrets.size(); ++i)
+					x += weights[i] * inRegrets[i][j];
+				outRegrets[j] = (regret_t)std::round(x);
+				if (outRegrets[j] != 0) ++nNonZeros[threadIdx];
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 0; t < nThreads; ++t)
+		threads.emplace_back(mergeChunks, t);
+	for (auto& t : threads) t.join();
+
+	output.flush();
+
+	uint64_t res = 0;
+	for (const uint64_t n : nNonZeros) res += n;
+	return res;
+}
+
+// Append the state of the run runIdx to the merged regrets,
+// with the nodes counts of all the runs.
+void CheckpointMerger::writeRunState(
+	const std::string& path, size_t runIdx, uint64_t nodesUniqueCount) const
+{
+	const RunState& s = states[runIdx];
+
+	std::vector<char> rngStates(s.rngStatesSize);
+	auto inFile = opt::fstream(runCheckpointPath(runIdx), std::ios::in | std::ios::binary);
+	inFile.seekg(regrets.nBytes());
+	inFile.read(rngStates.data(), rngStates.size());
+	inFile.close();
+
+	uint64_t nodesCount = 0;
+	for (const RunState& state : states) nodesCount += state.nodesCount;
+
+	auto file = opt::fstream(path, std::ios::in | std::ios::out | std::ios::binary);
+	file.seekp(regrets.nBytes());
+	file.write(rngStates.data(), rngStates.size());
+
+	opt::saveVar(s.currIter, file);
+	opt::saveVar(s.duration, file);
+	opt::saveVar(s.nextSnapshotId, file);
+	opt::saveVar(s.lastCheckpointIter, file);
+	opt::saveVar(nodesCount, file);
+	opt::saveVar(nodesUniqueCount, file);
+
+	size_t gainsAvgSize = s.gainsAvg.size();
+	opt::saveVar(gainsAvgSize, file);
+	if (gainsAvgSize != 0) {
+		opt::save1DVector(s.gainsAvg, file);
+		opt::save1DVector(s.gainsStd, file);
+		opt::save1DVector(s.nSnapshotsUsedForEval, file);
+	}
+
+	file.close();
+}
+
+// The counts of the preflop actions are averaged with the weights of the runs.
+// The runs without counts are left out and the weights of the others renormalized.
+void CheckpointMerger::mergePreflopStratSums(size_t refIdx) const
+{
+	const size_t size = regrets.nBcks(egn::PREFLOP) * regrets.rowSize(egn::PREFLOP);
+	std::vector<double> sums(size, 0);
+	std::vector<uint32_t> counts(size);
+	double sumWeights = 0;
+	for (size_t i = 0; i < runDirs.size(); ++i) {
+		const std::string runPath = runDirs[i] + "tmp/"
+			+ std::filesystem::path(preflopStratSumPath()).filename().string();
+		const std::string path = preflopStratSumFile(runPath, states[i].currIter);
+		if (path.empty()) {
+			if (std::filesystem::exists(runPath))
+				throw std::runtime_error("The preflop counts of a run are not the ones of its checkpoint.");
+			// The runs resumed from a checkpoint without the counts have none yet.
+			continue;
+		}
+		opt::BinaryReader file(path);
+		uint64_t iter;
+		file.readVar(iter);
+		file.read(std::span(counts));
+		for (size_t j = 0; j < size; ++j) sums[j] += weights[i] * counts[j];
+		sumWeights += weights[i];
+	}
+	if (sumWeights <= 0) return;
+
+	for (size_t j = 0; j < size; ++j) counts[j] = (uint32_t)std::round(sums[j] / sumWeights);
+	opt::BinaryWriter file(preflopStratSumPath());
+	file.writeVar(states[refIdx].currIter);
+	file.write(std::span(counts));
+	file.close();
+}
+
+// The snapshots already taken are the ones of the run runIdx.
+void CheckpointMerger::copySnapshots(size_t runIdx) const
+{
+	const std::string runTmpDir = runDirs[runIdx] + "tmp/";
+	for (unsigned snapshotId = 1; snapshotId < states[runIdx].nextSnapshotId; ++snapshotId) {
+		for (uint8_t r = firstSnapshotRound; r < egn::N_ROUNDS; ++r) {
+			const std::string path = snapshotPath(snapshotId, r);
+			std::filesystem::copy_file(
+				runTmpDir + std::filesystem::path(path).filename().string(), path,
+				std::filesystem::copy_options::overwrite_existing);
+		}
+	}
+}
+
+std::string CheckpointMerger::runCheckpointPath(size_t runIdx) const
+{
+	return runDirs[runIdx] + "tmp/CHECKPOINT.bin";
+}
+
+std::string CheckpointMerger::runConstantPath(size_t runIdx) const
+{
+	return runDirs[runIdx] + "CONSTANTS.txt";
+}
+
+} // bp
\ No newline at end of file
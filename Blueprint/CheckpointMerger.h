@@ -0,0 +1,77 @@
+#ifndef BP_CHECKPOINTMERGER_H
+#define BP_CHECKPOINTMERGER_H
+
+#include "RegretTable.h"
+#include "../AbstractInfoset/ActionSeqSize.h"
+#include "../Utils/MemoryMap.h"
+#include "../Utils/ioVar.h"
+#include "../Utils/ioContainer.h"
+#include "../Utils/io.h"
+#include "../Utils/Random.h"
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+namespace bp {
+
+// Merge the checkpoints of several independent runs of the current
+// blueprint (same game and build constants, different seeds) into the
+// checkpoint of the current blueprint, so that the training can resume
+// from it with BuildBlueprint. Its tmp directory must be empty.
+// Each regret is the weighted average of the regrets of the runs,
+// and so are the counts of the preflop average strategy.
+class CheckpointMerger
+{
+public:
+	// runDirs are the blueprint directories of the runs, each one holding
+	// a constants file and a checkpoint. If weights is empty, each run is
+	// weighted by its number of iterations.
+	CheckpointMerger(
+		const std::vector<std::string>& runDirs,
+		const std::vector<double>& weights = {},
+		unsigned nThreads = std::thread::hardware_concurrency());
+
+	void merge();
+
+private:
+	// Everything saved in a checkpoint after the regrets.
+	struct RunState
+	{
+		uint64_t rngStatesSize;
+		uint64_t currIter;
+		double duration;
+		unsigned nextSnapshotId;
+		uint64_t lastCheckpointIter;
+		uint64_t nodesCount;
+		uint64_t nodesUniqueCount;
+		std::vector<float> gainsAvg, gainsStd;
+		std::vector<uint64_t> nSnapshotsUsedForEval;
+	};
+
+	void verifyConstants() const;
+	void loadRunStates();
+	size_t refRunIdx() const;
+
+	uint64_t mergeRegrets(const std::string& path) const;
+	void writeRunState(const std::string& path, size_t runIdx, uint64_t nodesUniqueCount) const;
+	void mergePreflopStratSums(size_t refIdx) const;
+	void copySnapshots(size_t runIdx) const;
+
+	std::string runCheckpointPath(size_t runIdx) const;
+	std::string runConstantPath(size_t runIdx) const;
+
+	const std::vector<std::string> runDirs;
+	std::vector<double> weights;
+	const unsigned nThreads;
+
+	RegretTable regrets;
+	std::vector<RunState> states;
+
+	// Number of regrets merged at once by a thread.
+	static const size_t chunkSize = 1 << 20;
+
+}; // CheckpointMerger
+
+} // bp
+
+#endif // BP_CHECKPOINTMERGER_H
\ No newline at end of file
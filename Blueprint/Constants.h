@@ -6,6 +6,10 @@
 #include "../LosslessAbstraction/hand_index.h"
 #include "../Utils/StringManip.h"
 #include "../Utils/Constants.h"
+#include "../Utils/NumaPolicy.h"
+#include "DiscountMode.h"
+#include <filesystem>
+#include <fstream>
 
 #pragma warning(push)
 #pragma warning(disable: 4244)
@@ -262,9 +266,14 @@ static const uint64_t nSnapshots = 54; // Pluribus: 54
 static const uint64_t snapshotBeginIter = 3.2e9; // Pluribus: 3.2e9 (800 min)
 static const uint64_t snapshotPeriod = 800e6; // Pluribus: 800e6 (200 min)
 static const uint64_t avgSnapshotsPeriod = 1; // Pluribus: 54
+static const uint64_t preflopStratPeriod = 10e3; // Pluribus: 10e3
 
 static const uint64_t discountEndIter = 1.6e9; // Pluribus: 1.6e9 (400 min)
 static const uint64_t discountPeriod = 40e6; // Pluribus: 40e6 (10 min)
+static const DiscountMode discountMode = DISCOUNT_PLURIBUS;
+static const double dcfrAlpha = 1.5; // DCFR: 1.5
+static const double dcfrBeta = 0; // DCFR: 0
+static const double dcfrGamma = 2; // DCFR: 2
 
 static const uint64_t pruneBeginIter = 800e6; // Pluribus: 800e6 (200 min)
 static const uint8_t pruneProbaPerc = 95; // Pluribus: 95
@@ -277,6 +286,21 @@ static const uint64_t printPeriod = 1e6; // 1e6 (15 s)
 
 static const double evalStratDuration = 10; // in seconds
 
+static const unsigned nTrainProcesses = 1;
+static const opt::NumaPolicy regretsNumaPolicy = opt::NUMA_LOCAL;
+static const bool pinTrainProcesses = false;
+static const bool regretsOnDisk = false;
+static const uint8_t nHotRegretRounds = 2;
+static const double sparseRegretsThreshold = 0;
+static const bool mappedCheckpoint = false;
+static const bool compressedCheckpoint = false;
+static const bool compressedSnapshots = false;
+static const unsigned nEvalThreads = 0;
+static const uint8_t vrBaselineRounds = 0;
+static const double vrBaselineRate = 0.05;
+static const bool quantizedStrat = false;
+static const bool prunedStrat = false;
+
 static const uint64_t endIter = snapshotBeginIter + (nSnapshots - 1) * snapshotPeriod;
 
 // This is needed because the snapshots are not discounted.
@@ -296,9 +320,14 @@ static const uint64_t nSnapshots = 54; // Pluribus: 54
 static const uint64_t snapshotBeginIter = 3.2e9; // Pluribus: 3.2e9 (800 min)
 static const uint64_t snapshotPeriod = 800e6; // Pluribus: 800e6 (200 min)
 static const uint64_t avgSnapshotsPeriod = 1; // Pluribus: 54
+static const uint64_t preflopStratPeriod = 0; // Pluribus: 10e3
 
 static const uint64_t discountEndIter = 1.6e9; // Pluribus: 1.6e9 (400 min)
 static const uint64_t discountPeriod = 40e6; // Pluribus: 40e6 (10 min)
+static const DiscountMode discountMode = DISCOUNT_PLURIBUS;
+static const double dcfrAlpha = 1.5; // DCFR: 1.5
+static const double dcfrBeta = 0; // DCFR: 0
+static const double dcfrGamma = 2; // DCFR: 2
 
 static const uint64_t pruneBeginIter = 800e6; // Pluribus: 800e6 (200 min)
 static const uint8_t pruneProbaPerc = 95; // Pluribus: 95
@@ -311,6 +340,21 @@ static const uint64_t printPeriod = 1e6; // 1e6 (15 s)
 
 static const double evalStratDuration = 10; // in seconds
 
+static const unsigned nTrainProcesses = 1;
+static const opt::NumaPolicy regretsNumaPolicy = opt::NUMA_LOCAL;
+static const bool pinTrainProcesses = false;
+static const bool regretsOnDisk = false;
+static const uint8_t nHotRegretRounds = 2;
+static const double sparseRegretsThreshold = 0;
+static const bool mappedCheckpoint = false;
+static const bool compressedCheckpoint = false;
+static const bool compressedSnapshots = false;
+static const unsigned nEvalThreads = 0;
+static const uint8_t vrBaselineRounds = 0;
+static const double vrBaselineRate = 0.05;
+static const bool quantizedStrat = false;
+static const bool prunedStrat = false;
+
 static const uint64_t endIter = snapshotBeginIter + (nSnapshots - 1) * snapshotPeriod;
 
 // This is needed because the snapshots are not discounted.
@@ -330,9 +374,14 @@ static const uint64_t nSnapshots = 10; // Pluribus: 54
 static const uint64_t snapshotBeginIter = 260e3; // Pluribus: 3.2e9 (800 min)
 static const uint64_t snapshotPeriod = 388e3; // Pluribus: 800e6 (200 min)
 static const uint64_t avgSnapshotsPeriod = 1; // Pluribus: 54
+static const uint64_t preflopStratPeriod = 0; // Pluribus: 10e3
 
 static const uint64_t discountEndIter = 130e3; // Pluribus: 1.6e9 (400 min)
 static const uint64_t discountPeriod = 3.3e3; // Pluribus: 40e6 (10 min)
+static const DiscountMode discountMode = DISCOUNT_PLURIBUS;
+static const double dcfrAlpha = 1.5; // DCFR: 1.5
+static const double dcfrBeta = 0; // DCFR: 0
+static const double dcfrGamma = 2; // DCFR: 2
 
 static const uint64_t pruneBeginIter = 65e3; // Pluribus: 800e6 (200 min)
 static const uint8_t pruneProbaPerc = 95; // Pluribus: 95
@@ -345,6 +394,21 @@ static const uint64_t printPeriod = 10e3; // 1e6 (15 s)
 
 static const double evalStratDuration = 3; // in seconds
 
+static const unsigned nTrainProcesses = 1;
+static const opt::NumaPolicy regretsNumaPolicy = opt::NUMA_LOCAL;
+static const bool pinTrainProcesses = false;
+static const bool regretsOnDisk = false;
+static const uint8_t nHotRegretRounds = 2;
+static const double sparseRegretsThreshold = 0;
+static const bool mappedCheckpoint = false;
+static const bool compressedCheckpoint = false;
+static const bool compressedSnapshots = false;
+static const unsigned nEvalThreads = 0;
+static const uint8_t vrBaselineRounds = 0;
+static const double vrBaselineRate = 0.05;
+static const bool quantizedStrat = false;
+static const bool prunedStrat = false;
+
 static const uint64_t endIter = snapshotBeginIter + (nSnapshots - 1) * snapshotPeriod;
 
 // This is needed because the snapshots are not discounted.
@@ -364,9 +428,14 @@ static const uint64_t nSnapshots = 3; // Pluribus: 54
 static const uint64_t snapshotBeginIter = 100; // Pluribus: 3.2e9 (800 min)
 static const uint64_t snapshotPeriod = 25; // Pluribus: 800e6 (200 min)
 static const uint64_t avgSnapshotsPeriod = 1; // Pluribus: 54
+static const uint64_t preflopStratPeriod = 0; // Pluribus: 10e3
 
 static const uint64_t discountEndIter = 50; // Pluribus: 1.6e9 (400 min)
 static const uint64_t discountPeriod = 2; // Pluribus: 40e6 (10 min)
+static const DiscountMode discountMode = DISCOUNT_PLURIBUS;
+static const double dcfrAlpha = 1.5; // DCFR: 1.5
+static const double dcfrBeta = 0; // DCFR: 0
+static const double dcfrGamma = 2; // DCFR: 2
 
 static const uint64_t pruneBeginIter = 25; // Pluribus: 800e6 (200 min)
 static const uint8_t pruneProbaPerc = 95; // Pluribus: 95
@@ -379,6 +448,21 @@ static const uint64_t printPeriod = 5; // 1e6 (15 s)
 
 static const double evalStratDuration = 2; // in seconds
 
+static const unsigned nTrainProcesses = 1;
+static const opt::NumaPolicy regretsNumaPolicy = opt::NUMA_LOCAL;
+static const bool pinTrainProcesses = false;
+static const bool regretsOnDisk = false;
+static const uint8_t nHotRegretRounds = 2;
+static const double sparseRegretsThreshold = 0;
+static const bool mappedCheckpoint = false;
+static const bool compressedCheckpoint = false;
+static const bool compressedSnapshots = false;
+static const unsigned nEvalThreads = 0;
+static const uint8_t vrBaselineRounds = 0;
+static const double vrBaselineRate = 0.05;
+static const bool quantizedStrat = false;
+static const bool prunedStrat = false;
+
 static const uint64_t endIter = snapshotBeginIter + (nSnapshots - 1) * snapshotPeriod;
 
 // This is needed because the snapshots are not discounted.
@@ -398,9 +482,14 @@ static const uint64_t nSnapshots = 55; // 2.9e6 it -> 55 | 82e6 it -> 1637 // Pl
 static const uint64_t snapshotBeginIter = 200e3; // Pluribus: 3.2e9 (800 min)
 static const uint64_t snapshotPeriod = 50e3; // Pluribus: 800e6 (200 min)
 static const uint64_t avgSnapshotsPeriod = 1; // Pluribus: 54
+static const uint64_t preflopStratPeriod = 0; // Pluribus: 10e3
 
 static const uint64_t discountEndIter = 100e3; // Pluribus: 1.6e9 (400 min)
 static const uint64_t discountPeriod = 2500; // Pluribus: 40e6 (10 min)
+static const DiscountMode discountMode = DISCOUNT_PLURIBUS;
+static const double dcfrAlpha = 1.5; // DCFR: 1.5
+static const double dcfrBeta = 0; // DCFR: 0
+static const double dcfrGamma = 2; // DCFR: 2
 
 static const uint64_t pruneBeginIter = 50e3; // Pluribus: 800e6 (200 min)
 static const uint8_t pruneProbaPerc = 95; // Pluribus: 95
@@ -413,6 +502,21 @@ static const uint64_t printPeriod = 100e3; // 1e6 (15 s)
 
 static const double evalStratDuration = 3; // in seconds
 
+static const unsigned nTrainProcesses = 1;
+static const opt::NumaPolicy regretsNumaPolicy = opt::NUMA_LOCAL;
+static const bool pinTrainProcesses = false;
+static const bool regretsOnDisk = false;
+static const uint8_t nHotRegretRounds = 2;
+static const double sparseRegretsThreshold = 0;
+static const bool mappedCheckpoint = false;
+static const bool compressedCheckpoint = false;
+static const bool compressedSnapshots = false;
+static const unsigned nEvalThreads = 0;
+static const uint8_t vrBaselineRounds = 0;
+static const double vrBaselineRate = 0.05;
+static const bool quantizedStrat = false;
+static const bool prunedStrat = false;
+
 static const uint64_t endIter = snapshotBeginIter + (nSnapshots - 1) * snapshotPeriod;
 
 // This is needed because the snapshots are not discounted.
@@ -453,9 +557,22 @@ static const uint64_t nSnapshots = BP_BUILD_NAMESPACE::nSnapshots;
 static const uint64_t snapshotBeginIter = BP_BUILD_NAMESPACE::snapshotBeginIter;
 static const uint64_t snapshotPeriod = BP_BUILD_NAMESPACE::snapshotPeriod;
 static const uint64_t avgSnapshotsPeriod = BP_BUILD_NAMESPACE::avgSnapshotsPeriod;
+// If not 0, the average preflop strategy is accumulated during the training
+// instead of being averaged from snapshots: every preflopStratPeriod iterations,
+// each traverser samples one action at each of its preflop infosets and counts it.
+// Only the original build does it, like Pluribus.
+static const uint64_t preflopStratPeriod = BP_BUILD_NAMESPACE::preflopStratPeriod;
+// First round whose average strategy comes from the snapshots.
+static const uint8_t firstSnapshotRound = preflopStratPeriod ? egn::FLOP : egn::PREFLOP;
 
 static const uint64_t discountEndIter = BP_BUILD_NAMESPACE::discountEndIter;
 static const uint64_t discountPeriod = BP_BUILD_NAMESPACE::discountPeriod;
+// Schedule of the discounting and weights of the snapshots (see DiscountMode.h).
+// Except with DISCOUNT_PLURIBUS, the discounting lasts until endIter.
+static const DiscountMode discountMode = BP_BUILD_NAMESPACE::discountMode;
+static const double dcfrAlpha = BP_BUILD_NAMESPACE::dcfrAlpha;
+static const double dcfrBeta = BP_BUILD_NAMESPACE::dcfrBeta;
+static const double dcfrGamma = BP_BUILD_NAMESPACE::dcfrGamma;
 
 static const uint64_t pruneBeginIter = BP_BUILD_NAMESPACE::pruneBeginIter;
 static const uint8_t pruneProbaPerc = BP_BUILD_NAMESPACE::pruneProbaPerc;
@@ -468,8 +585,57 @@ static const uint64_t printPeriod = BP_BUILD_NAMESPACE::printPeriod;
 
 static const double evalStratDuration = BP_BUILD_NAMESPACE::evalStratDuration;
 
+// Number of processes training the blueprint together over a shared
+// memory regret table. Each one is launched with its worker id.
+static const unsigned nTrainProcesses = BP_BUILD_NAMESPACE::nTrainProcesses;
+// Placement of the regrets on the NUMA nodes. With NUMA_PARTITION, the
+// buckets of each round are split in one contiguous range per node.
+static const opt::NumaPolicy regretsNumaPolicy = BP_BUILD_NAMESPACE::regretsNumaPolicy;
+// If true, the process of worker id i runs on the cpus of node i % nNodes.
+static const bool pinTrainProcesses = BP_BUILD_NAMESPACE::pinTrainProcesses;
+// If true, the regrets are stored in a memory mapped file for abstractions
+// larger than RAM, except those of the first nHotRegretRounds rounds.
+static const bool regretsOnDisk = BP_BUILD_NAMESPACE::regretsOnDisk;
+static const uint8_t nHotRegretRounds = BP_BUILD_NAMESPACE::nHotRegretRounds;
+static_assert(!regretsOnDisk || nTrainProcesses == 1);
+// If not 0, when resuming from a checkpoint, the action sequences having
+// a non-zero regret in less than this fraction of the buckets of their round
+// are stored in a hash map. A hashed regret costs about 6 times a dense one.
+static const double sparseRegretsThreshold = BP_BUILD_NAMESPACE::sparseRegretsThreshold;
+// If true, the regrets of the checkpoint are mapped from their file instead
+// of being loaded, and only the modified ones are written at each checkpoint.
+// They go through a journal which, until discountEndIter, is as large as the regrets.
+static const bool mappedCheckpoint = BP_BUILD_NAMESPACE::mappedCheckpoint;
+// If true, the regrets of the checkpoint are saved in compressed shards
+// written in parallel, and the rest in the state file.
+static const bool compressedCheckpoint = BP_BUILD_NAMESPACE::compressedCheckpoint;
+// If true, each snapshot is saved as its XOR with the previous one,
+// compressed with zstd. The last snapshot is then kept in RAM.
+static const bool compressedSnapshots = BP_BUILD_NAMESPACE::compressedSnapshots;
+// Number of threads evaluating the averaged strategies in the background,
+// from memory. With 0, the training stops during each evaluation.
+static const unsigned nEvalThreads = BP_BUILD_NAMESPACE::nEvalThreads;
+// If not 0, the values sampled at the opponents' nodes of the first
+// vrBaselineRounds rounds are corrected with baselines (VR-MCCFR).
+// A baseline is kept for each regret of these rounds, indexed by the
+// traverser's hand bucket, and moves towards the sampled values at rate
+// vrBaselineRate. Each process has its own, which are not checkpointed.
+static const uint8_t vrBaselineRounds = BP_BUILD_NAMESPACE::vrBaselineRounds;
+static const double vrBaselineRate = BP_BUILD_NAMESPACE::vrBaselineRate;
+static_assert(vrBaselineRounds <= egn::N_ROUNDS);
+// If true, the AI plays from quantizedStratFilePath, whose probabilities
+// take 4 bits instead of 8, halving the memory used by the strategy.
+static const bool quantizedStrat = BP_BUILD_NAMESPACE::quantizedStrat;
+// If true, the AI plays from prunedStratFilePath, which only keeps the rows
+// of the infosets reached often enough with each hand bucket.
+static const bool prunedStrat = BP_BUILD_NAMESPACE::prunedStrat;
+static_assert(!quantizedStrat || !prunedStrat);
+
 static const uint64_t endIter = BP_BUILD_NAMESPACE::endIter;
 
+// The regrets are discounted after the iterations k * discountPeriod < discountStopIter.
+static const uint64_t discountStopIter = (discountMode == DISCOUNT_PLURIBUS) ? discountEndIter : endIter;
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -508,7 +674,8 @@ static std::string snapshotPath(
 	const std::string& blueprintName, unsigned snapshotId, uint8_t roundId)
 {
 	return blueprintTmpDir(blueprintName) + "SNAPSHOT"
-		+ "_" + std::to_string(snapshotId) + "_" + opt::toUpper(egn::roundToString(roundId)) + ".bin";
+		+ "_" + std::to_string(snapshotId) + "_" + opt::toUpper(egn::roundToString(roundId))
+		+ (compressedSnapshots ? ".zst" : ".bin");
 }
 
 static std::string checkpointPath(const std::string& blueprintName)
@@ -527,6 +694,103 @@ static std::string stratPath(const std::string& blueprintName, uint8_t roundId)
 		+ "_" + opt::toUpper(egn::roundToString(roundId)) + ".bin";
 }
 
+// Strategy of all the rounds in the format of StratFile.
+static std::string stratFilePath(const std::string& blueprintName)
+{
+	return blueprintDir(blueprintName) + "STRATEGY.bin";
+}
+
+// Strategy of all the rounds in the format of StratFile, quantized to 4 bits.
+static std::string quantizedStratFilePath(const std::string& blueprintName)
+{
+	return blueprintDir(blueprintName) + "STRATEGY_Q4.bin";
+}
+
+// Strategy of all the rounds in the format of StratFile,
+// without the rows rarely reached (see ReachPruner).
+static std::string prunedStratFilePath(const std::string& blueprintName)
+{
+	return blueprintDir(blueprintName) + "STRATEGY_PRUNED.bin";
+}
+
+static std::string metricsPath(const std::string& blueprintName)
+{
+	return blueprintDir(blueprintName) + "METRICS.jsonl";
+}
+
+// Files of the checkpoint when mappedCheckpoint or compressedCheckpoint is true.
+static std::string checkpointRegretsPath(const std::string& blueprintName)
+{
+	return blueprintTmpDir(blueprintName) + "CHECKPOINT_REGRETS.bin";
+}
+
+static std::string checkpointStatePath(const std::string& blueprintName)
+{
+	return blueprintTmpDir(blueprintName) + "CHECKPOINT_STATE.bin";
+}
+
+static std::string checkpointJournalPath(const std::string& blueprintName)
+{
+	return blueprintTmpDir(blueprintName) + "CHECKPOINT_JOURNAL.bin";
+}
+
+// Files of the regrets when compressedCheckpoint is true.
+static const std::string checkpointShardPrefix = "CHECKPOINT_G";
+
+static std::string checkpointShardPath(
+	const std::string& blueprintName, uint64_t generation, uint8_t roundId, unsigned shardIdx)
+{
+	return blueprintTmpDir(blueprintName) + checkpointShardPrefix + std::to_string(generation)
+		+ "_" + opt::toUpper(egn::roundToString(roundId)) + "_" + std::to_string(shardIdx) + ".zst";
+}
+
+// Initial regrets written by WarmStartBlueprint, read when there is no checkpoint.
+static std::string warmStartPath(const std::string& blueprintName)
+{
+	return blueprintTmpDir(blueprintName) + "WARM_START.bin";
+}
+
+// Counts of the preflop actions when preflopStratPeriod is not 0.
+static std::string preflopStratSumPath(const std::string& blueprintName)
+{
+	return blueprintTmpDir(blueprintName) + "PREFLOP_STRAT_SUM.bin";
+}
+
+// The counts start with the iteration of their checkpoint. They are written
+// in path.tmp before the checkpoint and renamed to path after it.
+// Return the one of both files holding the counts of iteration iter,
+// or an empty string if none does.
+static std::string preflopStratSumFile(const std::string& path, uint64_t iter)
+{
+	for (const std::string& p : { path + ".tmp", path }) {
+		std::ifstream file(p, std::ios::binary);
+		uint64_t fileIter;
+		if (file.read((char*)&fileIter, sizeof(fileIter)) && fileIter == iter) return p;
+	}
+	return "";
+}
+
+// File backing the regrets when regretsOnDisk is true.
+// It should be on a fast disk.
+static std::string regretsPath(const std::string& blueprintName)
+{
+	return blueprintTmpDir(blueprintName) + "REGRETS.bin";
+}
+
+// Name of the shared memory segment holding the regrets
+// when several processes train the blueprint.
+static std::string sharedRegretsName(const std::string& blueprintName)
+{
+	return blueprintName + "_REGRETS";
+}
+
+// Socket at which StratServer serves the advices of the blueprint. It is in the
+// temporary directory because the path of a socket is limited to about 100 characters.
+static std::string stratServerSocketPath(const std::string& blueprintName)
+{
+	return (std::filesystem::temp_directory_path() / (blueprintName + "_STRAT.sock")).string();
+}
+
 static std::string blueprintDir()
 {
 	return blueprintDir(blueprintName());
@@ -557,6 +821,66 @@ static std::string stratPath(uint8_t roundId)
 	return stratPath(blueprintName(), roundId);
 }
 
+static std::string stratFilePath()
+{
+	return stratFilePath(blueprintName());
+}
+
+static std::string quantizedStratFilePath()
+{
+	return quantizedStratFilePath(blueprintName());
+}
+
+static std::string prunedStratFilePath()
+{
+	return prunedStratFilePath(blueprintName());
+}
+
+static std::string metricsPath()
+{
+	return metricsPath(blueprintName());
+}
+
+static std::string checkpointRegretsPath()
+{
+	return checkpointRegretsPath(blueprintName());
+}
+
+static std::string checkpointStatePath()
+{
+	return checkpointStatePath(blueprintName());
+}
+
+static std::string checkpointJournalPath()
+{
+	return checkpointJournalPath(blueprintName());
+}
+
+static std::string warmStartPath()
+{
+	return warmStartPath(blueprintName());
+}
+
+static std::string preflopStratSumPath()
+{
+	return preflopStratSumPath(blueprintName());
+}
+
+static std::string regretsPath()
+{
+	return regretsPath(blueprintName());
+}
+
+static std::string sharedRegretsName()
+{
+	return sharedRegretsName(blueprintName());
+}
+
+static std::string stratServerSocketPath()
+{
+	return stratServerSocketPath(blueprintName());
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -572,6 +896,10 @@ static const strat_t sumStrat = (std::numeric_limits<strat_t>::max)();
 
 static const uint8_t maxNAbcActions = 3 + maxNBetSizes;
 
+// Bitmask of the actions of an infoset.
+typedef uint16_t prunedMask_t;
+static_assert(maxNAbcActions <= 8 * sizeof(prunedMask_t));
+
 
 } // bp
 
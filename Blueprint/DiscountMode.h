@@ -0,0 +1,26 @@
+#ifndef BP_DISCOUNTMODE_H
+#define BP_DISCOUNTMODE_H
+
+#include <cstdint>
+
+namespace bp {
+
+// Weighting of the iterations in the regrets and in the average strategy.
+// The regrets are discounted every discountPeriod iterations: the k-th
+// discounting multiplies the positive regrets by dPos(k) and the negative
+// ones by dNeg(k), and the snapshot taken at iteration t is weighted by w(t).
+enum DiscountMode : uint8_t
+{
+	// dPos(k) = dNeg(k) = k / (k + 1) until discountEndIter, then no discounting.
+	// All the snapshots have the same weight.
+	DISCOUNT_PLURIBUS,
+	// dPos(k) = dNeg(k) = k / (k + 1) until the end and w(t) = t.
+	DISCOUNT_LINEAR,
+	// Discounted CFR: dPos(k) = k^a / (k^a + 1), dNeg(k) = k^b / (k^b + 1)
+	// until the end and w(t) = t^g, with a, b, g = dcfrAlpha, dcfrBeta, dcfrGamma.
+	DISCOUNT_DCFR
+};
+
+} // bp
+
+#endif // BP_DISCOUNTMODE_H
\ No newline at end of file
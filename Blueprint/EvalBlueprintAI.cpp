@@ -10,11 +10,6 @@ void BlueprintAIEvaluator::evalBlueprintAI(
     // Rng
     omp::XoroShiro128Plus rng(rngSeed);
 
-    // Initial stakes
-    std::array<egn::chips, egn::MAX_PLAYERS> initialStakes;
-    for (uint8_t i = 0; i < bp::MAX_PLAYERS; ++i)
-        initialStakes[i] = bp::INITIAL_STAKE;
-
     // Load blueprint.
     bp::Blueprint blueprint(
         bp::BP_GAME_NAMESPACE::BLUEPRINT_GAME_NAME,
@@ -22,6 +17,25 @@ void BlueprintAIEvaluator::evalBlueprintAI(
         (unsigned)rng());
     blueprint.loadStrat();
 
+    evalBlueprintAI(
+        blueprint, currDuration, gameCount,
+        gainAvg, gainStd, minAccGain,
+        endDuration, (unsigned)rng());
+}
+
+void BlueprintAIEvaluator::evalBlueprintAI(
+    const Blueprint& blueprint, double& currDuration, uint64_t& gameCount,
+    double& gainAvg, double& gainStd, double& minAccGain,
+    const double endDuration, const unsigned rngSeed)
+{
+    // Rng
+    omp::XoroShiro128Plus rng(rngSeed);
+
+    // Initial stakes
+    std::array<egn::chips, egn::MAX_PLAYERS> initialStakes;
+    for (uint8_t i = 0; i < bp::MAX_PLAYERS; ++i)
+        initialStakes[i] = bp::INITIAL_STAKE;
+
     // Blueprint AI
     auto blueprintAI = BLUEPRINT_AI_BUILDER(
         bp::BP_GAME_NAMESPACE, bp::BIG_BLIND, &blueprint, (unsigned)rng());
@@ -96,7 +110,8 @@ void BlueprintAIEvaluator::evalBlueprintAI(
 
     // Calculate stats of blueprintAI's gain.
     gainAvg /= bp::BIG_BLIND;
-    gainStd = std::sqrt(gainStd / (gameCount - 1));
+    // The variance is not defined with less than 2 games.
+    gainStd = (gameCount > 1) ? std::sqrt(gainStd / (gameCount - 1)) : 0;
     gainStd /= bp::BIG_BLIND;
     minAccGain /= bp::BIG_BLIND;
 }
@@ -115,4 +130,50 @@ void BlueprintAIEvaluator::evalBlueprintAI(
         endDuration, rngSeed);
 }
 
+void BlueprintAIEvaluator::evalBlueprintAI(
+    const strats_t& strat, double& gainAvg, double& gainStd,
+    const double endDuration, const unsigned nThreads, const unsigned rngSeed)
+{
+    std::vector<uint64_t> gameCounts(nThreads);
+    std::vector<double> gainsAvg(nThreads), gainsStd(nThreads);
+
+    // The AIs of the threads share the blueprint, each one with its own sampler.
+    bp::Blueprint blueprint(
+        bp::BP_GAME_NAMESPACE::BLUEPRINT_GAME_NAME,
+        bp::BP_BUILD_NAMESPACE::BLUEPRINT_BUILD_NAME);
+    blueprint.useStrat(&strat);
+
+    auto work = [&](unsigned threadIdx) {
+        omp::XoroShiro128Plus rng(rngSeed + threadIdx);
+
+        double currDuration = 0;
+        double minAccGain = 0;
+        evalBlueprintAI(
+            blueprint, currDuration, gameCounts[threadIdx],
+            gainsAvg[threadIdx], gainsStd[threadIdx], minAccGain,
+            endDuration, (unsigned)rng());
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < nThreads; ++i) threads.emplace_back(work, i);
+    work(0);
+    for (auto& t : threads) t.join();
+
+    // Merge the means and the variances of the threads.
+    uint64_t gameCount = 0;
+    gainAvg = 0;
+    for (unsigned i = 0; i < nThreads; ++i) {
+        gameCount += gameCounts[i];
+        gainAvg += gainsAvg[i] * gameCounts[i];
+    }
+    if (gameCount) gainAvg /= gameCount;
+    double sumSquares = 0;
+    for (unsigned i = 0; i < nThreads; ++i) {
+        if (!gameCounts[i]) continue;
+        const double delta = gainsAvg[i] - gainAvg;
+        sumSquares += gainsStd[i] * gainsStd[i] * (gameCounts[i] - 1) + delta * delta * gameCounts[i];
+    }
+    gainStd = (gameCount > 1) ? std::sqrt(sumSquares / (gameCount - 1)) : 0;
+}
+
 } // bp
\ No newline at end of file
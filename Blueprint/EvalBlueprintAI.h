@@ -1,5 +1,9 @@
+#ifndef BP_EVALBLUEPRINTAI_H
+#define BP_EVALBLUEPRINTAI_H
+
 #include "../Blueprint/BlueprintAI.h"
 #include "../RandomAI/RandomAI.h"
+#include <thread>
 
 namespace bp {
 
@@ -18,6 +22,20 @@ public:
     static void evalBlueprintAI(
         double& gainAvg, double& gainStd,
         const double endDuration, const unsigned rngSeed = 0);
+
+    // Same with a blueprint already loaded.
+    static void evalBlueprintAI(
+        const Blueprint& blueprint, double& currDuration, uint64_t& gameCount,
+        double& gainAvg, double& gainStd, double& minAccGain,
+        const double endDuration, const unsigned rngSeed = 0);
+
+    // Evaluate the strategy strat held in memory with nThreads threads
+    // playing during endDuration each.
+    static void evalBlueprintAI(
+        const strats_t& strat, double& gainAvg, double& gainStd,
+        const double endDuration, const unsigned nThreads, const unsigned rngSeed = 0);
 };
 
-} // bp
\ No newline at end of file
+} // bp
+
+#endif // BP_EVALBLUEPRINTAI_H
\ No newline at end of file
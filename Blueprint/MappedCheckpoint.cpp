@@ -0,0 +1,163 @@
+#include "MappedCheckpoint.h"
+
+namespace bp {
+
+MappedCheckpoint::MappedCheckpoint(
+	const std::string& regretsPath,
+	const std::string& statePath,
+	const std::string& journalPath) :
+
+	regretsPath(regretsPath),
+	statePath(statePath),
+	journalPath(journalPath)
+{
+}
+
+bool MappedCheckpoint::recover(const RegretTable& regrets, const std::string& classicPath)
+{
+	if (std::filesystem::exists(journalPath)) replayJournal();
+
+	if (!std::filesystem::exists(regretsPath) && std::filesystem::exists(classicPath)) {
+		std::ifstream classic(classicPath, std::ios::binary);
+		std::ofstream regretsFile(regretsPath, std::ios::binary);
+		std::ofstream stateFile(stateTmpPath(), std::ios::binary);
+		std::vector<char> buffer(1 << 24);
+		size_t left = regrets.nBytes();
+		while (left) {
+			const size_t n = (std::min)(left, buffer.size());
+			if (!classic.read(buffer.data(), n))
+				throw std::runtime_error("The classic checkpoint is too short.");
+			regretsFile.write(buffer.data(), n);
+			left -= n;
+		}
+		stateFile << classic.rdbuf();
+		stateFile.close();
+		regretsFile.close();
+		if (!stateFile || !regretsFile || !opt::syncPath(regretsPath))
+			throw std::runtime_error("The classic checkpoint could not be split.");
+		commitState();
+	}
+
+	if (std::filesystem::exists(regretsPath) && std::filesystem::file_size(regretsPath) != regrets.nBytes())
+		throw std::runtime_error("The regrets file of the checkpoint does not have the size of the regrets.");
+	return std::filesystem::exists(statePath);
+}
+
+void MappedCheckpoint::map(RegretTable& regrets)
+{
+	if (!std::filesystem::exists(regretsPath)) {
+		opt::MemoryMap file;
+		file.mapFile(regretsPath, regrets.nBytes());
+	}
+	regrets.mapPrivate(regretsPath);
+}
+
+// Journal: nChunks, stateSize, then for each dirty chunk its index and
+// its regrets, then the state and COMMIT.
+void MappedCheckpoint::commit(RegretTable& regrets)
+{
+	const auto& dirty = regrets.dirtyChunks();
+	const size_t chunkBytes = RegretTable::dirtyChunkSize * sizeof(regret_t);
+	auto chunkLen = [&](size_t i) { return (std::min)(chunkBytes, regrets.nBytes() - i * chunkBytes); };
+
+	uint64_t nChunks = 0;
+	size_t size = 3 * sizeof(uint64_t);
+	for (size_t i = 0; i < dirty.size(); ++i) {
+		if (!dirty[i]) continue;
+		++nChunks;
+		size += sizeof(uint64_t) + chunkLen(i);
+	}
+	const uint64_t stateSize = std::filesystem::file_size(stateTmpPath());
+	size += stateSize;
+	// Writing a mapped file beyond the free space would crash the process.
+	const auto dir = std::filesystem::absolute(journalPath).parent_path();
+	if (std::filesystem::space(dir).available < size)
+		throw std::runtime_error("Not enough disk space for the checkpoint journal.");
+
+	// Write the journal.
+	const std::string journalTmpPath = journalPath + ".tmp";
+	{
+		opt::MemoryMap journal;
+		journal.mapFile(journalTmpPath, size);
+		char* p = (char*)journal.data();
+		auto write = [&p](const void* src, size_t n) { std::memcpy(p, src, n); p += n; };
+
+		write(&nChunks, sizeof(nChunks));
+		write(&stateSize, sizeof(stateSize));
+		for (uint64_t i = 0; i < dirty.size(); ++i) {
+			if (!dirty[i]) continue;
+			write(&i, sizeof(i));
+			write(regrets.mappedData() + i * chunkBytes, chunkLen(i));
+		}
+		std::ifstream stateFile(stateTmpPath(), std::ios::binary);
+		stateFile.read(p, stateSize);
+		p += stateSize;
+		write(&COMMIT, sizeof(COMMIT));
+		journal.flush();
+	}
+	std::filesystem::rename(journalTmpPath, journalPath);
+	syncDir();
+
+	replayJournal();
+	regrets.clearDirty();
+}
+
+// Apply the journal to the regrets and state files, then delete it.
+// An incomplete journal is deleted without being applied.
+void MappedCheckpoint::replayJournal()
+{
+	{
+		opt::MemoryMap journal;
+		journal.mapFile(journalPath, 0, true);
+		const char* p = (const char*)journal.data();
+		const char* end = p + journal.size();
+		uint64_t commit = 0;
+		if (journal.size() >= 3 * sizeof(uint64_t))
+			std::memcpy(&commit, end - sizeof(commit), sizeof(commit));
+
+		if (commit == COMMIT) {
+			opt::MemoryMap regretsFile;
+			regretsFile.mapFile(regretsPath);
+			const size_t chunkBytes = RegretTable::dirtyChunkSize * sizeof(regret_t);
+
+			uint64_t nChunks, stateSize;
+			std::memcpy(&nChunks, p, sizeof(nChunks));
+			p += sizeof(nChunks);
+			std::memcpy(&stateSize, p, sizeof(stateSize));
+			p += sizeof(stateSize);
+			for (uint64_t c = 0; c < nChunks; ++c) {
+				uint64_t i;
+				std::memcpy(&i, p, sizeof(i));
+				p += sizeof(i);
+				const size_t len = (std::min)(chunkBytes, regretsFile.size() - i * chunkBytes);
+				std::memcpy((char*)regretsFile.data() + i * chunkBytes, p, len);
+				p += len;
+			}
+			regretsFile.flush();
+
+			std::ofstream stateFile(stateTmpPath(), std::ios::binary);
+			stateFile.write(p, stateSize);
+			stateFile.close();
+			commitState();
+		}
+	}
+	std::filesystem::remove(journalPath);
+}
+
+// The state must be on the disk before the rename, and the rename before
+// the journal is deleted.
+void MappedCheckpoint::commitState()
+{
+	if (!opt::syncPath(stateTmpPath()))
+		throw std::runtime_error("The checkpoint state could not be synced.");
+	std::filesystem::rename(stateTmpPath(), statePath);
+	syncDir();
+}
+
+void MappedCheckpoint::syncDir() const
+{
+	if (!opt::syncPath(std::filesystem::absolute(statePath).parent_path().string()))
+		throw std::runtime_error("The checkpoint folder could not be synced.");
+}
+
+} // bp
\ No newline at end of file
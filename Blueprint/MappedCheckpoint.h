@@ -0,0 +1,59 @@
+#ifndef BP_MAPPEDCHECKPOINT_H
+#define BP_MAPPEDCHECKPOINT_H
+
+#include "RegretTable.h"
+#include <filesystem>
+
+namespace bp {
+
+// Checkpoint made of a regrets file, mapped copy-on-write by the table
+// so that resuming does not read it, and of a state file holding
+// everything else. Only the chunks of regrets modified since the last
+// commit are written.
+// A commit first writes the dirty chunks and the new state in a journal,
+// which is renamed once complete. Then it applies the journal to the
+// files and deletes it. An interrupted commit is finished when recovering.
+// While the regrets are discounted (until discountEndIter), every row is
+// modified between two commits, so the journal is as large as the regrets
+// file and the disk must have room for both.
+class MappedCheckpoint
+{
+public:
+	MappedCheckpoint(
+		const std::string& regretsPath,
+		const std::string& statePath,
+		const std::string& journalPath);
+
+	// Finish an interrupted commit. If there is no regrets file yet,
+	// split the classic checkpoint at classicPath, if any, into the
+	// regrets and state files. Return whether there is a state to resume from.
+	// Throw if the files cannot be recovered.
+	bool recover(const RegretTable& regrets, const std::string& classicPath);
+
+	// Map the regrets file in regrets, creating it with zeros if needed.
+	void map(RegretTable& regrets);
+
+	// The new state must have been written in stateTmpPath().
+	// Throw if the disk has no room for the journal.
+	void commit(RegretTable& regrets);
+
+	std::string stateTmpPath() const { return statePath + ".tmp"; }
+
+	const std::string regretsPath;
+	const std::string statePath;
+
+private:
+	void replayJournal();
+	void commitState();
+	void syncDir() const;
+
+	const std::string journalPath;
+
+	// Written last in the journal.
+	static constexpr uint64_t COMMIT = 0x4250434F4D4D4954; // "BPCOMMIT"
+
+}; // MappedCheckpoint
+
+} // bp
+
+#endif // BP_MAPPEDCHECKPOINT_H
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "ReachPruner.h"
+
+namespace bp {
+
+ReachPruner::ReachPruner(unsigned nThreads, unsigned rngSeed) :
+
+	nHands(0),
+	nThreads(nThreads),
+	rng{ (!rngSeed) ? std::random_device{}() : rngSeed },
+	blueprint(BLUEPRINT_GAME_NAME, BLUEPRINT_BUILD_NAME)
+{
+	blueprint.loadStratRounds();
+
+	const abc::ActionSeqSize seqSizes(BLUEPRINT_GAME_NAME);
+	nBcks = { N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER };
+	nSeqs = { seqSizes.preflopSize, seqSizes.flopSize, seqSizes.turnSize, seqSizes.riverSize };
+
+	abc::GroupedActionSeqs gpSeqs(BLUEPRINT_GAME_NAME);
+	gpSeqs.load();
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		nInfosets[r] = gpSeqs.lens[r].size();
+		seqInfosets[r].resize(nSeqs[r]);
+		size_t groupPos = 0;
+		for (uint32_t i = 0; i < nInfosets[r]; ++i) {
+			for (uint8_t k = 0; k < gpSeqs.lens[r][i]; ++k)
+				seqInfosets[r][gpSeqs.seqs[r][groupPos + k]] = i;
+			groupPos += gpSeqs.lens[r][i];
+		}
+		counts[r].assign(nBcks[r] * nInfosets[r], 0);
+	}
+
+	// The infosets are built here since they all load the same lookup tables.
+	for (unsigned i = 0; i < nThreads; ++i) {
+		abcInfos.push_back(std::make_unique<abcInfo_t>(
+			MAX_PLAYERS, ANTE, BIG_BLIND, INITIAL_STAKE, BET_SIZES,
+			BLUEPRINT_GAME_NAME, (unsigned)rng()));
+	}
+}
+
+void ReachPruner::simulate(uint64_t nNewHands)
+{
+	std::vector<unsigned> seeds(nThreads);
+	for (unsigned& seed : seeds) seed = (unsigned)rng();
+
+	std::vector<std::thread> threads;
+	for (unsigned i = 1; i < nThreads; ++i)
+		threads.emplace_back(&ReachPruner::simulateThread, this, i, nNewHands / nThreads, seeds[i]);
+	simulateThread(0, nNewHands - (nThreads - 1) * (nNewHands / nThreads), seeds[0]);
+	for (auto& t : threads) t.join();
+	nHands += nNewHands;
+}
+
+// The counts are incremented atomically since the threads share them.
+void ReachPruner::simulateThread(unsigned threadIdx, uint64_t nThreadHands, unsigned seed)
+{
+	// Each thread has its own sampling state over the shared blueprint.
+	BlueprintSampler sampler(seed);
+	abcInfo_t& abcInfo = *abcInfos[threadIdx];
+
+	for (uint64_t h = 0; h < nThreadHands; ++h) {
+		abcInfo.resetStakes();
+		abcInfo.startNewHand(true);
+		while (!abcInfo.state.finished) {
+			const uint8_t r = abcInfo.roundIdx();
+			uint32_t& count = counts[r][
+				abcInfo.handIdx() * nInfosets[r] + seqInfosets[r][abcInfo.actionSeqIds[0]]];
+			std::atomic_ref<uint32_t>(count).fetch_add(1, std::memory_order_relaxed);
+			abcInfo.nextState(sampler.chooseAction(blueprint, abcInfo), true);
+		}
+	}
+}
+
+keptRows_t ReachPruner::keptRows(double minReach) const
+{
+	keptRows_t res;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		res[r].resize(counts[r].size());
+		for (size_t i = 0; i < counts[r].size(); ++i)
+			res[r][i] = counts[r][i] && (double)counts[r][i] >= minReach * nHands;
+	}
+	return res;
+}
+
+std::array<double, egn::N_ROUNDS> ReachPruner::keptRatios(double minReach) const
+{
+	const keptRows_t kept = keptRows(minReach);
+	std::array<double, egn::N_ROUNDS> res{};
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		if (kept[r].empty()) continue;
+		res[r] = (double)std::count(kept[r].begin(), kept[r].end(), 1) / kept[r].size();
+	}
+	return res;
+}
+
+void ReachPruner::writePrunedStrat(double minReach) const
+{
+	std::array<std::vector<double>, egn::N_ROUNDS> bckWeights;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+		bckWeights[r].assign(counts[r].begin(), counts[r].end());
+	packPrunedStratFile(BLUEPRINT_GAME_NAME, blueprintName(), nBcks, nSeqs, keptRows(minReach), bckWeights);
+}
+
+} // bp
\ No newline at end of file
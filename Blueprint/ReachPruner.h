@@ -0,0 +1,67 @@
+#ifndef BP_REACHPRUNER_H
+#define BP_REACHPRUNER_H
+
+#include "Blueprint.h"
+#include "StratFile.h"
+#include "../AbstractInfoset/AbstractInfoset.h"
+#include "../AbstractInfoset/GroupedActionSeqs.h"
+#include <thread>
+#include <memory>
+
+namespace bp {
+
+typedef abc::AbstractInfoset<bckSize_t, N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER> abcInfo_t;
+
+// Estimate the probability of reaching each infoset with each hand bucket
+// when all the players follow the blueprint, and write the strategy file
+// keeping only the rows of the infosets reached often enough, for the
+// processes serving the blueprint.
+// The probabilities are estimated by simulating hands of the blueprint
+// against itself, since the hand buckets of a player in the successive
+// rounds are not independent: the share of the hands in which a player
+// reaches an infoset with a hand bucket is its probability.
+class ReachPruner
+{
+public:
+	// Set rngSeed to 0 to set a random seed.
+	ReachPruner(unsigned nThreads, unsigned rngSeed = 0);
+
+	// Simulate nHands more hands split among the threads.
+	void simulate(uint64_t nHands);
+
+	// Write in prunedStratFilePath the strategy with only the rows reached
+	// with a probability of at least minReach. The default row of an infoset
+	// is the average of its rows weighted by their probabilities of being reached.
+	void writePrunedStrat(double minReach) const;
+
+	// Share of the rows of each round reached with a probability of at least minReach.
+	std::array<double, egn::N_ROUNDS> keptRatios(double minReach) const;
+
+	uint64_t nHands;
+
+private:
+	typedef omp::XoroShiro128Plus Rng;
+
+	void simulateThread(unsigned threadIdx, uint64_t nThreadHands, unsigned seed);
+	keptRows_t keptRows(double minReach) const;
+
+	const unsigned nThreads;
+	Rng rng;
+
+	// Shared by the threads.
+	Blueprint blueprint;
+	std::vector<std::unique_ptr<abcInfo_t>> abcInfos;
+
+	stratSizes_t nBcks;
+	stratSizes_t nSeqs;
+	stratSizes_t nInfosets;
+	std::array<std::vector<uint32_t>, egn::N_ROUNDS> seqInfosets;
+	// counts[r][b * nInfosets[r] + i] is the number of hands
+	// that reached the infoset i of round r with the hand bucket b.
+	std::array<std::vector<uint32_t>, egn::N_ROUNDS> counts;
+
+}; // ReachPruner
+
+} // bp
+
+#endif // BP_REACHPRUNER_H
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "RegretShards.h"
+
+namespace bp {
+
+// Uncompressed size of a shard.
+static const size_t shardBytes = 1 << 26;
+
+// Run f(taskIdx) for taskIdx in [0, nTasks) on nThreads threads
+// and rethrow the first exception thrown by a task.
+static void runTasks(size_t nTasks, unsigned nThreads, const std::function<void(size_t)>& f)
+{
+	std::atomic<size_t> nextTask = 0;
+	std::exception_ptr error;
+	std::mutex errorMutex;
+
+	auto work = [&]() {
+		for (size_t i = nextTask++; i < nTasks; i = nextTask++) {
+			try {
+				f(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!error) error = std::current_exception();
+				nextTask = nTasks;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < (std::min)((size_t)(std::max)(nThreads, 1u), nTasks); ++t)
+		threads.emplace_back(work);
+	work();
+	for (auto& t : threads) t.join();
+	if (error) std::rethrow_exception(error);
+}
+
+// Written first in the header.
+static const uint64_t shardsMagic = 0x4250534841524453; // "BPSHARDS"
+
+void ShardsHeader::save(std::fstream& file) const
+{
+	opt::saveVar(shardsMagic, file);
+	opt::saveVar(generation, file);
+	opt::saveArray(nShards, file);
+}
+
+bool ShardsHeader::load(std::fstream& file)
+{
+	uint64_t magic = 0;
+	file.read((char*)&magic, sizeof(magic));
+	if (!file || magic != shardsMagic) return false;
+	opt::loadVar(generation, file);
+	opt::loadArray(nShards, file);
+	return true;
+}
+
+// Read the shard shardIdx of round roundId and give its rows to
+// setRows(beginBck, endBck, rows).
+static void loadShard(
+	const std::string& blueprintName, uint64_t generation, uint8_t roundId, unsigned shardIdx,
+	size_t nBcks, size_t rowSize,
+	const std::function<void(size_t, size_t, const regret_t*)>& setRows)
+{
+	const std::string path = checkpointShardPath(blueprintName, generation, roundId, shardIdx);
+	auto file = opt::fstream(path, std::ios::in | std::ios::binary);
+	uint64_t beginBck, endBck;
+	file.read((char*)&beginBck, sizeof(beginBck));
+	file.read((char*)&endBck, sizeof(endBck));
+	if (beginBck > endBck || endBck > nBcks)
+		throw std::runtime_error("Regret shard of unexpected buckets.");
+
+	std::vector<char> compressed(std::filesystem::file_size(path) - 2 * sizeof(uint64_t));
+	file.read(compressed.data(), compressed.size());
+	file.close();
+
+	std::vector<regret_t> rows((endBck - beginBck) * rowSize);
+	opt::zstdDecompress(compressed.data(), compressed.size(), rows.data(), rows.size() * sizeof(regret_t));
+	setRows(beginBck, endBck, rows.data());
+}
+
+bool hasRegretShards(const std::string& blueprintName)
+{
+	auto file = std::fstream(checkpointStatePath(blueprintName), std::ios::in | std::ios::binary);
+	return file && ShardsHeader().load(file);
+}
+
+ShardsHeader readShardsHeader(const std::string& blueprintName)
+{
+	auto file = opt::fstream(checkpointStatePath(blueprintName), std::ios::in | std::ios::binary);
+	ShardsHeader header;
+	if (!header.load(file))
+		throw std::runtime_error("The checkpoint state does not list regret shards.");
+	return header;
+}
+
+ShardsHeader saveRegretShards(
+	const RegretTable& regrets, const std::string& blueprintName, unsigned nThreads)
+{
+	// A previous interrupted save may have left shards of this generation:
+	// they are overwritten since they were never committed.
+	ShardsHeader header;
+	header.generation = hasRegretShards(blueprintName) ? readShardsHeader(blueprintName).generation + 1 : 1;
+
+	struct Shard { uint8_t roundId; unsigned idx; uint64_t beginBck, endBck; };
+	std::vector<Shard> shards;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		const size_t rowBytes = regrets.rowSize(r) * sizeof(regret_t);
+		const size_t bcksPerShard = (std::max)(shardBytes / (std::max)(rowBytes, (size_t)1), (size_t)1);
+		for (size_t b = 0; b < regrets.nBcks(r); b += bcksPerShard)
+			shards.push_back({ r, header.nShards[r]++, b, (std::min)(b + bcksPerShard, regrets.nBcks(r)) });
+	}
+
+	runTasks(shards.size(), nThreads, [&](size_t i) {
+		const Shard& s = shards[i];
+		const auto compressed = opt::zstdCompress(
+			regrets.row(s.roundId, s.beginBck),
+			(s.endBck - s.beginBck) * regrets.rowSize(s.roundId) * sizeof(regret_t));
+		const std::string path = checkpointShardPath(blueprintName, header.generation, s.roundId, s.idx);
+		// A failed write must throw here: the state file would commit the shard
+		// and the previous generation, still valid, would be removed.
+		opt::BinaryWriter file(path, false, 1 << 16);
+		file.writeVar(s.beginBck);
+		file.writeVar(s.endBck);
+		file.write(compressed.data(), compressed.size());
+		file.close();
+		// The shards must be on the disk before the state file commits them.
+		if (!opt::syncPath(path))
+			throw std::runtime_error("Regret shard could not be synced.");
+	});
+
+	return header;
+}
+
+void removeOldRegretShards(const std::string& blueprintName)
+{
+	const std::string current = checkpointShardPrefix + std::to_string(readShardsHeader(blueprintName).generation) + "_";
+	for (const auto& entry : std::filesystem::directory_iterator(blueprintTmpDir(blueprintName))) {
+		const std::string name = entry.path().filename().string();
+		if (name.rfind(checkpointShardPrefix, 0) == 0 && name.rfind(current, 0) != 0)
+			std::filesystem::remove(entry.path());
+	}
+}
+
+void loadRegretShards(
+	RegretTable& regrets, const std::string& blueprintName, const ShardsHeader& header, unsigned nThreads)
+{
+	std::vector<std::pair<uint8_t, unsigned>> shards;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		for (unsigned i = 0; i < header.nShards[r]; ++i) shards.push_back({ r, i });
+	}
+
+	runTasks(shards.size(), nThreads, [&](size_t i) {
+		const uint8_t r = shards[i].first;
+		loadShard(blueprintName, header.generation, r, shards[i].second, regrets.nBcks(r), regrets.rowSize(r),
+			[&](size_t beginBck, size_t endBck, const regret_t* rows) {
+				std::memcpy(regrets.row(r, beginBck), rows,
+					(endBck - beginBck) * regrets.rowSize(r) * sizeof(regret_t));
+			});
+	});
+}
+
+void loadRegretShards(
+	RegretTable& regrets, const std::string& blueprintName, unsigned nThreads)
+{
+	loadRegretShards(regrets, blueprintName, readShardsHeader(blueprintName), nThreads);
+}
+
+void loadRoundShards(
+	std::vector<std::vector<regret_t>>& roundRegrets,
+	const std::string& blueprintName, uint8_t roundId, unsigned nThreads)
+{
+	const ShardsHeader header = readShardsHeader(blueprintName);
+	const size_t rowSize = roundRegrets.empty() ? 0 : roundRegrets[0].size();
+	runTasks(header.nShards[roundId], nThreads, [&](size_t i) {
+		loadShard(blueprintName, header.generation, roundId, (unsigned)i, roundRegrets.size(), rowSize,
+			[&](size_t beginBck, size_t endBck, const regret_t* rows) {
+				for (size_t b = beginBck; b < endBck; ++b)
+					std::memcpy(roundRegrets[b].data(), rows + (b - beginBck) * rowSize, rowSize * sizeof(regret_t));
+			});
+	});
+}
+
+} // bp
\ No newline at end of file
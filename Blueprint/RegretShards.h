@@ -0,0 +1,69 @@
+#ifndef BP_REGRETSHARDS_H
+#define BP_REGRETSHARDS_H
+
+#include "RegretTable.h"
+#include "../Utils/Compression.h"
+#include "../Utils/io.h"
+#include "../Utils/ioVar.h"
+#include "../Utils/ioContainer.h"
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <filesystem>
+
+namespace bp {
+
+// A compressed checkpoint stores the regrets of each round in shards
+// holding the rows of a range of buckets. A shard file starts with its
+// first and last (excluded) buckets, followed by their rows compressed
+// in one zstd frame. The shards are compressed and written, or read and
+// decompressed, by nThreads threads.
+// Each save writes the shards of a new generation, then commits them by
+// renaming the state file, which starts with a ShardsHeader naming that
+// generation. The shards of the other generations are deleted afterwards,
+// so that an interrupted save leaves the previous checkpoint whole.
+
+struct ShardsHeader
+{
+	uint64_t generation = 0;
+	std::array<uint32_t, egn::N_ROUNDS> nShards{};
+
+	void save(std::fstream& file) const;
+	// Return false if the file does not start with a header.
+	bool load(std::fstream& file);
+
+}; // ShardsHeader
+
+// Return whether the state file of the checkpoint starts with a ShardsHeader.
+bool hasRegretShards(const std::string& blueprintName);
+
+// Header of the committed shards, read from the state file.
+ShardsHeader readShardsHeader(const std::string& blueprintName);
+
+// Write the shards of the generation following the committed one
+// and return the header to write at the beginning of the new state file.
+ShardsHeader saveRegretShards(
+	const RegretTable& regrets, const std::string& blueprintName,
+	unsigned nThreads = std::thread::hardware_concurrency());
+
+// Delete the shards of the generations other than the committed one.
+void removeOldRegretShards(const std::string& blueprintName);
+
+void loadRegretShards(
+	RegretTable& regrets, const std::string& blueprintName, const ShardsHeader& header,
+	unsigned nThreads = std::thread::hardware_concurrency());
+
+void loadRegretShards(
+	RegretTable& regrets, const std::string& blueprintName,
+	unsigned nThreads = std::thread::hardware_concurrency());
+
+// Load only the regrets of round roundId, which must already be allocated.
+void loadRoundShards(
+	std::vector<std::vector<regret_t>>& roundRegrets,
+	const std::string& blueprintName, uint8_t roundId,
+	unsigned nThreads = std::thread::hardware_concurrency());
+
+} // bp
+
+#endif // BP_REGRETSHARDS_H
\ No newline at end of file
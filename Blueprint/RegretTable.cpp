@@ -0,0 +1,380 @@
+#include "RegretTable.h"
+#include <filesystem>
+#include <cmath>
+#include <chrono>
+
+namespace bp {
+
+RegretTable::RegretTable() :
+	mNHotRounds(0),
+	mRoundData{},
+	mSize(0),
+	mNBcks{},
+	mRowSizes{},
+	mRoundOffsets{},
+	mDenseRowSizes{},
+	mSparseThreshold(0),
+	mIsSparse(false),
+	mRowEpochs(nullptr),
+	mRowIdx{},
+	mNRows(0),
+	mEpoch(0),
+	mLogPosFactors(1, 0.0),
+	mLogNegFactors(1, 0.0),
+	mNInfosets{},
+	mMaskOffsets{},
+	mNMasks(0),
+	mMaskData(nullptr),
+	mPruneThreshold(0)
+{
+}
+
+void RegretTable::setLayout(const roundSizes_t& nBcks, const roundSizes_t& nSeqs)
+{
+	mNBcks = nBcks;
+	mRowSizes = nSeqs;
+	mDenseRowSizes = nSeqs;
+	mSize = 0;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		mRoundOffsets[r] = mSize;
+		mSize += mNBcks[r] * mRowSizes[r];
+	}
+	mNRows = 0;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		mRowIdx[r] = mNRows;
+		mNRows += mNBcks[r];
+	}
+	mOwnedEpochs = std::make_unique<std::atomic<uint32_t>[]>(mNRows);
+	mRowEpochs = mOwnedEpochs.get();
+	resetEpochs(0);
+}
+
+void RegretTable::allocate()
+{
+	mem.assign(mSize, 0);
+	setData(mem.data());
+}
+
+void RegretTable::attach(regret_t* data)
+{
+	opt::freeVectMem(mem);
+	setData(data);
+}
+
+void RegretTable::mapFile(const std::string& path, uint8_t nHotRounds)
+{
+	// The regrets come from the checkpoint or start at 0, so the file of a
+	// previous run is removed: only resizing it would keep its regrets.
+	std::filesystem::remove(path);
+	mFile.mapFile(path, nBytes());
+	setData((regret_t*)mFile.data());
+
+	// The hot rounds are the first ones of the file.
+	mNHotRounds = (std::min)(nHotRounds, egn::N_ROUNDS);
+	const size_t hotSize = (mNHotRounds == egn::N_ROUNDS) ? mSize : mRoundOffsets[mNHotRounds];
+	mem.assign(hotSize, 0);
+	for (uint8_t r = 0; r < mNHotRounds; ++r)
+		mRoundData[r] = mem.data() + mRoundOffsets[r];
+	if (hotSize) opt::MemoryMap::lock(mem.data(), hotSize * sizeof(regret_t));
+
+	adviseSequential(false);
+}
+
+void RegretTable::mapPrivate(const std::string& path)
+{
+	mFile.mapFile(path, nBytes(), false, true);
+	setData((regret_t*)mFile.data());
+	mDirty.assign((mSize + dirtyChunkSize - 1) / dirtyChunkSize, 0);
+}
+
+void RegretTable::setSparseThreshold(double threshold)
+{
+	mSparseThreshold = threshold;
+}
+
+void RegretTable::adviseSequential(bool sequential)
+{
+	if (!mFile.isMapped() || mNHotRounds == egn::N_ROUNDS) return;
+	const size_t offset = mRoundOffsets[mNHotRounds] * sizeof(regret_t);
+	mFile.advise(
+		sequential ? opt::MemoryMap::ADVICE_SEQUENTIAL : opt::MemoryMap::ADVICE_RANDOM,
+		offset, nBytes() - offset);
+}
+
+void RegretTable::place(opt::NumaPolicy policy)
+{
+	const unsigned nNodes = opt::numaNodesCount();
+	if (nNodes < 2) return;
+
+	bool placed = true;
+	switch (policy) {
+	case opt::NUMA_INTERLEAVE:
+		for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+			placed &= opt::interleaveMemory(mRoundData[r], roundSize(r) * sizeof(regret_t));
+		break;
+	case opt::NUMA_PARTITION:
+		// Split each round so that all the nodes get the same share
+		// of the rows of every round.
+		for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+			for (unsigned node = 0; node < nNodes; ++node) {
+				const size_t beginBck = mNBcks[r] * node / nNodes;
+				const size_t endBck = mNBcks[r] * (node + 1) / nNodes;
+				placed &= opt::bindMemory(row(r, beginBck), (endBck - beginBck) * mRowSizes[r] * sizeof(regret_t), node);
+			}
+		}
+		break;
+	default:
+		break;
+	}
+	if (!placed)
+		throw std::runtime_error("Regrets could not be placed on the NUMA nodes.");
+}
+
+void RegretTable::save(std::fstream& file) const
+{
+	if (!mIsSparse) {
+		for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+			file.write((char*)mRoundData[r], roundSize(r) * sizeof(regret_t));
+		return;
+	}
+
+	std::vector<regret_t> fullRow;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		fullRow.resize(mRowSizes[r]);
+		for (size_t b = 0; b < mNBcks[r]; ++b) {
+			for (size_t seqIdx = 0; seqIdx < mRowSizes[r]; ++seqIdx)
+				fullRow[seqIdx] = get(r, b, seqIdx);
+			file.write((char*)fullRow.data(), fullRow.size() * sizeof(regret_t));
+		}
+	}
+}
+
+void RegretTable::load(std::fstream& file)
+{
+	// The sparse mode allocates the memory itself.
+	if (mSparseThreshold > 0 && !isAllocated()) {
+		loadSparse(file);
+		return;
+	}
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+		file.read((char*)mRoundData[r], roundSize(r) * sizeof(regret_t));
+}
+
+// Read the file twice: once to choose the sparse action sequences
+// and once to fill the table. Only one row is read at a time.
+void RegretTable::loadSparse(std::fstream& file)
+{
+	const auto begin = file.tellg();
+	std::vector<regret_t> fullRow;
+
+	// Count the non-zero regrets of each action sequence.
+	std::array<std::vector<uint32_t>, egn::N_ROUNDS> nNonZeros;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		nNonZeros[r].assign(mRowSizes[r], 0);
+		fullRow.resize(mRowSizes[r]);
+		for (size_t b = 0; b < mNBcks[r]; ++b) {
+			file.read((char*)fullRow.data(), fullRow.size() * sizeof(regret_t));
+			for (size_t seqIdx = 0; seqIdx < mRowSizes[r]; ++seqIdx)
+				nNonZeros[r][seqIdx] += (fullRow[seqIdx] != 0);
+		}
+	}
+
+	// Choose the dense columns.
+	roundSizes_t denseOffsets;
+	size_t denseSize = 0;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		mSeqCols[r].assign(mRowSizes[r], SPARSE_COL);
+		uint32_t nCols = 0;
+		for (size_t seqIdx = 0; seqIdx < mRowSizes[r]; ++seqIdx) {
+			if (nNonZeros[r][seqIdx] >= mSparseThreshold * mNBcks[r])
+				mSeqCols[r][seqIdx] = nCols++;
+		}
+		mDenseRowSizes[r] = nCols;
+		denseOffsets[r] = denseSize;
+		denseSize += mNBcks[r] * nCols;
+		opt::freeVectMem(nNonZeros[r]);
+	}
+	mIsSparse = true;
+	mSparse.clear();
+	mem.assign(denseSize, 0);
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+		mRoundData[r] = mem.data() + denseOffsets[r];
+
+	// Fill the table. Zero regrets are not stored in the hash map.
+	file.seekg(begin);
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		fullRow.resize(mRowSizes[r]);
+		for (size_t b = 0; b < mNBcks[r]; ++b) {
+			file.read((char*)fullRow.data(), fullRow.size() * sizeof(regret_t));
+			for (size_t seqIdx = 0; seqIdx < mRowSizes[r]; ++seqIdx) {
+				if (fullRow[seqIdx] != 0) (*this)(r, b, seqIdx) = fullRow[seqIdx];
+			}
+		}
+	}
+}
+
+void RegretTable::setDiscountFactors(const std::vector<double>& posFactors, const std::vector<double>& negFactors)
+{
+	mLogPosFactors.assign(1, 0.0);
+	mLogNegFactors.assign(1, 0.0);
+	for (size_t k = 1; k < posFactors.size(); ++k) {
+		mLogPosFactors.push_back(mLogPosFactors.back() + std::log(posFactors[k]));
+		mLogNegFactors.push_back(mLogNegFactors.back() + std::log(negFactors[k]));
+	}
+}
+
+void RegretTable::attachEpochs(std::atomic<uint32_t>* rowEpochs)
+{
+	mOwnedEpochs.reset();
+	mRowEpochs = rowEpochs;
+}
+
+void RegretTable::resetEpochs(uint32_t epoch)
+{
+	mEpoch = epoch;
+	for (size_t i = 0; i < mNRows; ++i) mRowEpochs[i] = epoch;
+	if (!mMaskData) return;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		for (size_t b = 0; b < mNBcks[r]; ++b)
+			buildRowMasks(r, b);
+	}
+}
+
+void RegretTable::setEpoch(uint32_t epoch)
+{
+	if (epoch >= mLogPosFactors.size())
+		throw std::runtime_error("No discount factor for this epoch.");
+	if (!mIsSparse) {
+		mEpoch = epoch;
+		return;
+	}
+
+	// The hashed regrets cannot be found row by row.
+	const uint32_t prevEpoch = mEpoch;
+	mEpoch = epoch;
+	const float dPos = discountFactor(mLogPosFactors, prevEpoch);
+	const float dNeg = discountFactor(mLogNegFactors, prevEpoch);
+	mSparse.forEach([dPos, dNeg](uint64_t, regret_t& regret) {
+		regret = (regret_t)std::round(regret * ((regret > 0) ? dPos : dNeg));
+	});
+	refreshAll();
+}
+
+void RegretTable::refreshAll()
+{
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		for (size_t b = 0; b < mNBcks[r]; ++b)
+			refreshRow(r, b);
+	}
+}
+
+// Several processes can refresh the same row at the same time:
+// the first one to mark it busy discounts it while the others wait.
+// A process late by some epochs (e.g. given up by the leader) must not
+// discount the rows of the later epochs back to its own.
+void RegretTable::discountRow(uint8_t roundId, size_t bckIdx)
+{
+	std::atomic<uint32_t>& rowEpoch = mRowEpochs[mRowIdx[roundId] + bckIdx];
+	std::chrono::steady_clock::time_point busySince;
+	bool waiting = false;
+	while (true) {
+		uint32_t epoch = rowEpoch.load();
+		if ((epoch & ~BUSY_EPOCH) >= mEpoch) return;
+		if (epoch & BUSY_EPOCH) {
+			const auto now = std::chrono::steady_clock::now();
+			if (!waiting) {
+				busySince = now;
+				waiting = true;
+			}
+			else if (now - busySince > std::chrono::milliseconds(busyRowTimeoutMs))
+				throw std::runtime_error("A row of the regrets stayed busy: a process died while discounting it.");
+			std::this_thread::yield();
+			continue;
+		}
+		if (!rowEpoch.compare_exchange_weak(epoch, epoch | BUSY_EPOCH)) continue;
+
+		const float dPos = discountFactor(mLogPosFactors, epoch);
+		const float dNeg = discountFactor(mLogNegFactors, epoch);
+		regret_t* regrets = row(roundId, bckIdx);
+		for (size_t i = 0; i < mDenseRowSizes[roundId]; ++i)
+			regrets[i] = (regret_t)std::round(regrets[i] * ((regrets[i] > 0) ? dPos : dNeg));
+
+		if (mMaskData) buildRowMasks(roundId, bckIdx);
+		if (!mDirty.empty()) {
+			const size_t begin = mRoundOffsets[roundId] + bckIdx * mRowSizes[roundId];
+			std::fill(
+				mDirty.begin() + begin / dirtyChunkSize,
+				mDirty.begin() + (begin + mRowSizes[roundId] + dirtyChunkSize - 1) / dirtyChunkSize, 1);
+		}
+		rowEpoch.store(mEpoch, std::memory_order_release);
+		return;
+	}
+}
+
+void RegretTable::setPruneMasks(
+	const std::vector<std::vector<uint32_t>>& gpSeqs,
+	const std::vector<std::vector<uint8_t>>& gpLens,
+	regret_t threshold)
+{
+	mPruneThreshold = threshold;
+	mNMasks = 0;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		mInfosetSeqs[r] = gpSeqs[r];
+		mSeqInfosets[r].resize(mRowSizes[r]);
+		mInfosetBegins[r].assign(1, 0);
+		for (uint32_t infosetIdx = 0; infosetIdx < gpLens[r].size(); ++infosetIdx) {
+			const size_t begin = mInfosetBegins[r].back();
+			for (size_t i = begin; i < begin + gpLens[r][infosetIdx]; ++i)
+				mSeqInfosets[r][gpSeqs[r][i]] = infosetIdx;
+			mInfosetBegins[r].push_back(begin + gpLens[r][infosetIdx]);
+		}
+		mNInfosets[r] = gpLens[r].size();
+		mMaskOffsets[r] = mNMasks;
+		mNMasks += mNBcks[r] * mNInfosets[r];
+	}
+	mMasks.assign(mNMasks, 0);
+	mMaskData = mMasks.data();
+}
+
+void RegretTable::attachMasks(prunedMask_t* masks)
+{
+	opt::freeVectMem(mMasks);
+	mMaskData = masks;
+}
+
+// The actions of an infoset are in the order of their sequences in its group.
+void RegretTable::buildRowMasks(uint8_t roundId, size_t bckIdx)
+{
+	prunedMask_t* masks = mMaskData + mMaskOffsets[roundId] + bckIdx * mNInfosets[roundId];
+	const std::vector<size_t>& begins = mInfosetBegins[roundId];
+	for (size_t infosetIdx = 0; infosetIdx < mNInfosets[roundId]; ++infosetIdx) {
+		prunedMask_t mask = 0;
+		for (size_t i = begins[infosetIdx]; i < begins[infosetIdx + 1]; ++i)
+			updatePrunedBit(mask, (uint8_t)(i - begins[infosetIdx]), get(roundId, bckIdx, mInfosetSeqs[roundId][i]));
+		masks[infosetIdx] = mask;
+	}
+}
+
+// Product of the factors of the epochs after fromEpoch up to the current one.
+float RegretTable::discountFactor(const std::vector<double>& logFactors, uint32_t fromEpoch) const
+{
+	return (float)std::exp(logFactors[mEpoch] - logFactors[fromEpoch]);
+}
+
+size_t RegretTable::memoryUsed() const
+{
+	// Attached memory is not owned by the table but still used.
+	if (mem.empty() && !mFile.isMapped()) return nBytes();
+	// The cold rounds mapped from a file are not counted.
+	size_t res = mem.size() * sizeof(regret_t) + mSparse.nBytes();
+	for (const auto& seqCols : mSeqCols) res += seqCols.size() * sizeof(uint32_t);
+	return res;
+}
+
+void RegretTable::setData(regret_t* data)
+{
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+		mRoundData[r] = data + mRoundOffsets[r];
+}
+
+} // bp
\ No newline at end of file
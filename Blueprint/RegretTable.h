@@ -0,0 +1,265 @@
+#ifndef BP_REGRETTABLE_H
+#define BP_REGRETTABLE_H
+
+#include "Constants.h"
+#include "../Utils/VectorMemory.h"
+#include "../Utils/Numa.h"
+#include "../Utils/MemoryMap.h"
+#include "../Utils/OpenHashMap.h"
+#include <array>
+#include <fstream>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace bp {
+
+// Regrets of all (round, hand bucket, action sequence) stored in one
+// contiguous array, round by round and bucket by bucket.
+// Its layout is the same as the one of a regrets_t written with
+// opt::save3DVector, so both can be read from the same files.
+// The memory can be owned by the table, provided by the caller
+// (e.g. a shared memory segment) or mapped from a file when the table
+// does not fit in RAM. In that case, the first rounds can be kept in RAM.
+// In sparse mode, the action sequences whose regrets are rarely non-zero
+// are stored in a hash map instead of a dense column.
+// The discounting is lazy: each row (round, hand bucket) remembers the
+// epoch of its last discounting and catches up with the current one
+// when refreshed, so that no pass over the whole table is needed.
+// The table can also keep for each infoset the bitmask of its actions
+// whose regret is below the pruning threshold.
+class RegretTable
+{
+public:
+	typedef std::array<size_t, egn::N_ROUNDS> roundSizes_t;
+
+	RegretTable();
+
+	// nBcks[r] and nSeqs[r] are the number of hand buckets and
+	// action sequences of round r.
+	void setLayout(const roundSizes_t& nBcks, const roundSizes_t& nSeqs);
+
+	// Allocate the table in private memory with all regrets set to 0.
+	void allocate();
+
+	// Use memory owned by the caller of at least nBytes() bytes.
+	void attach(regret_t* data);
+
+	// Map the table from the file at path, created if needed. The rounds
+	// before nHotRounds are copied in RAM, locked there if possible, and
+	// are not written back to the file.
+	void mapFile(const std::string& path, uint8_t nHotRounds);
+
+	// Store in the hash map the action sequences having a non-zero regret
+	// in less than threshold * nBcks buckets when loading the table.
+	// The statistics of the loaded regrets are used to choose them, so the
+	// table must be loaded before being allocated: only its dense columns
+	// are then allocated. A table allocated first stays dense.
+	void setSparseThreshold(double threshold);
+
+	// False until the table is allocated, attached, mapped or loaded in sparse mode.
+	bool isAllocated() const { return mIsSparse || mRoundData[0] != nullptr; }
+
+	// Map the table from the file at path copy-on-write: the file is only read
+	// when a page is first accessed and the writes stay private to the process.
+	// The chunks modified since the last clearDirty() are tracked so that only
+	// them can be written back to the file.
+	void mapPrivate(const std::string& path);
+
+	// To be called after each write in a privately mapped table.
+	void markDirty(uint8_t roundId, size_t bckIdx, size_t seqIdx)
+	{
+		if (mDirty.empty()) return;
+		mDirty[(mRoundOffsets[roundId] + bckIdx * mRowSizes[roundId] + seqIdx) / dirtyChunkSize] = 1;
+	}
+
+	// dirtyChunks()[i] is 1 if the chunk i of a privately mapped table was modified.
+	const std::vector<uint8_t>& dirtyChunks() const { return mDirty; }
+	void clearDirty() { std::fill(mDirty.begin(), mDirty.end(), 0); }
+	void markAllDirty() { std::fill(mDirty.begin(), mDirty.end(), 1); }
+	const char* mappedData() const { return (const char*)mFile.data(); }
+
+	// Number of regrets per dirty chunk.
+	static constexpr size_t dirtyChunkSize = 1 << 14;
+
+	// Tell the system whether the mapped rounds are about to be read
+	// sequentially (e.g. for the discounting) or at random (traversals).
+	void adviseSequential(bool sequential);
+
+	// Move the regrets on the NUMA nodes according to policy.
+	void place(opt::NumaPolicy policy);
+
+	// Files always have the dense layout.
+	void save(std::fstream& file) const;
+	void load(std::fstream& file);
+
+	// posFactors[k] and negFactors[k] multiply the positive and the negative
+	// regrets at the discounting epoch k >= 1.
+	void setDiscountFactors(const std::vector<double>& posFactors, const std::vector<double>& negFactors);
+
+	// Use an array of nRows() row epochs owned by the caller
+	// (e.g. in the shared memory segment).
+	void attachEpochs(std::atomic<uint32_t>* rowEpochs);
+
+	// Set the current epoch and all the rows to it, e.g. after loading the table.
+	void resetEpochs(uint32_t epoch);
+
+	// Move to a later epoch. The rows are discounted when refreshed,
+	// except in sparse mode where the whole table is discounted now.
+	void setEpoch(uint32_t epoch);
+	uint32_t epoch() const { return mEpoch; }
+
+	// To be called before accessing the row of bckIdx.
+	void refreshRow(uint8_t roundId, size_t bckIdx)
+	{
+		if (mRowEpochs[mRowIdx[roundId] + bckIdx].load(std::memory_order_acquire) != mEpoch)
+			discountRow(roundId, bckIdx);
+	}
+
+	// Discount all the rows late, e.g. before saving the table.
+	void refreshAll();
+
+	// Number of rows of all rounds.
+	size_t nRows() const { return mNRows; }
+
+	// Keep the pruned masks of the infosets given by the groups of GroupedActionSeqs:
+	// the bit a of a mask is set if the regret of the a-th action is <= threshold.
+	// The masks are rebuilt when a row is discounted or its epochs are reset.
+	void setPruneMasks(
+		const std::vector<std::vector<uint32_t>>& gpSeqs,
+		const std::vector<std::vector<uint8_t>>& gpLens,
+		regret_t threshold);
+
+	// Use memory owned by the caller of at least masksBytes() bytes.
+	void attachMasks(prunedMask_t* masks);
+	size_t masksBytes() const { return mNMasks * sizeof(prunedMask_t); }
+
+	// Pruned mask of the infoset of the action sequence seqIdx.
+	prunedMask_t& prunedMask(uint8_t roundId, size_t bckIdx, size_t seqIdx)
+	{
+		return mMaskData[mMaskOffsets[roundId] + bckIdx * mNInfosets[roundId] + mSeqInfosets[roundId][seqIdx]];
+	}
+
+	// To be called after each write of the regret of the a-th action of an infoset.
+	void updatePrunedBit(prunedMask_t& mask, uint8_t a, regret_t regret) const
+	{
+		if (regret <= mPruneThreshold) mask |= (prunedMask_t)(1u << a);
+		else mask &= (prunedMask_t)~(1u << a);
+	}
+
+	// Row of the dense columns.
+	regret_t* row(uint8_t roundId, size_t bckIdx)
+	{
+		return mRoundData[roundId] + bckIdx * mDenseRowSizes[roundId];
+	}
+
+	const regret_t* row(uint8_t roundId, size_t bckIdx) const
+	{
+		return mRoundData[roundId] + bckIdx * mDenseRowSizes[roundId];
+	}
+
+	// A sparse regret is inserted in the hash map on its first access,
+	// so only use it to write the regret.
+	regret_t& operator()(uint8_t roundId, size_t bckIdx, size_t seqIdx)
+	{
+		if (!mIsSparse) return row(roundId, bckIdx)[seqIdx];
+		const uint32_t col = mSeqCols[roundId][seqIdx];
+		if (col != SPARSE_COL) return row(roundId, bckIdx)[col];
+		return mSparse[sparseKey(roundId, bckIdx, seqIdx)];
+	}
+
+	// Use it to read a regret without inserting it in the hash map.
+	regret_t get(uint8_t roundId, size_t bckIdx, size_t seqIdx) const
+	{
+		if (!mIsSparse) return row(roundId, bckIdx)[seqIdx];
+		const uint32_t col = mSeqCols[roundId][seqIdx];
+		if (col != SPARSE_COL) return row(roundId, bckIdx)[col];
+		const regret_t* regret = mSparse.find(sparseKey(roundId, bckIdx, seqIdx));
+		return regret ? *regret : 0;
+	}
+
+	regret_t operator()(uint8_t roundId, size_t bckIdx, size_t seqIdx) const
+	{
+		return get(roundId, bckIdx, seqIdx);
+	}
+
+	// Dense part of each round. The rounds may not be contiguous with each other.
+	regret_t* roundData(uint8_t roundId) { return mRoundData[roundId]; }
+	const regret_t* roundData(uint8_t roundId) const { return mRoundData[roundId]; }
+	size_t roundSize(uint8_t roundId) const { return mNBcks[roundId] * mDenseRowSizes[roundId]; }
+
+	// Number of regrets in the table, with the dense layout.
+	size_t size() const { return mSize; }
+	size_t nBytes() const { return mSize * sizeof(regret_t); }
+
+	// Memory actually used to store the regrets.
+	size_t memoryUsed() const;
+
+	size_t nBcks(uint8_t roundId) const { return mNBcks[roundId]; }
+	size_t rowSize(uint8_t roundId) const { return mRowSizes[roundId]; }
+	size_t roundOffset(uint8_t roundId) const { return mRoundOffsets[roundId]; }
+
+private:
+	static constexpr uint32_t SPARSE_COL = ~0u;
+
+	static uint64_t sparseKey(uint8_t roundId, size_t bckIdx, size_t seqIdx)
+	{
+		return ((uint64_t)roundId << 56) | ((uint64_t)bckIdx << 32) | seqIdx;
+	}
+
+	// Set on the epoch of a row while a process discounts it.
+	static constexpr uint32_t BUSY_EPOCH = 1u << 31;
+	// A row staying busy longer was left by a process which died while discounting it.
+	static constexpr uint64_t busyRowTimeoutMs = 60000;
+
+	void setData(regret_t* data);
+	void loadSparse(std::fstream& file);
+	void discountRow(uint8_t roundId, size_t bckIdx);
+	void buildRowMasks(uint8_t roundId, size_t bckIdx);
+	float discountFactor(const std::vector<double>& logFactors, uint32_t fromEpoch) const;
+
+	std::vector<regret_t> mem;
+	opt::MemoryMap mFile;
+	uint8_t mNHotRounds;
+	std::array<regret_t*, egn::N_ROUNDS> mRoundData;
+	size_t mSize;
+
+	roundSizes_t mNBcks;
+	roundSizes_t mRowSizes;
+	roundSizes_t mRoundOffsets;
+	roundSizes_t mDenseRowSizes;
+
+	double mSparseThreshold;
+	bool mIsSparse;
+	// Dense column of each action sequence, or SPARSE_COL.
+	std::array<std::vector<uint32_t>, egn::N_ROUNDS> mSeqCols;
+	opt::OpenHashMap<regret_t> mSparse;
+
+	std::vector<uint8_t> mDirty;
+
+	// Epoch of each row, in the order of the table.
+	std::unique_ptr<std::atomic<uint32_t>[]> mOwnedEpochs;
+	std::atomic<uint32_t>* mRowEpochs;
+	roundSizes_t mRowIdx;
+	size_t mNRows;
+	uint32_t mEpoch;
+	// Cumulated sums of the logarithms of the discount factors up to each epoch.
+	std::vector<double> mLogPosFactors;
+	std::vector<double> mLogNegFactors;
+
+	// Infoset of each action sequence and sequences of each infoset.
+	std::array<std::vector<uint32_t>, egn::N_ROUNDS> mSeqInfosets;
+	std::array<std::vector<uint32_t>, egn::N_ROUNDS> mInfosetSeqs;
+	std::array<std::vector<size_t>, egn::N_ROUNDS> mInfosetBegins;
+	roundSizes_t mNInfosets;
+	roundSizes_t mMaskOffsets;
+	size_t mNMasks;
+	std::vector<prunedMask_t> mMasks;
+	prunedMask_t* mMaskData;
+	regret_t mPruneThreshold;
+
+}; // RegretTable
+
+} // bp
+
+#endif // BP_REGRETTABLE_H
\ No newline at end of file
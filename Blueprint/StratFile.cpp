@@ -0,0 +1,324 @@
+#include "StratFile.h"
+
+namespace bp {
+
+// FNV-1a, only used to detect a strategy of another game or abstraction.
+static uint64_t hashBytes(const void* data, size_t size, uint64_t h)
+{
+	for (size_t i = 0; i < size; ++i) {
+		h ^= ((const uint8_t*)data)[i];
+		h *= 0x100000001B3;
+	}
+	return h;
+}
+
+uint64_t stratConfigHash(
+	const std::string& bpGameName, const stratSizes_t& nBcks, const stratSizes_t& nSeqs)
+{
+	uint64_t h = 0xCBF29CE484222325;
+	h = hashBytes(bpGameName.data(), bpGameName.size(), h);
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		const uint64_t sizes[2] = { nBcks[r], nSeqs[r] };
+		h = hashBytes(sizes, sizeof(sizes), h);
+	}
+	return h;
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + StratFile::alignment - 1) / StratFile::alignment * StratFile::alignment;
+}
+
+// Quantize the probabilities of the infoset of row given by the groupPos-th to
+// the (groupPos + nLegalActions)-th action sequences of gpSeqs into qRow,
+// rounding their cumulated sums so that the quantized ones still sum to 15.
+static void quantizeInfoset(
+	const std::vector<strat_t>& row, const std::vector<uint32_t>& gpSeqs,
+	size_t groupPos, uint8_t nLegalActions, std::vector<uint8_t>& qRow)
+{
+	unsigned sum = 0, prevQSum = 0;
+	for (size_t i = groupPos; i < groupPos + nLegalActions; ++i) {
+		const uint32_t seqIdx = gpSeqs[i];
+		sum += row[seqIdx];
+		const unsigned qSum = (i + 1 == groupPos + nLegalActions)
+			? 15 : std::min((sum * 15 + sumStrat / 2) / sumStrat, 15u);
+		qRow[seqIdx >> 1] |= (uint8_t)((qSum - prevQSum) << ((seqIdx & 1) << 2));
+		prevQSum = qSum;
+	}
+}
+
+// The header is written last, so that an interrupted packing leaves an invalid file.
+void packStratFile(
+	const std::string& bpGameName, const std::string& bpName,
+	const stratSizes_t& nBcks, const stratSizes_t& nSeqs,
+	StratEncoding encoding)
+{
+	abc::GroupedActionSeqs gpSeqs(bpGameName);
+	gpSeqs.load();
+
+	const bool isQ4 = encoding == STRAT_Q4;
+	StratFileHeader header{};
+	header.magic = StratFileHeader::MAGIC;
+	header.version = StratFileHeader::VERSION;
+	header.alignment = StratFile::alignment;
+	header.configHash = stratConfigHash(bpGameName, nBcks, nSeqs);
+	header.encoding = encoding;
+	uint64_t offset = alignOffset(sizeof(StratFileHeader));
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		header.nBcks[r] = nBcks[r];
+		header.rowSizes[r] = nSeqs[r];
+		header.rowStrides[r] = isQ4 ? (nSeqs[r] + 1) / 2 : 2 * nSeqs[r];
+		header.nInfosets[r] = gpSeqs.lens[r].size();
+		header.roundOffsets[r] = offset;
+		offset = alignOffset(offset + nBcks[r] * header.rowStrides[r] * sizeof(strat_t));
+		if (isQ4) continue;
+		header.infosetsOffsets[r] = offset;
+		offset = alignOffset(offset + nSeqs[r] * (sizeof(uint32_t) + sizeof(uint8_t)));
+	}
+	header.fileSize = offset;
+
+	const std::string path = isQ4 ? quantizedStratFilePath(bpName) : stratFilePath(bpName);
+	const std::string tmpPath = path + ".tmp";
+	{
+		opt::BinaryWriter file(tmpPath);
+		std::vector<char> padding(StratFile::alignment, 0);
+		uint64_t pos = 0;
+		auto padTo = [&](uint64_t nextOffset) {
+			file.write(padding.data(), nextOffset - pos);
+			pos = nextOffset;
+		};
+		padTo(header.roundOffsets[0]);
+
+		std::vector<strat_t> row, cumRow;
+		std::vector<uint8_t> qRow;
+		std::vector<uint32_t> infosetPos;
+		std::vector<uint8_t> infosetLens;
+		for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+			infosetPos.resize(nSeqs[r]);
+			infosetLens.resize(nSeqs[r]);
+			size_t groupPos = 0;
+			for (const uint8_t nLegalActions : gpSeqs.lens[r]) {
+				for (size_t i = groupPos; i < groupPos + nLegalActions; ++i) {
+					infosetPos[gpSeqs.seqs[r][i]] = (uint32_t)groupPos;
+					infosetLens[gpSeqs.seqs[r][i]] = nLegalActions;
+				}
+				groupPos += nLegalActions;
+			}
+
+			row.resize(nSeqs[r]);
+			cumRow.resize(nSeqs[r]);
+			qRow.resize(header.rowStrides[r]);
+			opt::BinaryReader roundFile(stratPath(bpName, r));
+			for (size_t b = 0; b < nBcks[r]; ++b) {
+				roundFile.read(std::span(row));
+				groupPos = 0;
+				if (isQ4) {
+					std::fill(qRow.begin(), qRow.end(), 0);
+					for (const uint8_t nLegalActions : gpSeqs.lens[r]) {
+						quantizeInfoset(row, gpSeqs.seqs[r], groupPos, nLegalActions, qRow);
+						groupPos += nLegalActions;
+					}
+					file.write(std::span(qRow));
+					continue;
+				}
+				for (const uint8_t nLegalActions : gpSeqs.lens[r]) {
+					strat_t sum = 0;
+					for (size_t i = groupPos; i < groupPos + nLegalActions; ++i)
+						cumRow[i] = sum += row[gpSeqs.seqs[r][i]];
+					groupPos += nLegalActions;
+				}
+				file.write(std::span(row));
+				file.write(std::span(cumRow));
+			}
+			pos += nBcks[r] * header.rowStrides[r] * sizeof(strat_t);
+
+			if (!isQ4) {
+				padTo(header.infosetsOffsets[r]);
+				file.write(std::span(infosetPos));
+				file.write(std::span(infosetLens));
+				pos += nSeqs[r] * (sizeof(uint32_t) + sizeof(uint8_t));
+			}
+			padTo((r + 1 < egn::N_ROUNDS) ? header.roundOffsets[r + 1] : header.fileSize);
+		}
+		file.close();
+	}
+	opt::RawFile(tmpPath, opt::RawFile::UPDATE).writeAt(&header, sizeof(header), 0);
+	std::filesystem::rename(tmpPath, path);
+}
+
+// Average of the rows of the infoset weighted by the weights of their hand buckets, rounding
+// the cumulated sums so that the default row sums to the rounded sum of the average.
+static void averageInfoset(
+	const std::vector<strat_t>& roundStrat, size_t nSeqs, size_t nBcks, size_t nInfosets,
+	const uint32_t* infosetSeqs, uint8_t nLegalActions, size_t infosetIdx,
+	const std::vector<double>& bckWeights, std::vector<strat_t>& defaultRow)
+{
+	double sumWeights = 0;
+	for (size_t b = 0; b < nBcks; ++b)
+		sumWeights += bckWeights[b * nInfosets + infosetIdx];
+
+	defaultRow.resize(nLegalActions);
+	double cum = 0;
+	strat_t prevCum = 0;
+	for (uint8_t i = 0; i < nLegalActions; ++i) {
+		double avg = 0;
+		for (size_t b = 0; b < nBcks; ++b) {
+			const double w = sumWeights ? bckWeights[b * nInfosets + infosetIdx] : 1;
+			avg += w * roundStrat[b * nSeqs + infosetSeqs[i]];
+		}
+		cum += avg / (sumWeights ? sumWeights : nBcks);
+		const strat_t roundedCum = (strat_t)std::min(std::round(cum), (double)sumStrat);
+		defaultRow[i] = roundedCum - prevCum;
+		prevCum = roundedCum;
+	}
+}
+
+void packPrunedStratFile(
+	const std::string& bpGameName, const std::string& bpName,
+	const stratSizes_t& nBcks, const stratSizes_t& nSeqs,
+	const keptRows_t& keptRows, const std::array<std::vector<double>, egn::N_ROUNDS>& bckWeights)
+{
+	abc::GroupedActionSeqs gpSeqs(bpGameName);
+	gpSeqs.load();
+
+	StratFileHeader header{};
+	header.magic = StratFileHeader::MAGIC;
+	header.version = StratFileHeader::VERSION;
+	header.alignment = StratFile::alignment;
+	header.configHash = stratConfigHash(bpGameName, nBcks, nSeqs);
+	header.encoding = STRAT_PRUNED;
+	uint64_t offset = alignOffset(sizeof(StratFileHeader));
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		const size_t nInfosets = gpSeqs.lens[r].size();
+		const size_t nBckWords = (nBcks[r] + 63) / 64;
+		size_t dataSize = 0;
+		for (size_t i = 0; i < nInfosets; ++i) {
+			size_t nKept = 0;
+			for (size_t b = 0; b < nBcks[r]; ++b)
+				nKept += keptRows[r][b * nInfosets + i];
+			dataSize += (1 + nKept) * gpSeqs.lens[r][i];
+		}
+		header.nBcks[r] = nBcks[r];
+		header.rowSizes[r] = nSeqs[r];
+		header.nInfosets[r] = nInfosets;
+		header.roundOffsets[r] = offset;
+		offset = alignOffset(offset + dataSize * sizeof(strat_t));
+		header.infosetsOffsets[r] = offset;
+		offset = alignOffset(offset + nInfosets * (1 + nBckWords) * sizeof(uint64_t)
+			+ nSeqs[r] * (sizeof(uint32_t) + 2 * sizeof(uint8_t)));
+	}
+	header.fileSize = offset;
+
+	const std::string tmpPath = prunedStratFilePath(bpName) + ".tmp";
+	{
+		opt::BinaryWriter file(tmpPath);
+		std::vector<char> padding(StratFile::alignment, 0);
+		uint64_t pos = 0;
+		auto padTo = [&](uint64_t nextOffset) {
+			file.write(padding.data(), nextOffset - pos);
+			pos = nextOffset;
+		};
+		padTo(header.roundOffsets[0]);
+
+		std::vector<strat_t> roundStrat, row;
+		std::vector<uint64_t> infosetBegins, keptBcks;
+		std::vector<uint32_t> seqInfosets;
+		std::vector<uint8_t> seqPos, infosetLens;
+		for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+			const size_t nInfosets = header.nInfosets[r];
+			const size_t nBckWords = (nBcks[r] + 63) / 64;
+			roundStrat.resize(nBcks[r] * nSeqs[r]);
+			opt::BinaryReader roundFile(stratPath(bpName, r));
+			roundFile.read(std::span(roundStrat));
+
+			infosetBegins.resize(nInfosets);
+			keptBcks.assign(nInfosets * nBckWords, 0);
+			seqInfosets.resize(nSeqs[r]);
+			seqPos.resize(nSeqs[r]);
+			infosetLens.resize(nSeqs[r]);
+			size_t groupPos = 0, dataPos = 0;
+			for (size_t i = 0; i < nInfosets; ++i) {
+				const uint8_t nLegalActions = gpSeqs.lens[r][i];
+				const uint32_t* infosetSeqs = gpSeqs.seqs[r].data() + groupPos;
+				for (uint8_t k = 0; k < nLegalActions; ++k) {
+					seqInfosets[infosetSeqs[k]] = (uint32_t)i;
+					seqPos[infosetSeqs[k]] = k;
+					infosetLens[infosetSeqs[k]] = nLegalActions;
+				}
+
+				infosetBegins[i] = dataPos;
+				averageInfoset(
+					roundStrat, nSeqs[r], nBcks[r], nInfosets,
+					infosetSeqs, nLegalActions, i, bckWeights[r], row);
+				file.write(std::span(row));
+				dataPos += nLegalActions;
+				for (size_t b = 0; b < nBcks[r]; ++b) {
+					if (!keptRows[r][b * nInfosets + i]) continue;
+					keptBcks[i * nBckWords + (b >> 6)] |= 1ull << (b & 63);
+					for (uint8_t k = 0; k < nLegalActions; ++k)
+						row[k] = roundStrat[b * nSeqs[r] + infosetSeqs[k]];
+					file.write(std::span(row));
+					dataPos += nLegalActions;
+				}
+				groupPos += nLegalActions;
+			}
+			pos += dataPos * sizeof(strat_t);
+			padTo(header.infosetsOffsets[r]);
+
+			file.write(std::span(infosetBegins));
+			file.write(std::span(keptBcks));
+			file.write(std::span(seqInfosets));
+			file.write(std::span(seqPos));
+			file.write(std::span(infosetLens));
+			pos += nInfosets * (1 + nBckWords) * sizeof(uint64_t)
+				+ nSeqs[r] * (sizeof(uint32_t) + 2 * sizeof(uint8_t));
+			padTo((r + 1 < egn::N_ROUNDS) ? header.roundOffsets[r + 1] : header.fileSize);
+		}
+		file.close();
+	}
+	opt::RawFile(tmpPath, opt::RawFile::UPDATE).writeAt(&header, sizeof(header), 0);
+	std::filesystem::rename(tmpPath, prunedStratFilePath(bpName));
+}
+
+void StratFile::map(const std::string& path, uint64_t configHash)
+{
+	mFile.mapFile(path, 0, true);
+	if (mFile.size() < sizeof(StratFileHeader))
+		throw std::runtime_error("The strategy file is too short.");
+	const StratFileHeader& h = header();
+	if (h.magic != StratFileHeader::MAGIC || h.version != StratFileHeader::VERSION)
+		throw std::runtime_error("The strategy file has an unknown format.");
+	if (h.configHash != configHash)
+		throw std::runtime_error("The strategy file is not one of this game.");
+	if (h.fileSize != mFile.size())
+		throw std::runtime_error("The strategy file is truncated.");
+	if (h.encoding != STRAT_U8 && h.encoding != STRAT_Q4 && h.encoding != STRAT_PRUNED)
+		throw std::runtime_error("The strategy file has an unknown encoding.");
+
+	mEncoding = h.encoding;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		const char* infosets = (const char*)mFile.data() + h.infosetsOffsets[r];
+		mRounds[r] = (const strat_t*)((const char*)mFile.data() + h.roundOffsets[r]);
+		mInfosetPos[r] = nullptr;
+		mInfosetLens[r] = nullptr;
+		mNBckWords[r] = (h.nBcks[r] + 63) / 64;
+		if (mEncoding == STRAT_U8) {
+			mInfosetPos[r] = (const uint32_t*)infosets;
+			mInfosetLens[r] = (const uint8_t*)(mInfosetPos[r] + h.rowSizes[r]);
+		}
+		else if (mEncoding == STRAT_PRUNED) {
+			mInfosetBegins[r] = (const uint64_t*)infosets;
+			mKeptBcks[r] = mInfosetBegins[r] + h.nInfosets[r];
+			mSeqInfosets[r] = (const uint32_t*)(mKeptBcks[r] + h.nInfosets[r] * mNBckWords[r]);
+			mSeqPos[r] = (const uint8_t*)(mSeqInfosets[r] + h.rowSizes[r]);
+			mInfosetLens[r] = mSeqPos[r] + h.rowSizes[r];
+		}
+		mNBcks[r] = h.nBcks[r];
+		mRowSizes[r] = h.rowSizes[r];
+		mRowStrides[r] = h.rowStrides[r];
+	}
+	// The lookups are at random.
+	mFile.advise(opt::MemoryMap::ADVICE_RANDOM);
+}
+
+} // bp
\ No newline at end of file
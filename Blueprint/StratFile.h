@@ -0,0 +1,182 @@
+#ifndef BP_STRATFILE_H
+#define BP_STRATFILE_H
+
+#include "Constants.h"
+#include "../Utils/MemoryMap.h"
+#include "../AbstractInfoset/GroupedActionSeqs.h"
+#include "../Utils/io.h"
+#include <array>
+#include <filesystem>
+#include <bit>
+
+namespace bp {
+
+enum StratEncoding : uint32_t
+{
+	// One strat_t per probability.
+	STRAT_U8,
+	// 4 bits per probability: the probabilities of an infoset are quantized
+	// to multiples of sumStrat / 15 keeping their sum equal to sumStrat.
+	STRAT_Q4,
+	// Only the rows of the infosets reached often enough by each hand bucket,
+	// the others reading the default row of their infoset (see ReachPruner).
+	STRAT_PRUNED
+};
+
+// Header of a strategy file: the strategy of all the rounds in one file
+// made to be mapped read-only, so that all the processes using the same
+// blueprint share its pages in the system cache and start without reading it.
+// The header is followed by the sections of each round, each one starting on
+// a multiple of alignment bytes:
+// - the rows of the hand buckets, each one made of the probabilities of the
+//   action sequences, with the layout of the files written by averageSnapshots.
+//   With STRAT_U8, each row is followed by the cumulated sums of the probabilities
+//   over each infoset in the order of GroupedActionSeqs, so that an action is
+//   sampled from one small contiguous read. With STRAT_Q4, a byte holds the
+//   probabilities of two consecutive action sequences, the first one in its low bits;
+// - with STRAT_U8, for each action sequence, the position in the cumulated sums of the
+//   first action of its infoset (uint32_t), then the number of actions of its infoset (uint8_t).
+// With STRAT_PRUNED, the rows are stored infoset by infoset in the order of GroupedActionSeqs:
+// the default row of the infoset, then the rows of its kept hand buckets. They are followed by
+// the position of the default row of each infoset (uint64_t), the bitset of the kept hand
+// buckets of each infoset (uint64_t words), and for each action sequence, its infoset (uint32_t),
+// its position in its infoset (uint8_t), then the number of actions of its infoset (uint8_t).
+struct StratFileHeader
+{
+	static constexpr uint64_t MAGIC = 0x3154415254535042; // "BPSTRAT1"
+	static constexpr uint32_t VERSION = 4;
+
+	uint64_t magic;
+	uint32_t version;
+	uint32_t alignment;
+	// Hash of the layout of the strategy, see stratConfigHash.
+	uint64_t configHash;
+	StratEncoding encoding;
+	uint32_t reserved;
+	uint64_t nBcks[egn::N_ROUNDS];
+	uint64_t rowSizes[egn::N_ROUNDS];
+	// Bytes between two rows, except with STRAT_PRUNED.
+	uint64_t rowStrides[egn::N_ROUNDS];
+	uint64_t nInfosets[egn::N_ROUNDS];
+	// Offsets from the beginning of the file.
+	uint64_t roundOffsets[egn::N_ROUNDS];
+	uint64_t infosetsOffsets[egn::N_ROUNDS];
+	uint64_t fileSize;
+
+}; // StratFileHeader
+
+typedef std::array<size_t, egn::N_ROUNDS> stratSizes_t;
+
+// Hash of the game name and of the numbers of hand buckets and
+// action sequences of each round.
+uint64_t stratConfigHash(
+	const std::string& bpGameName, const stratSizes_t& nBcks, const stratSizes_t& nSeqs);
+
+// Write in stratFilePath or quantizedStratFilePath the strategy files of each round of bpName.
+void packStratFile(
+	const std::string& bpGameName, const std::string& bpName,
+	const stratSizes_t& nBcks, const stratSizes_t& nSeqs,
+	StratEncoding encoding = STRAT_U8);
+
+// keptRows[r][b * nInfosets + i] is 1 if the row of the hand bucket b of
+// the i-th infoset of GroupedActionSeqs of round r is to be kept.
+typedef std::array<std::vector<uint8_t>, egn::N_ROUNDS> keptRows_t;
+
+// Write in prunedStratFilePath the strategy of bpName with only the kept rows.
+// The default row of an infoset is the average of its rows weighted by bckWeights
+// (in the layout of keptRows), or by 1 if all its weights are 0.
+void packPrunedStratFile(
+	const std::string& bpGameName, const std::string& bpName,
+	const stratSizes_t& nBcks, const stratSizes_t& nSeqs,
+	const keptRows_t& keptRows, const std::array<std::vector<double>, egn::N_ROUNDS>& bckWeights);
+
+// Strategy file mapped read-only.
+class StratFile
+{
+public:
+	// Throw an exception if the file is not a strategy with the layout of configHash.
+	void map(const std::string& path, uint64_t configHash);
+
+	bool isMapped() const { return mFile.isMapped(); }
+	const StratFileHeader& header() const { return *(const StratFileHeader*)mFile.data(); }
+	StratEncoding encoding() const { return mEncoding; }
+
+	strat_t proba(uint8_t roundId, size_t bckIdx, size_t seqIdx) const
+	{
+		switch (mEncoding) {
+		case STRAT_U8:
+			return row(roundId, bckIdx)[seqIdx];
+		case STRAT_Q4: {
+			const uint8_t q = row(roundId, bckIdx)[seqIdx >> 1] >> ((seqIdx & 1) << 2) & 0xF;
+			return (strat_t)(q * (sumStrat / 15));
+		}
+		default:
+			return prunedProba(roundId, bckIdx, seqIdx);
+		}
+	}
+
+	// Row of the probabilities, only to be read directly with STRAT_U8.
+	// With STRAT_PRUNED, the rows are not indexed by hand bucket.
+	const strat_t* row(uint8_t roundId, size_t bckIdx) const
+	{
+		return mRounds[roundId] + bckIdx * mRowStrides[roundId];
+	}
+
+	// The following are only available with STRAT_U8.
+
+	// Cumulated sums of the probabilities of the infosets.
+	const strat_t* cumRow(uint8_t roundId, size_t bckIdx) const
+	{
+		return row(roundId, bckIdx) + mRowSizes[roundId];
+	}
+
+	// Position in cumRow of the first action of the infoset of the action sequence
+	// seqIdx, and number of actions of the infoset.
+	uint32_t infosetPos(uint8_t roundId, size_t seqIdx) const { return mInfosetPos[roundId][seqIdx]; }
+	// Also available with STRAT_PRUNED.
+	uint8_t infosetLen(uint8_t roundId, size_t seqIdx) const { return mInfosetLens[roundId][seqIdx]; }
+
+	size_t nBcks(uint8_t roundId) const { return mNBcks[roundId]; }
+	size_t rowSize(uint8_t roundId) const { return mRowSizes[roundId]; }
+
+	// The rounds start on a page so that they can be advised separately.
+	static constexpr uint32_t alignment = 4096;
+
+private:
+	// The rank of the hand bucket among the kept ones of the infoset gives its row.
+	strat_t prunedProba(uint8_t roundId, size_t bckIdx, size_t seqIdx) const
+	{
+		const uint32_t infosetIdx = mSeqInfosets[roundId][seqIdx];
+		const uint64_t* keptBcks = mKeptBcks[roundId] + infosetIdx * mNBckWords[roundId];
+		const size_t w = bckIdx >> 6;
+		const uint64_t bit = 1ull << (bckIdx & 63);
+		size_t rowIdx = 0;
+		if (keptBcks[w] & bit) {
+			rowIdx = 1 + std::popcount(keptBcks[w] & (bit - 1));
+			for (size_t i = 0; i < w; ++i) rowIdx += std::popcount(keptBcks[i]);
+		}
+		return mRounds[roundId][mInfosetBegins[roundId][infosetIdx]
+			+ rowIdx * mInfosetLens[roundId][seqIdx] + mSeqPos[roundId][seqIdx]];
+	}
+
+	opt::MemoryMap mFile;
+	StratEncoding mEncoding;
+	std::array<const strat_t*, egn::N_ROUNDS> mRounds;
+	std::array<const uint32_t*, egn::N_ROUNDS> mInfosetPos;
+	std::array<const uint8_t*, egn::N_ROUNDS> mInfosetLens;
+	std::array<const uint64_t*, egn::N_ROUNDS> mInfosetBegins;
+	std::array<const uint64_t*, egn::N_ROUNDS> mKeptBcks;
+	std::array<const uint32_t*, egn::N_ROUNDS> mSeqInfosets;
+	std::array<const uint8_t*, egn::N_ROUNDS> mSeqPos;
+	stratSizes_t mNBckWords;
+	stratSizes_t mNBcks;
+	stratSizes_t mRowSizes;
+	stratSizes_t mRowStrides;
+
+}; // StratFile
+
+static_assert(sumStrat % 15 == 0);
+
+} // bp
+
+#endif // BP_STRATFILE_H
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "StratServer.h"
+
+namespace bp {
+
+StratServer::StratServer(unsigned nWorkers, uint32_t maxBatch, unsigned rngSeed) :
+
+	nRequests(0),
+	nBatches(0),
+	maxBatch(maxBatch),
+	blueprint(BlueprintAIAdvisor::loadBlueprint()),
+	stopping(false),
+	nBusyWorkers(0),
+	nReaders(0)
+{
+	if (!nWorkers)
+		throw std::runtime_error("The server needs at least one worker.");
+	std::mt19937 rng{ (!rngSeed) ? std::random_device{}() : rngSeed };
+	// The advisors are built here since they all load the same lookup tables.
+	for (unsigned i = 0; i < nWorkers; ++i)
+		advisors.push_back(std::make_unique<BlueprintAIAdvisor>(blueprint.get(), (unsigned)rng()));
+	for (unsigned i = 0; i < nWorkers; ++i)
+		workers.emplace_back(&StratServer::work, this, i);
+}
+
+StratServer::~StratServer()
+{
+	stop();
+	for (auto& t : workers) t.join();
+	std::unique_lock<std::mutex> lock(connectionsMutex);
+	readersCv.wait(lock, [&] { return nReaders == 0; });
+}
+
+void StratServer::run(const std::string& path)
+{
+	listener.listen(path);
+	while (true) {
+		opt::LocalSocket socket;
+		try {
+			socket = listener.accept();
+		}
+		catch (const std::runtime_error&) {
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (stopping) break;
+			throw;
+		}
+		auto connection = std::make_shared<Connection>();
+		connection->socket = std::move(socket);
+		std::lock_guard<std::mutex> lock(connectionsMutex);
+		// A connection accepted while stopping would never be shut down.
+		{
+			std::lock_guard<std::mutex> queueLock(queueMutex);
+			if (stopping) break;
+		}
+		connections.push_back(connection);
+		++nReaders;
+		std::thread(&StratServer::readConnection, this, connection).detach();
+	}
+	opt::LocalSocket::removeFile(path);
+}
+
+void StratServer::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		if (stopping) return;
+		stopping = true;
+	}
+	queueCv.notify_all();
+	listener.stopListening();
+
+	// The connections are still needed to answer the frames already queued.
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		queueCv.wait(lock, [&] { return frames.empty() && nBusyWorkers == 0; });
+	}
+
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	for (auto& connection : connections)
+		connection->socket.shutdown();
+}
+
+void StratServer::readConnection(std::shared_ptr<Connection> connection)
+{
+	while (true) {
+		uint32_t nFrameRequests;
+		if (!connection->socket.readAll(&nFrameRequests, sizeof(nFrameRequests))) break;
+		if (nFrameRequests > maxAdviceFrameSize) break;
+
+		Frame frame{ connection, std::vector<AdviceRequest>(nFrameRequests) };
+		if (!connection->socket.readAll(frame.requests.data(), nFrameRequests * sizeof(AdviceRequest))) break;
+
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			if (stopping) break;
+			frames.push_back(std::move(frame));
+		}
+		queueCv.notify_one();
+	}
+
+	// The workers still hold the connection while answering its last frames.
+	std::lock_guard<std::mutex> lock(connectionsMutex);
+	connections.remove(connection);
+	--nReaders;
+	readersCv.notify_all();
+}
+
+void StratServer::work(unsigned workerIdx)
+{
+	BlueprintAIAdvisor& advisor = *advisors[workerIdx];
+	std::vector<Frame> batch;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			if (!batch.empty()) {
+				batch.clear();
+				--nBusyWorkers;
+				if (stopping) queueCv.notify_all();
+			}
+			queueCv.wait(lock, [&] { return stopping || !frames.empty(); });
+			// The frames queued before stop are still answered.
+			if (frames.empty()) return;
+			++nBusyWorkers;
+
+			// Take at least one frame, then the ones fitting in the batch.
+			size_t nBatchRequests = 0;
+			do {
+				nBatchRequests += frames.front().requests.size();
+				batch.push_back(std::move(frames.front()));
+				frames.pop_front();
+			} while (!frames.empty() && nBatchRequests + frames.front().requests.size() <= maxBatch);
+		}
+
+		serveBatch(advisor, batch);
+	}
+}
+
+void StratServer::serveBatch(BlueprintAIAdvisor& advisor, std::vector<Frame>& batch)
+{
+	// Sort the requests of the batch by their content (not their id)
+	// so that the identical ones follow each other and are computed once.
+	std::vector<std::vector<AdviceResponse>> responses(batch.size());
+	std::vector<std::pair<uint32_t, uint32_t>> order;
+	for (uint32_t f = 0; f < batch.size(); ++f) {
+		responses[f].resize(batch[f].requests.size());
+		for (uint32_t i = 0; i < batch[f].requests.size(); ++i)
+			order.emplace_back(f, i);
+	}
+	static const size_t contentOffset = sizeof(AdviceRequest::id);
+	static const size_t contentSize = sizeof(AdviceRequest) - contentOffset;
+	auto content = [&](const std::pair<uint32_t, uint32_t>& p) {
+		return (const char*)&batch[p.first].requests[p.second] + contentOffset;
+	};
+	std::sort(order.begin(), order.end(), [&](const auto& a, const auto& b) {
+		return std::memcmp(content(a), content(b), contentSize) < 0;
+	});
+
+	for (size_t k = 0; k < order.size(); ++k) {
+		const auto [f, i] = order[k];
+		AdviceResponse& response = responses[f][i];
+		if (k && !std::memcmp(content(order[k - 1]), content(order[k]), contentSize))
+			response = responses[order[k - 1].first][order[k - 1].second];
+		else
+			advise(advisor, batch[f].requests[i], response);
+		response.id = batch[f].requests[i].id;
+	}
+
+	for (uint32_t f = 0; f < batch.size(); ++f) {
+		Connection& connection = *batch[f].connection;
+		const uint32_t nFrameRequests = (uint32_t)responses[f].size();
+		// The frames of a connection can be answered by several workers at once.
+		std::lock_guard<std::mutex> lock(connection.writeMutex);
+		if (connection.socket.writeAll(&nFrameRequests, sizeof(nFrameRequests)))
+			connection.socket.writeAll(responses[f].data(), nFrameRequests * sizeof(AdviceResponse));
+	}
+
+	nRequests += order.size();
+	++nBatches;
+}
+
+void StratServer::advise(BlueprintAIAdvisor& advisor, const AdviceRequest& request, AdviceResponse& response)
+{
+	std::memset(&response, 0, sizeof(response));
+	response.id = request.id;
+
+	response.status = (request.nHistory > maxAdviceHistory) ? ADVICE_INVALID
+		: advisor.adviseSpot(
+			request.ante, request.bb, request.stakes,
+			request.dealer, request.myPosition, request.hand,
+			request.boardCards, request.nBoardCards,
+			request.actions, request.bets, request.nHistory);
+	if (response.status != ADVICE_OK) return;
+
+	response.aiAction = (uint8_t)advisor.aiAction;
+	response.aiBet = advisor.aiBet;
+	response.nActions = advisor.nActions;
+	std::copy(advisor.probas, advisor.probas + advisor.nActions, response.probas);
+	std::copy(advisor.actions, advisor.actions + advisor.nActions, response.actions);
+	std::copy(advisor.bets, advisor.bets + advisor.nActions, response.bets);
+}
+
+void StratClient::connect(const std::string& path)
+{
+	socket.connect(path);
+}
+
+void StratClient::advise(const std::vector<AdviceRequest>& requests, std::vector<AdviceResponse>& responses)
+{
+	if (requests.size() > maxAdviceFrameSize)
+		throw std::runtime_error("Too many requests in one frame.");
+	const uint32_t nRequests = (uint32_t)requests.size();
+	if (!socket.writeAll(&nRequests, sizeof(nRequests))
+		|| !socket.writeAll(requests.data(), nRequests * sizeof(AdviceRequest)))
+		throw std::runtime_error("Connection to the server lost.");
+
+	uint32_t nResponses;
+	if (!socket.readAll(&nResponses, sizeof(nResponses)) || nResponses != nRequests)
+		throw std::runtime_error("Connection to the server lost.");
+	responses.resize(nResponses);
+	if (!socket.readAll(responses.data(), nResponses * sizeof(AdviceResponse)))
+		throw std::runtime_error("Connection to the server lost.");
+}
+
+} // bp
\ No newline at end of file
@@ -0,0 +1,152 @@
+#ifndef BP_STRATSERVER_H
+#define BP_STRATSERVER_H
+
+#include "BlueprintAIAdvisor.h"
+#include "../Utils/LocalSocket.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+namespace bp {
+
+// Protocol of StratServer: a client sends frames made of the number of
+// requests (uint32_t) followed by the AdviceRequest. The server answers each
+// frame with a frame of as many AdviceResponse, in the same order.
+// The requests are stateless: each one holds the whole public history of
+// the hand, so that any process can ask for any spot of any hand.
+// The frames sent by a client before reading the answers may be answered
+// in any order, which the ids of the requests tell.
+// The structs are sent as they are, so they have no padding.
+
+// Maximum number of actions of the history of a request.
+static const uint8_t maxAdviceHistory = 64;
+// Maximum number of requests of a frame. The server closes the connection above.
+static const uint32_t maxAdviceFrameSize = 1 << 12;
+// Size of the arrays of actions of a response, rounded so that it has no padding.
+static const uint8_t maxAdviceActions = (maxNAbcActions + 3) / 4 * 4;
+
+struct AdviceRequest
+{
+	// Copied in the response.
+	uint32_t id;
+	egn::chips ante;
+	egn::chips bb;
+	egn::chips stakes[MAX_PLAYERS];
+	// Bets of the raises of the history, ignored for the other actions.
+	egn::chips bets[maxAdviceHistory];
+	uint8_t dealer;
+	// Position of the advised player, who must be acting after the history.
+	uint8_t myPosition;
+	uint8_t hand[omp::HOLE_CARDS];
+	// At least the board cards of the round reached by the history.
+	uint8_t nBoardCards;
+	uint8_t boardCards[omp::BOARD_CARDS];
+	uint8_t nHistory;
+	uint8_t reserved;
+	// egn::Action of each action of the history since the blinds.
+	uint8_t actions[maxAdviceHistory];
+
+}; // AdviceRequest
+
+// Fields of BlueprintAIAdvisor after getAdvices.
+struct AdviceResponse
+{
+	uint32_t id;
+	egn::chips aiBet;
+	egn::chips bets[maxAdviceActions];
+	AdviceStatus status;
+	uint8_t aiAction;
+	uint8_t nActions;
+	uint8_t reserved;
+	uint8_t probas[maxAdviceActions];
+	uint8_t actions[maxAdviceActions];
+
+}; // AdviceResponse
+
+static_assert(std::has_unique_object_representations_v<AdviceRequest>);
+static_assert(std::has_unique_object_representations_v<AdviceResponse>);
+
+// Daemon loading the blueprint once and serving its advices to the other
+// processes of the machine (HUD, analysis scripts, bots) over a local socket.
+// Each connection has a thread reading its frames in a queue shared by the
+// workers. A worker takes all the waiting frames of all the connections up to
+// maxBatch requests, so that concurrent requests are served together and the
+// identical ones (e.g. refreshed by a HUD) are computed once per batch.
+// The workers have their own advisor over the shared blueprint.
+// When stopped, the server answers the frames already queued
+// before closing the connections.
+class StratServer
+{
+public:
+	// Set rngSeed to 0 to set a random seed.
+	StratServer(unsigned nWorkers, uint32_t maxBatch, unsigned rngSeed = 0);
+	~StratServer();
+
+	// Serve the clients connecting at path until stop is called.
+	void run(const std::string& path);
+	void stop();
+
+	std::atomic<uint64_t> nRequests;
+	std::atomic<uint64_t> nBatches;
+
+private:
+	struct Connection
+	{
+		opt::LocalSocket socket;
+		std::mutex writeMutex;
+	};
+
+	struct Frame
+	{
+		std::shared_ptr<Connection> connection;
+		std::vector<AdviceRequest> requests;
+	};
+
+	void readConnection(std::shared_ptr<Connection> connection);
+	void work(unsigned workerIdx);
+	void serveBatch(BlueprintAIAdvisor& advisor, std::vector<Frame>& batch);
+	static void advise(BlueprintAIAdvisor& advisor, const AdviceRequest& request, AdviceResponse& response);
+
+	const uint32_t maxBatch;
+
+	std::unique_ptr<Blueprint> blueprint;
+	std::vector<std::unique_ptr<BlueprintAIAdvisor>> advisors;
+	std::vector<std::thread> workers;
+
+	std::mutex queueMutex;
+	std::condition_variable queueCv;
+	std::deque<Frame> frames;
+	bool stopping;
+	unsigned nBusyWorkers;
+
+	opt::LocalSocket listener;
+	std::mutex connectionsMutex;
+	std::list<std::shared_ptr<Connection>> connections;
+	// The reading threads are detached, and waited for when the server is destroyed.
+	unsigned nReaders;
+	std::condition_variable readersCv;
+
+}; // StratServer
+
+// Connection to a StratServer.
+class StratClient
+{
+public:
+	void connect(const std::string& path = stratServerSocketPath());
+
+	// Send the requests in one frame and wait for their responses.
+	void advise(const std::vector<AdviceRequest>& requests, std::vector<AdviceResponse>& responses);
+
+private:
+	opt::LocalSocket socket;
+
+}; // StratClient
+
+} // bp
+
+#endif // BP_STRATSERVER_H
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef BP_TRAINCONTROL_H
+#define BP_TRAINCONTROL_H
+
+#include "../GameEngine/GameState.h"
+#include <atomic>
+#include <chrono>
+
+namespace bp {
+
+static const unsigned maxTrainProcesses = 256;
+// There are less than 256 hand buckets per round.
+static const size_t maxRegretRows = egn::N_ROUNDS * 256;
+
+// Control block placed at the beginning of the shared memory segment
+// used when several processes train the same blueprint.
+// Worker 0 (the leader) creates the segment, loads the checkpoint
+// and is the only one applying the discounting, taking the snapshots,
+// saving the checkpoints and printing. The other workers only claim
+// iterations and update the shared regrets.
+// Iterations can only be claimed below iterLimit. When all the claimed
+// iterations are done, the leader runs the periodic tasks and moves
+// iterLimit to the next iteration needing them.
+// Only the rng of the leader is saved with the checkpoint: the followers
+// restart theirs from their seed, so a resumed run with several processes
+// is not reproducible (neither is the order in which they claim iterations).
+struct TrainControl
+{
+	static constexpr uint64_t MAGIC = 0x4250545241494E31; // "BPTRAIN1"
+	static constexpr uint64_t IDLE = ~0ull;
+
+	// Set by the leader once the regrets have been initialized.
+	std::atomic<uint64_t> magic;
+	uint64_t regretsSize;
+
+	// Next iteration to be claimed.
+	std::atomic<uint64_t> nextIter;
+	// Number of iterations fully done.
+	std::atomic<uint64_t> doneIter;
+	// No iteration can be claimed from iterLimit until the
+	// leader has run the periodic tasks.
+	std::atomic<uint64_t> iterLimit;
+	// Incremented each time the regrets are discounted.
+	std::atomic<uint64_t> discountEpoch;
+	// Epoch of the last discounting of each row of the regrets.
+	std::atomic<uint32_t> rowEpochs[maxRegretRows];
+
+	std::atomic<uint64_t> nodesCount;
+	std::atomic<uint64_t> nodesUniqueCount;
+	// Statistics of the followers since the last time the leader collected them.
+	std::atomic<uint64_t> roundNodesCount[egn::N_ROUNDS];
+	std::atomic<uint64_t> nPrunedIters;
+	std::atomic<uint64_t> prunedSubtrees[egn::N_ROUNDS];
+	std::atomic<uint64_t> exploredSubtrees[egn::N_ROUNDS];
+	std::atomic<uint64_t> exploredSubtreeNodes[egn::N_ROUNDS];
+
+	// Iteration being done by each worker (IDLE if none), and the last
+	// time it gave a sign of life in ms since the epoch of steady_clock.
+	std::atomic<uint64_t> workerIters[maxTrainProcesses];
+	std::atomic<uint64_t> heartbeats[maxTrainProcesses];
+
+	static uint64_t nowMs()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+}; // TrainControl
+
+// The regrets start on their own page after the control block,
+// followed by the pruned masks.
+static const size_t trainControlSize = (sizeof(TrainControl) + 4095) / 4096 * 4096;
+
+} // bp
+
+#endif // BP_TRAINCONTROL_H
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "WarmStart.h"
+
+namespace bp {
+
+WarmStarter::WarmStarter(
+	const BlueprintGame& coarseGame,
+	const std::string& coarseBuildName,
+	double regretScale) :
+
+	mappedSeqsRatio{},
+	coarseGame(coarseGame),
+	coarseName(blueprintName(coarseGame.name, coarseBuildName)),
+	regretScale(regretScale)
+{
+	// The number of players is the last entry of the postflop action sequences.
+	if (coarseGame.maxPlayers != MAX_PLAYERS)
+		throw std::runtime_error("The coarse game must have the same number of players.");
+	if (coarseName == blueprintName())
+		throw std::runtime_error("A blueprint cannot be warm started from itself.");
+
+	const abc::ActionSeqSize seqSizes(coarseGame.name);
+	coarseRegrets.setLayout(
+		coarseGame.nBcks,
+		{ seqSizes.preflopSize, seqSizes.flopSize, seqSizes.turnSize, seqSizes.riverSize });
+}
+
+void WarmStarter::warmStart()
+{
+	loadCoarseRegrets();
+	mapBcks();
+	mapSeqs();
+	writeRegrets();
+}
+
+// The coarse checkpoint can be in any of the formats of BlueprintCalculator.
+void WarmStarter::loadCoarseRegrets()
+{
+	coarseRegrets.allocate();
+	if (hasRegretShards(coarseName)) {
+		loadRegretShards(coarseRegrets, coarseName);
+		return;
+	}
+	const std::string path = std::filesystem::exists(checkpointRegretsPath(coarseName))
+		? checkpointRegretsPath(coarseName) : checkpointPath(coarseName);
+	auto file = std::fstream(path, std::ios::in | std::ios::binary);
+	if (!file)
+		throw std::runtime_error("The coarse blueprint has no checkpoint.");
+	coarseRegrets.load(file);
+	file.close();
+}
+
+void WarmStarter::mapBcks()
+{
+	const RegretTable::roundSizes_t nBcks = { N_BCK_PREFLOP, N_BCK_FLOP, N_BCK_TURN, N_BCK_RIVER };
+
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		std::vector<double> strengths(nBcks[r]), coarseStrengths(coarseGame.nBcks[r]);
+		opt::load1DVector(strengths, bckStrengthsPath(r, nBcks[r]));
+		opt::load1DVector(coarseStrengths, bckStrengthsPath(r, coarseGame.nBcks[r]));
+
+		bckMap[r].resize(nBcks[r]);
+		for (size_t b = 0; b < nBcks[r]; ++b) {
+			size_t best = 0;
+			for (size_t c = 1; c < coarseStrengths.size(); ++c) {
+				if (std::abs(coarseStrengths[c] - strengths[b]) < std::abs(coarseStrengths[best] - strengths[b]))
+					best = c;
+			}
+			bckMap[r][b] = best;
+		}
+	}
+}
+
+void WarmStarter::mapSeqs()
+{
+	abc::ActionSeqIndexer indexer(
+		MAX_PLAYERS, ANTE, BIG_BLIND, INITIAL_STAKE, BET_SIZES, BLUEPRINT_GAME_NAME);
+	indexer.loadMPHF();
+	abc::ActionSeqIndexer coarseIndexer(
+		coarseGame.maxPlayers, coarseGame.ante, coarseGame.bigBlind,
+		coarseGame.initialStake, coarseGame.betSizes, coarseGame.name);
+	coarseIndexer.loadMPHF();
+
+	const std::vector<std::vector<seq_t>> seqs = indexer.traverser.traverseTree();
+	std::vector<std::vector<seq_t>> coarseSeqs = coarseIndexer.traverser.traverseTree();
+
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		// The MPHF returns any index for an unknown sequence, so the coarse ones are kept in a map.
+		std::unordered_map<seq_t, uint64_t, abc::ActionSeqHash> coarseIndices;
+		coarseIndices.reserve(coarseSeqs[r].size());
+		for (const seq_t& seq : coarseSeqs[r])
+			coarseIndices[seq] = coarseIndexer.index(egn::Round(r), seq);
+		opt::freeVectMem(coarseSeqs[r]);
+
+		seqMap[r].assign(seqs[r].size(), NO_SEQ);
+		size_t nMapped = 0;
+		for (const seq_t& seq : seqs[r]) {
+			const auto it = coarseIndices.find(mapSeq(r, seq));
+			if (it == coarseIndices.end()) continue;
+			seqMap[r][indexer.index(egn::Round(r), seq)] = it->second;
+			++nMapped;
+		}
+		mappedSeqsRatio[r] = seqs[r].empty() ? 0 : (double)nMapped / seqs[r].size();
+	}
+}
+
+// Replay the sequence counting the raises in both games
+// since the bet sizes depend on the number of raises of the round.
+WarmStarter::seq_t WarmStarter::mapSeq(uint8_t roundId, const seq_t& seq) const
+{
+	// The postflop sequences end with the number of players.
+	const size_t nActions = (roundId == egn::PREFLOP) ? seq.size() : seq.size() - 1;
+
+	seq_t res;
+	uint8_t nRaises = 0, coarseNRaises = 0;
+	abc::StdActionSeqIterator it(seq);
+	for (size_t i = 0; i < nActions; ++i) {
+		const uint8_t action = it.next();
+		if (action < abc::ALLIN) {
+			res.push_back(action);
+			continue;
+		}
+		res.push_back((action == abc::ALLIN) ? action : mapRaise(roundId, nRaises, coarseNRaises, action));
+		if (nRaises != BET_SIZES[roundId].size() - 1) ++nRaises;
+		if (coarseNRaises != coarseGame.betSizes[roundId].size() - 1) ++coarseNRaises;
+	}
+	if (roundId != egn::PREFLOP) res.push_back(it.next());
+	return res;
+}
+
+// The bet sizes are compared by their ratio since they range from
+// a fraction of the pot to many times the pot.
+uint8_t WarmStarter::mapRaise(uint8_t roundId, uint8_t nRaises, uint8_t coarseNRaises, uint8_t action) const
+{
+	const double betSize = BET_SIZES[roundId][nRaises][action - abc::RAISE];
+	const std::vector<float>& coarseBetSizes = coarseGame.betSizes[roundId][coarseNRaises];
+	uint8_t best = 0;
+	for (uint8_t k = 1; k < coarseBetSizes.size(); ++k) {
+		if (std::abs(std::log(coarseBetSizes[k] / betSize)) < std::abs(std::log(coarseBetSizes[best] / betSize)))
+			best = k;
+	}
+	return abc::RAISE + best;
+}
+
+// Write the regrets with the layout of a checkpoint, one row at a time.
+void WarmStarter::writeRegrets() const
+{
+	std::filesystem::create_directory(blueprintDir());
+	std::filesystem::create_directory(blueprintTmpDir());
+
+	opt::BinaryWriter file(warmStartPath());
+	std::vector<regret_t> row;
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+		row.resize(seqMap[r].size());
+		for (size_t b = 0; b < bckMap[r].size(); ++b) {
+			const regret_t* coarseRow = coarseRegrets.row(r, bckMap[r][b]);
+			for (size_t seqIdx = 0; seqIdx < row.size(); ++seqIdx) {
+				if (seqMap[r][seqIdx] == NO_SEQ) {
+					row[seqIdx] = 0;
+					continue;
+				}
+				const double regret = std::round(coarseRow[seqMap[r][seqIdx]] * regretScale);
+				row[seqIdx] = (regret_t)std::clamp(regret, (double)minRegret, (double)maxRegret);
+			}
+			file.write(row.data(), row.size() * sizeof(regret_t));
+		}
+	}
+	file.close();
+}
+
+std::string WarmStarter::bckStrengthsPath(uint8_t roundId, size_t nBck)
+{
+	return opt::dataDir + "AbstractionSaves/BCK_STRENGTHS/"
+		+ opt::toUpper(egn::roundToString(roundId)) + "_" + std::to_string(nBck) + "_BCK_STRENGTHS.bin";
+}
+
+} // bp
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef BP_WARMSTART_H
+#define BP_WARMSTART_H
+
+#include "RegretTable.h"
+#include "RegretShards.h"
+#include "../AbstractInfoset/ActionSeqIndexer.h"
+#include "../AbstractInfoset/ActionSeqSize.h"
+#include "../Utils/ioContainer.h"
+#include <unordered_map>
+#include <filesystem>
+
+namespace bp {
+
+// Constants of a game namespace of Constants.h.
+struct BlueprintGame
+{
+	std::string name;
+	RegretTable::roundSizes_t nBcks;
+	uint8_t maxPlayers;
+	egn::chips ante;
+	egn::chips bigBlind;
+	egn::chips initialStake;
+	abc::betSizes_t betSizes;
+};
+
+#define BP_BLUEPRINT_GAME(NAMESPACE) bp::BlueprintGame{ \
+	bp::NAMESPACE::BLUEPRINT_GAME_NAME, \
+	{ bp::NAMESPACE::N_BCK_PREFLOP, bp::NAMESPACE::N_BCK_FLOP, bp::NAMESPACE::N_BCK_TURN, bp::NAMESPACE::N_BCK_RIVER }, \
+	bp::NAMESPACE::MAX_PLAYERS, bp::NAMESPACE::ANTE, bp::NAMESPACE::BIG_BLIND, \
+	bp::NAMESPACE::INITIAL_STAKE, bp::NAMESPACE::BET_SIZES }
+
+// Write in warmStartPath() initial regrets for the current blueprint taken
+// from the checkpoint of a blueprint of a coarser game, so that the training
+// does not start from zero regrets.
+// Each hand bucket takes the regrets of the coarse bucket of closest strength
+// (see HandBucketStrength, which must have been run for both games).
+// Each action sequence takes the regrets of the coarse sequence in which every
+// raise is replaced by the coarse raise of closest bet size. The sequences
+// without a coarse equivalent start from zero regrets.
+class WarmStarter
+{
+public:
+	// The coarse regrets are multiplied by regretScale, so that the new
+	// iterations can weigh more than the ones of the coarse training.
+	WarmStarter(
+		const BlueprintGame& coarseGame,
+		const std::string& coarseBuildName,
+		double regretScale = 1);
+
+	void warmStart();
+
+	// Share of the action sequences of each round mapped to a coarse one.
+	std::array<double, egn::N_ROUNDS> mappedSeqsRatio;
+
+private:
+	typedef abc::StdActionSeq seq_t;
+
+	static constexpr uint64_t NO_SEQ = ~0ull;
+
+	void loadCoarseRegrets();
+	void mapBcks();
+	void mapSeqs();
+	seq_t mapSeq(uint8_t roundId, const seq_t& seq) const;
+	uint8_t mapRaise(uint8_t roundId, uint8_t nRaises, uint8_t coarseNRaises, uint8_t action) const;
+	void writeRegrets() const;
+
+	static std::string bckStrengthsPath(uint8_t roundId, size_t nBck);
+
+	const BlueprintGame coarseGame;
+	const std::string coarseName;
+	const double regretScale;
+
+	RegretTable coarseRegrets;
+	// Coarse bucket of each bucket and coarse action sequence of each action sequence.
+	std::array<std::vector<size_t>, egn::N_ROUNDS> bckMap;
+	std::array<std::vector<uint64_t>, egn::N_ROUNDS> seqMap;
+
+}; // WarmStarter
+
+} // bp
+
+#endif // BP_WARMSTART_H
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "pch.h"
+#include "BlueprintAIBatch.h"
+#include "../Blueprint/BlueprintAIAdvisor.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+static_assert(std::is_same_v<egn::chips, uint32_t>);
+
+// Threads waiting for the batches, each one advising a contiguous slice of the
+// requests with its own advisor over the shared blueprint. The calling thread
+// advises the first slice.
+struct BlueprintAIBatch
+{
+	BlueprintAIBatch(unsigned nThreads, unsigned rngSeed) :
+
+		nThreads(nThreads),
+		blueprint(bp::BlueprintAIAdvisor::loadBlueprint()),
+		generation(0),
+		nRunning(0),
+		stopping(false),
+		requests(nullptr),
+		advices(nullptr),
+		nAdvised(0),
+		failed(false)
+	{
+		std::mt19937 rng{ (!rngSeed) ? std::random_device{}() : rngSeed };
+		for (unsigned i = 0; i < nThreads; ++i)
+			advisors.push_back(std::make_unique<bp::BlueprintAIAdvisor>(blueprint.get(), (unsigned)rng()));
+		try {
+			for (unsigned i = 1; i < nThreads; ++i)
+				threads.emplace_back(&BlueprintAIBatch::work, this, i);
+		}
+		catch (...) {
+			// The destructor is not called, and the started threads must not outlive the batch.
+			stop();
+			throw;
+		}
+	}
+
+	~BlueprintAIBatch()
+	{
+		stop();
+	}
+
+	uint32_t getAdvices(const AdvBatchRequests& batchRequests, AdvBatchAdvices& batchAdvices)
+	{
+		std::lock_guard<std::mutex> callLock(callMutex);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			requests = &batchRequests;
+			advices = &batchAdvices;
+			nAdvised = 0;
+			failed = false;
+			nRunning = nThreads - 1;
+			++generation;
+		}
+		startCv.notify_all();
+
+		// The other threads still read the batch, so wait for them before throwing.
+		tryAdviseSlice(0);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		doneCv.wait(lock, [&] { return nRunning == 0; });
+		if (failed)
+			throw std::runtime_error("The batch could not be advised.");
+		return nAdvised;
+	}
+
+private:
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		startCv.notify_all();
+		for (auto& t : threads) t.join();
+	}
+
+	void work(unsigned threadIdx)
+	{
+		uint64_t lastGeneration = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				startCv.wait(lock, [&] { return stopping || generation != lastGeneration; });
+				if (stopping) return;
+				lastGeneration = generation;
+			}
+			tryAdviseSlice(threadIdx);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--nRunning == 0) doneCv.notify_one();
+		}
+	}
+
+	void tryAdviseSlice(unsigned threadIdx)
+	{
+		try {
+			adviseSlice(threadIdx);
+		}
+		catch (...) {
+			failed = true;
+		}
+	}
+
+	void adviseSlice(unsigned threadIdx)
+	{
+		const AdvBatchRequests& r = *requests;
+		AdvBatchAdvices& a = *advices;
+		bp::BlueprintAIAdvisor& advisor = *advisors[threadIdx];
+		const uint32_t begin = (uint32_t)((uint64_t)r.nRequests * threadIdx / nThreads);
+		const uint32_t end = (uint32_t)((uint64_t)r.nRequests * (threadIdx + 1) / nThreads);
+
+		uint32_t nSliceAdvised = 0;
+		for (uint32_t i = begin; i < end; ++i) {
+			const uint32_t historyBegin = r.historyBegins[i];
+			if (r.historyBegins[i + 1] < historyBegin) {
+				a.status[i] = bp::ADVICE_INVALID;
+				continue;
+			}
+			a.status[i] = advisor.adviseSpot(
+				r.antes[i], r.bbs[i], r.stakes + (size_t)i * bp::MAX_PLAYERS,
+				r.dealers[i], r.myPositions[i], r.hands + (size_t)i * omp::HOLE_CARDS,
+				r.boardCards + (size_t)i * omp::BOARD_CARDS, r.nBoardCards[i],
+				r.historyActions + historyBegin, r.historyBets + historyBegin,
+				r.historyBegins[i + 1] - historyBegin);
+			if (a.status[i] != bp::ADVICE_OK) continue;
+
+			a.aiActions[i] = (uint8_t)advisor.aiAction;
+			a.aiBets[i] = advisor.aiBet;
+			a.nActions[i] = advisor.nActions;
+			const size_t offset = (size_t)i * bp::maxNAbcActions;
+			std::copy(advisor.probas, advisor.probas + advisor.nActions, a.probas + offset);
+			std::copy(advisor.actions, advisor.actions + advisor.nActions, a.actions + offset);
+			std::copy(advisor.bets, advisor.bets + advisor.nActions, a.bets + offset);
+			++nSliceAdvised;
+		}
+		nAdvised += nSliceAdvised;
+	}
+
+	const unsigned nThreads;
+
+	std::unique_ptr<bp::Blueprint> blueprint;
+	std::vector<std::unique_ptr<bp::BlueprintAIAdvisor>> advisors;
+	std::vector<std::thread> threads;
+
+	std::mutex callMutex;
+	std::mutex mutex;
+	std::condition_variable startCv;
+	std::condition_variable doneCv;
+	uint64_t generation;
+	unsigned nRunning;
+	bool stopping;
+
+	// Batch being advised.
+	const AdvBatchRequests* requests;
+	AdvBatchAdvices* advices;
+	std::atomic<uint32_t> nAdvised;
+	std::atomic<bool> failed;
+
+}; // BlueprintAIBatch
+
+int MAX_ACTIONS() { return bp::maxNAbcActions; }
+
+// No exception may cross the C interface.
+BlueprintAIBatch* newBlueprintAIBatch(unsigned nThreads, unsigned rngSeed)
+{
+	if (!nThreads) nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	try {
+		return new BlueprintAIBatch(nThreads, rngSeed);
+	}
+	catch (...) {
+		return nullptr;
+	}
+}
+
+void delBlueprintAIBatch(BlueprintAIBatch* batch)
+{
+	delete batch;
+}
+
+uint32_t batch_getAdvices(
+	BlueprintAIBatch* batch, const AdvBatchRequests* requests, AdvBatchAdvices* advices)
+{
+	if (!batch || !requests || !advices) return ADV_BATCH_ERROR;
+	try {
+		return batch->getAdvices(*requests, *advices);
+	}
+	catch (...) {
+		return ADV_BATCH_ERROR;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+// C interface advising the spots of many tables in one call, e.g. from
+// Python or Go services through one FFI crossing. It only uses C types.
+// Each request is stateless: it holds the whole public history of its hand.
+// The arrays are owned by the caller in struct-of-arrays layout, and are
+// read and written in place, without allocating per call.
+
+#include <stdint.h>
+#include "BlueprintAILibAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The requests i in [0, nRequests).
+typedef struct
+{
+	uint32_t nRequests;
+	const uint32_t* antes;
+	const uint32_t* bbs;
+	// nRequests * MAX_PLAYERS(): the stakes of the request i start at i * MAX_PLAYERS().
+	const uint32_t* stakes;
+	const uint8_t* dealers;
+	// Advised player, who must be acting after the history.
+	const uint8_t* myPositions;
+	// nRequests * 2 card indices (4 * rank + suit).
+	const uint8_t* hands;
+	// At least the board cards of the round reached by the history.
+	const uint8_t* nBoardCards;
+	// nRequests * 5 card indices, of which the first nBoardCards[i] are read.
+	const uint8_t* boardCards;
+	// nRequests + 1: the history of the request i is in [historyBegins[i], historyBegins[i + 1]).
+	const uint32_t* historyBegins;
+	// Actions (FOLD(), CALL() or RAISE()) since the blinds, with their bets,
+	// only read for the raises.
+	const uint8_t* historyActions;
+	const uint32_t* historyBets;
+} AdvBatchRequests;
+
+// The advices of the requests, as the ones of adv_getAdvices.
+typedef struct
+{
+	// 0 if advised, 1 if invalid, 2 if the advised player is not acting,
+	// 3 if the history could not be replayed. The other fields are only
+	// set for the advised requests.
+	uint8_t* status;
+	uint8_t* aiActions;
+	uint32_t* aiBets;
+	uint8_t* nActions;
+	// nRequests * MAX_ACTIONS(): the actions of the request i start at i * MAX_ACTIONS().
+	uint8_t* probas;
+	uint8_t* actions;
+	uint32_t* bets;
+} AdvBatchAdvices;
+
+typedef struct BlueprintAIBatch BlueprintAIBatch;
+
+BLUEPRINTAILIB_API int FOLD();
+BLUEPRINTAILIB_API int CALL();
+BLUEPRINTAILIB_API int RAISE();
+
+BLUEPRINTAILIB_API int ABC_FOLD();
+BLUEPRINTAILIB_API int ABC_CALL();
+BLUEPRINTAILIB_API int ABC_ALLIN();
+BLUEPRINTAILIB_API int ABC_RAISE();
+
+BLUEPRINTAILIB_API int MAX_PLAYERS();
+BLUEPRINTAILIB_API int MAX_ACTIONS();
+
+// Returned by batch_getAdvices when the batch could not be advised.
+#define ADV_BATCH_ERROR UINT32_MAX
+
+// Load the blueprint once for nThreads advisors, or one per hardware thread
+// with nThreads = 0. Set rngSeed to 0 to set a random seed.
+// Return NULL if the batch could not be created, e.g. without the blueprint files.
+BLUEPRINTAILIB_API BlueprintAIBatch* newBlueprintAIBatch(unsigned nThreads, unsigned rngSeed);
+BLUEPRINTAILIB_API void delBlueprintAIBatch(BlueprintAIBatch* batch);
+// Advise all the requests, split among the threads of batch, and return the
+// number of advised ones, or ADV_BATCH_ERROR if an argument is NULL or the
+// advising failed, in which case the advices may be partly written.
+// Only one call at a time is served by a batch.
+BLUEPRINTAILIB_API uint32_t batch_getAdvices(
+	BlueprintAIBatch* batch, const AdvBatchRequests* requests, AdvBatchAdvices* advices);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
\ No newline at end of file
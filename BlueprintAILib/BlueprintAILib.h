@@ -1,26 +1,12 @@
 #pragma once
 
 #include "../Blueprint/BlueprintAIAdvisor.h"
-
-#ifdef BLUEPRINTAILIB_EXPORTS
-#define BLUEPRINTAILIB_API __declspec(dllexport)
-#else
-#define BLUEPRINTAILIB_API __declspec(dllimport)
-#endif
+#include "BlueprintAILibAPI.h"
+// Declares the constants (FOLD(), MAX_PLAYERS()...) of both interfaces.
+#include "BlueprintAIBatch.h"
 
 extern "C" {
 	
-BLUEPRINTAILIB_API int FOLD();
-BLUEPRINTAILIB_API int CALL();
-BLUEPRINTAILIB_API int RAISE();
-
-BLUEPRINTAILIB_API int ABC_FOLD();
-BLUEPRINTAILIB_API int ABC_CALL();
-BLUEPRINTAILIB_API int ABC_ALLIN();
-BLUEPRINTAILIB_API int ABC_RAISE();
-
-BLUEPRINTAILIB_API int MAX_PLAYERS();
-
 BLUEPRINTAILIB_API bp::BlueprintAIAdvisor* newBlueprintAIAdvisor(unsigned rngSeed = 0);
 BLUEPRINTAILIB_API void delBlueprintAIAdvisor(bp::BlueprintAIAdvisor* advisor);
 BLUEPRINTAILIB_API void adv_startNewHand(
@@ -0,0 +1,13 @@
+#pragma once
+
+// Exported functions of the library: a DLL on Windows, and on Linux a shared
+// object built by the Makefile with -fvisibility=hidden so that only them are exported.
+#ifdef _WIN32
+#ifdef BLUEPRINTAILIB_EXPORTS
+#define BLUEPRINTAILIB_API __declspec(dllexport)
+#else
+#define BLUEPRINTAILIB_API __declspec(dllimport)
+#endif
+#else
+#define BLUEPRINTAILIB_API __attribute__((visibility("default")))
+#endif
\ No newline at end of file
@@ -6,7 +6,7 @@ int main()
 	const unsigned rngSeed = 1;
 	const uint64_t updatePeriod = (uint64_t)1e3;
 
-	bp::BlueprintCalculator calculator(rngSeed, false);
+	bp::BlueprintCalculator calculator(rngSeed, false, false);
 	double duration;
 
 	// Calculate blueprint.
@@ -1,9 +1,12 @@
 #include "../Blueprint/BlueprintCalculator.h"
 
-int main()
+// When the blueprint is trained by several processes,
+// each one is launched with its worker id as argument.
+int main(int argc, char* argv[])
 {
 	const unsigned rngSeed = 1;
+	const unsigned workerId = (argc > 1) ? std::stoul(argv[1]) : 0;
 
-	bp::BlueprintCalculator calculator(rngSeed);
+	bp::BlueprintCalculator calculator(rngSeed, true, true, workerId);
 	calculator.buildStrategy();
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "../Blueprint/Blueprint.h"
 #include "../Utils/Histogram.h"
 #include "../Utils/VectorMemory.h"
+#include <format>
 
 int main()
 {
@@ -40,7 +41,7 @@ int main()
 	handRegretsFile.close();
 
 	opt::freeVectMem(blueprint.regrets);
-	blueprint.loadStrat();
+	blueprint.loadStratRounds();
 
 	// Histogram of all probas.
 	auto allProbasFile = opt::fstream(
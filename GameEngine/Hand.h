@@ -18,7 +18,7 @@ public:
     Hand(const omp::Hand& hand) : omp::Hand(hand) {}
     Hand(const std::string& handStr);
 
-    template<unsigned nCards>
+    template<size_t nCards>
     Hand(const std::array<uint8_t, nCards>& handArr)
     {
         if (nCards == 0)
@@ -1,5 +1,6 @@
 #include "../LossyAbstraction/LossyIndexer.h"
 #include "../Blueprint/Constants.h"
+#include <format>
 
 // Return the strengths a round's hand buckets.
 // The strength of a bucket is defined to be the average
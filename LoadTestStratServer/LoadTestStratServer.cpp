@@ -0,0 +1,118 @@
+#include "../Blueprint/StratServer.h"
+#include "../Utils/Time.h"
+
+// Random spot of a hand where the acting player asks for advice,
+// reached with random legal actions.
+static bp::AdviceRequest randomRequest(
+	egn::GameState& state, const std::array<egn::chips, egn::MAX_PLAYERS>& stakes,
+	std::mt19937& rng, uint32_t id)
+{
+	static const uint8_t nRoundBoardCards[egn::N_ROUNDS] = { 0, 3, 4, 5 };
+
+	bp::AdviceRequest request{};
+	while (true) {
+		request.nHistory = 0;
+		state.stakes = stakes;
+		state.startNewHand((uint8_t)(rng() % bp::MAX_PLAYERS));
+		while (!state.finished && request.nHistory < bp::maxAdviceHistory) {
+			// Stop at each spot with a probability of 1/4.
+			if (rng() % 4 == 0) break;
+			state.action = state.actions[rng() % state.nActions];
+			egn::chips bet = 0;
+			if (state.action == egn::RAISE) {
+				bet = (state.allin <= state.minRaise) ? state.allin
+					: state.minRaise + (egn::chips)(rng() % (std::min(state.allin, 3 * state.minRaise) - state.minRaise + 1));
+				state.bet = bet;
+			}
+			request.actions[request.nHistory] = (uint8_t)state.action;
+			request.bets[request.nHistory] = bet;
+			++request.nHistory;
+			state.nextState();
+		}
+		if (!state.finished && request.nHistory < bp::maxAdviceHistory) break;
+	}
+
+	request.id = id;
+	request.ante = state.ante;
+	request.bb = state.bb;
+	for (uint8_t i = 0; i < bp::MAX_PLAYERS; ++i)
+		request.stakes[i] = state.initialStakes[i];
+	request.dealer = state.dealer;
+	request.myPosition = state.actingPlayer;
+	std::copy(state.hands[state.actingPlayer].begin(), state.hands[state.actingPlayer].end(), request.hand);
+	request.nBoardCards = nRoundBoardCards[state.round];
+	std::copy(state.boardCards.begin(), state.boardCards.begin() + request.nBoardCards, request.boardCards);
+	return request;
+}
+
+// Usage: LoadTestStratServer [nClients] [batchSize] [duration] [socketPath]
+// Connect nClients clients to a ServeBlueprintStrat server, each one sending
+// frames of batchSize requests for random spots and waiting for their answers
+// during duration seconds, then print the throughput and the latencies of the frames.
+int main(int argc, char* argv[])
+{
+	const unsigned nClients = (argc > 1) ? std::stoul(argv[1]) : 8;
+	const uint32_t batchSize = (argc > 2) ? std::stoul(argv[2]) : 16;
+	const double duration = (argc > 3) ? std::stod(argv[3]) : 10;
+	const std::string path = (argc > 4) ? argv[4] : bp::stratServerSocketPath();
+
+	std::array<egn::chips, egn::MAX_PLAYERS> stakes{};
+	for (uint8_t i = 0; i < bp::MAX_PLAYERS; ++i)
+		stakes[i] = bp::INITIAL_STAKE;
+
+	std::vector<std::vector<double>> latencies(nClients);
+	std::vector<uint64_t> nErrors(nClients, 0);
+	std::vector<std::thread> clients;
+	const opt::time_t startTime = opt::getTime();
+	for (unsigned c = 0; c < nClients; ++c) {
+		clients.emplace_back([&, c]() {
+			std::mt19937 rng(c + 1);
+			egn::GameState state(bp::ANTE, bp::BIG_BLIND, stakes, c + 1);
+			bp::StratClient client;
+			client.connect(path);
+
+			std::vector<bp::AdviceRequest> requests(batchSize);
+			std::vector<bp::AdviceResponse> responses;
+			uint32_t id = 0;
+			while (opt::getDuration(startTime) < duration) {
+				for (auto& request : requests)
+					request = randomRequest(state, stakes, rng, id++);
+				const opt::time_t frameTime = opt::getTime();
+				client.advise(requests, responses);
+				latencies[c].push_back(opt::getDuration(frameTime));
+				for (uint32_t i = 0; i < batchSize; ++i)
+					if (responses[i].status != bp::ADVICE_OK || responses[i].id != requests[i].id)
+						++nErrors[c];
+			}
+		});
+	}
+	for (auto& t : clients) t.join();
+	const double totalDuration = opt::getDuration(startTime);
+
+	std::vector<double> allLatencies;
+	for (const auto& l : latencies)
+		allLatencies.insert(allLatencies.end(), l.begin(), l.end());
+	std::sort(allLatencies.begin(), allLatencies.end());
+	if (allLatencies.empty())
+		throw std::runtime_error("No frame was answered.");
+	const uint64_t nFrames = allLatencies.size();
+	const uint64_t nRequests = nFrames * batchSize;
+	auto percentile = [&](double p) {
+		return allLatencies[std::min((size_t)(p * nFrames), (size_t)nFrames - 1)];
+	};
+
+	std::cout
+		<< nClients << " clients, " << batchSize << " requests/frame\n"
+		<< opt::prettyNumDg(nRequests, 3, true) << "requests in "
+		<< opt::prettyNumDg(totalDuration, 3, true) << "s\n"
+		<< opt::prettyNumDg(nRequests / totalDuration, 3, true) << "requests/s\n"
+		<< opt::prettyNumDg(nFrames / totalDuration, 3, true) << "frames/s\n\n"
+
+		<< "Latency per frame:\n"
+		<< "p50: " << opt::prettyNumDg(percentile(0.5), 3, true) << "s\n"
+		<< "p90: " << opt::prettyNumDg(percentile(0.9), 3, true) << "s\n"
+		<< "p99: " << opt::prettyNumDg(percentile(0.99), 3, true) << "s\n"
+		<< "max: " << opt::prettyNumDg(allLatencies.back(), 3, true) << "s\n\n"
+
+		<< "Requests not advised: " << std::accumulate(nErrors.begin(), nErrors.end(), (uint64_t)0) << "\n";
+}
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
 #include "hand_index.h"
 
 namespace abc {
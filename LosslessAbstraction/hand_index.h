@@ -147,6 +147,8 @@ struct hand_indexer_state_s {
 
 } // abc
 
+// GCC and Clang have these builtins.
+#ifdef _WIN32
 #include <intrin.h>
 
 static inline int __builtin_ctz(unsigned x) {
@@ -156,5 +158,6 @@ static inline int __builtin_ctz(unsigned x) {
 }
 
 #define __builtin_popcount __popcnt
+#endif
 
 #endif /* _HAND_INDEX_H_ */
\ No newline at end of file
@@ -1,7 +1,6 @@
 #ifndef ABC_DKEM_H
 #define ABC_DKEM_H
 
-#include <format>
 #include "EquityCalculator.h"
 #include "KMeans.h"
 #include "../Utils/ioContainer.h"
@@ -57,14 +56,14 @@ public:
 	static void savePreflopBckLUT()
 	{
 		opt::saveArray(PREFLOP_BCK_LUT,
-			bckLutDir + std::format("PREFLOP_{}_BCK_LUT.bin", nBckPreflop));
+			bckLutDir + "PREFLOP_" + std::to_string(nBckPreflop) + "_BCK_LUT.bin");
 		// Write clusters' centers.
 		opt::saveArray(PREFLOP_CENTERS,
-			bckLutDir + std::format("PREFLOP_{}_CENTERS.bin", nBckPreflop));
+			bckLutDir + "PREFLOP_" + std::to_string(nBckPreflop) + "_CENTERS.bin");
 		// Write inertia and min weight.
 		auto file = opt::fstream(
-			bckLutDir + std::format("PREFLOP_{}_BCK - inertia={}, min_weight={}",
-				nBckPreflop, preflopInertia, preflopMinWeight),
+			bckLutDir + "PREFLOP_" + std::to_string(nBckPreflop)
+				+ "_BCK - inertia=" + std::to_string(preflopInertia) + ", min_weight=" + std::to_string(preflopMinWeight),
 			std::ios::out);
 		file.close();
 	}
@@ -72,14 +71,14 @@ public:
 	static void saveFlopBckLUT()
 	{
 		opt::saveArray(FLOP_BCK_LUT,
-			bckLutDir + std::format("FLOP_{}_BCK_LUT.bin", nBckFlop));
+			bckLutDir + "FLOP_" + std::to_string(nBckFlop) + "_BCK_LUT.bin");
 		// Write clusters' centers.
 		opt::saveArray(FLOP_CENTERS,
-			bckLutDir + std::format("FLOP_{}_CENTERS.bin", nBckFlop));
+			bckLutDir + "FLOP_" + std::to_string(nBckFlop) + "_CENTERS.bin");
 		// Write inertia and min weight.
 		auto file = opt::fstream(
-			bckLutDir + std::format("FLOP_{}_BCK - inertia={}, min_weight={}",
-				nBckFlop, flopInertia, flopMinWeight),
+			bckLutDir + "FLOP_" + std::to_string(nBckFlop)
+				+ "_BCK - inertia=" + std::to_string(flopInertia) + ", min_weight=" + std::to_string(flopMinWeight),
 			std::ios::out);
 		file.close();
 	}
@@ -87,14 +86,14 @@ public:
 	static void saveTurnBckLUT()
 	{
 		opt::saveArray(TURN_BCK_LUT,
-			bckLutDir + std::format("TURN_{}_BCK_LUT.bin", nBckTurn));
+			bckLutDir + "TURN_" + std::to_string(nBckTurn) + "_BCK_LUT.bin");
 		// Write clusters' centers.
 		opt::saveArray(TURN_CENTERS,
-			bckLutDir + std::format("TURN_{}_CENTERS.bin", nBckTurn));
+			bckLutDir + "TURN_" + std::to_string(nBckTurn) + "_CENTERS.bin");
 		// Write inertia and min weight.
 		auto file = opt::fstream(
-			bckLutDir + std::format("TURN_{}_BCK - inertia={}, min_weight={}",
-				nBckTurn, turnInertia, turnMinWeight),
+			bckLutDir + "TURN_" + std::to_string(nBckTurn)
+				+ "_BCK - inertia=" + std::to_string(turnInertia) + ", min_weight=" + std::to_string(turnMinWeight),
 			std::ios::out);
 		file.close();
 	}
@@ -102,19 +101,19 @@ public:
 	static void loadPreflopBckLUT()
 	{
 		opt::loadArray(PREFLOP_BCK_LUT,
-			bckLutDir + std::format("PREFLOP_{}_BCK_LUT.bin", nBckPreflop));
+			bckLutDir + "PREFLOP_" + std::to_string(nBckPreflop) + "_BCK_LUT.bin");
 	}
 
 	static void loadFlopBckLUT()
 	{
 		opt::loadArray(FLOP_BCK_LUT,
-			bckLutDir + std::format("FLOP_{}_BCK_LUT.bin", nBckFlop));
+			bckLutDir + "FLOP_" + std::to_string(nBckFlop) + "_BCK_LUT.bin");
 	}
 
 	static void loadTurnBckLUT()
 	{
 		opt::loadArray(TURN_BCK_LUT,
-			bckLutDir + std::format("TURN_{}_BCK_LUT.bin", nBckTurn));
+			bckLutDir + "TURN_" + std::to_string(nBckTurn) + "_BCK_LUT.bin");
 	}
 
 	static std::array<bckSize_t, PREFLOP_SIZE> PREFLOP_BCK_LUT;
@@ -5,6 +5,7 @@
 #include <cstring>
 #include <chrono>
 #include <iostream>
+#include <iomanip>
 #include "Metrics.h"
 #include "../Utils/Random.h"
 
@@ -46,7 +47,7 @@ public:
 		CLabels& bestLabels,
 		CCenters& bestCenters)
 	{
-		typedef CData::value_type::value_type feature_t;
+		typedef typename CData::value_type::value_type feature_t;
 #pragma warning(suppress: 4267)
 		nSamples = data.size();
 #pragma warning(suppress: 4267)
@@ -33,14 +33,14 @@ public:
 	static void saveRivBckLUT()
 	{
 		opt::saveArray(RIV_BCK_LUT,
-			bckLutDir + std::format("RIV_{}_BCK_LUT.bin", nBckRiver));
+			bckLutDir + "RIV_" + std::to_string(nBckRiver) + "_BCK_LUT.bin");
 		// Write clusters' centers.
 		opt::saveArray(RIV_CENTERS,
-			bckLutDir + std::format("RIV_{}_CENTERS.bin", nBckRiver));
+			bckLutDir + "RIV_" + std::to_string(nBckRiver) + "_CENTERS.bin");
 		// Write inertia and min weight.
 		auto file = opt::fstream(
-			bckLutDir + std::format("RIV_{}_BCK - inertia={}, min_weight={}",
-				nBckRiver, rivInertia, rivMinWeight),
+			bckLutDir + "RIV_" + std::to_string(nBckRiver)
+				+ "_BCK - inertia=" + std::to_string(rivInertia) + ", min_weight=" + std::to_string(rivMinWeight),
 			std::ios::out);
 		file.close();
 	}
@@ -48,7 +48,7 @@ public:
 	static void loadRivBckLUT()
 	{
 		opt::loadArray(RIV_BCK_LUT,
-			bckLutDir + std::format("RIV_{}_BCK_LUT.bin", nBckRiver));
+			bckLutDir + "RIV_" + std::to_string(nBckRiver) + "_BCK_LUT.bin");
 	}
 
 	static std::array<bckSize_t, CMB_RIVER_SIZE> RIV_BCK_LUT;
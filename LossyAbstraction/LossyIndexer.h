@@ -4,6 +4,7 @@
 #include "DKEM.h"
 #include "KOC.h"
 #include "../GameEngine/GameState.h"
+#include <mutex>
 
 namespace abc {
 
@@ -11,13 +12,18 @@ template<typename bckSize_t, bckSize_t nBckPreflop, bckSize_t nBckFlop, bckSize_
 class LossyIndexer
 {
 public:
+	// The tables are shared by all the indexers, so they are only loaded
+	// once, even when the indexers are built by several threads.
 	static void loadLUT()
 	{
-		if constexpr (nBckPreflop < abc::PREFLOP_SIZE)
-			dkem.loadPreflopBckLUT();
-		dkem.loadFlopBckLUT();
-		dkem.loadTurnBckLUT();
-		koc.loadRivBckLUT();
+		static std::once_flag loaded;
+		std::call_once(loaded, [] {
+			if constexpr (nBckPreflop < abc::PREFLOP_SIZE)
+				dkem.loadPreflopBckLUT();
+			dkem.loadFlopBckLUT();
+			dkem.loadTurnBckLUT();
+			koc.loadRivBckLUT();
+		});
 	}
 
 	static bckSize_t handIndex(
@@ -0,0 +1,34 @@
+#include "../Blueprint/CheckpointMerger.h"
+#include "../Utils/Progression.h"
+
+// Usage: MergeBlueprintCheckpoints runDir1[:weight1] runDir2[:weight2] ...
+// The runs are merged into the checkpoint of the current blueprint.
+// Without weights, each run is weighted by its number of iterations.
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> runDirs;
+	std::vector<double> weights;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		const size_t sep = arg.rfind(':');
+		// Do not split a Windows drive letter.
+		if (sep != std::string::npos && sep > 1) {
+			weights.push_back(std::stod(arg.substr(sep + 1)));
+			arg = arg.substr(0, sep);
+		}
+		if (arg.back() != '/' && arg.back() != '\\') arg += '/';
+		runDirs.push_back(arg);
+	}
+	if (!weights.empty() && weights.size() != runDirs.size()) {
+		std::cout << "Either all or none of the runs must have a weight.\n";
+		return 1;
+	}
+
+	opt::time_t startTime = opt::getTime();
+	bp::CheckpointMerger merger(runDirs, weights);
+	merger.merge();
+
+	std::cout
+		<< "Merged " << runDirs.size() << " runs into " << bp::blueprintName()
+		<< " in " << opt::prettyDuration(opt::getDuration(startTime)) << "\n";
+}
\ No newline at end of file
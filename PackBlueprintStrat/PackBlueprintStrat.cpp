@@ -0,0 +1,24 @@
+#include "../Blueprint/StratFile.h"
+#include "../AbstractInfoset/ActionSeqSize.h"
+#include "../Utils/Progression.h"
+
+// Pack the strategy files of each round of the current blueprint in the
+// strategy file mapped by Blueprint, e.g. for a blueprint built before it existed.
+// With the argument q4, write the strategy quantized to 4 bits instead.
+int main(int argc, char* argv[])
+{
+	opt::time_t startTime = opt::getTime();
+
+	const bool isQ4 = argc > 1 && std::string(argv[1]) == "q4";
+
+	const abc::ActionSeqSize seqSizes(bp::BLUEPRINT_GAME_NAME);
+	bp::packStratFile(
+		bp::BLUEPRINT_GAME_NAME, bp::blueprintName(),
+		{ bp::N_BCK_PREFLOP, bp::N_BCK_FLOP, bp::N_BCK_TURN, bp::N_BCK_RIVER },
+		{ seqSizes.preflopSize, seqSizes.flopSize, seqSizes.turnSize, seqSizes.riverSize },
+		isQ4 ? bp::STRAT_Q4 : bp::STRAT_U8);
+
+	std::cout
+		<< "Packed the " << (isQ4 ? "quantized " : "") << "strategy of " << bp::blueprintName()
+		<< " in " << opt::prettyDuration(opt::getDuration(startTime)) << "\n";
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 
 #include "../LossyAbstraction/DKEM.h"
+#include <format>
 
 template<typename cluSize_t, typename feature_t, uint32_t nSamples, uint8_t nFeatures>
 uint64_t calculateInertia(
@@ -6,7 +6,7 @@ int main()
 	const unsigned handIdx = 0;
 
 	bp::Blueprint blueprint(bp::BLUEPRINT_GAME_NAME, bp::BLUEPRINT_BUILD_NAME);
-	blueprint.loadStrat();
+	blueprint.loadStratRounds();
 	blueprint.loadRegrets();
 
 	abc::GroupedActionSeqs gpSeqs(bp::BLUEPRINT_GAME_NAME);
@@ -0,0 +1,35 @@
+#include "../Blueprint/ReachPruner.h"
+#include "../Utils/Progression.h"
+
+// Usage: PruneBlueprintStrat [nHands] [minReach]
+// Estimate the probabilities of reaching the infosets of the current blueprint
+// by simulating nHands hands of it against itself, then write the strategy file
+// without the rows reached with a probability below minReach, read by the AI
+// when prunedStrat is true.
+int main(int argc, char* argv[])
+{
+	const uint64_t nHands = (argc > 1) ? std::stoull(argv[1]) : (uint64_t)100e6;
+	const double minReach = (argc > 2) ? std::stod(argv[2]) : 1e-6;
+	const unsigned nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	opt::time_t startTime = opt::getTime();
+	bp::ReachPruner pruner(nThreads);
+	pruner.simulate(nHands);
+	std::cout
+		<< "Simulated " << opt::prettyNum(nHands, 1) << " hands"
+		<< " in " << opt::prettyDuration(opt::getDuration(startTime)) << "\n";
+
+	startTime = opt::getTime();
+	pruner.writePrunedStrat(minReach);
+	std::cout
+		<< "Pruned the strategy of " << bp::blueprintName()
+		<< " in " << opt::prettyDuration(opt::getDuration(startTime)) << "\n";
+
+	const std::array<double, egn::N_ROUNDS> keptRatios = pruner.keptRatios(minReach);
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+		std::cout
+			<< egn::roundToString(r) << ": " << std::setprecision(3)
+			<< 100 * keptRatios[r] << "% of the rows kept\n";
+	std::cout
+		<< "size: " << opt::prettyNum(std::filesystem::file_size(bp::prunedStratFilePath()), 2, true) << "o\n";
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "../Blueprint/StratServer.h"
+#include "../Utils/Time.h"
+
+// Usage: ServeBlueprintStrat [nWorkers] [maxBatch] [socketPath]
+// Load the current blueprint once and serve its advices to the other processes
+// of the machine at socketPath (stratServerSocketPath by default), with nWorkers
+// threads each serving up to maxBatch requests at once. See LoadTestStratServer.
+int main(int argc, char* argv[])
+{
+	const unsigned nWorkers = (argc > 1) ? std::stoul(argv[1]) : std::max(std::thread::hardware_concurrency(), 1u);
+	const uint32_t maxBatch = (argc > 2) ? std::stoul(argv[2]) : 256;
+	const std::string path = (argc > 3) ? argv[3] : bp::stratServerSocketPath();
+
+	const opt::time_t startTime = opt::getTime();
+	bp::StratServer server(nWorkers, maxBatch);
+	std::cout
+		<< "Loaded " << bp::blueprintName()
+		<< " in " << opt::prettyDuration(opt::getDuration(startTime)) << "\n"
+		<< "Serving with " << nWorkers << " workers at " << path << "\n";
+	server.run(path);
+}
\ No newline at end of file
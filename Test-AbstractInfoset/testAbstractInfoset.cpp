@@ -1,8 +1,11 @@
 #include "pch.h"
+#include "../AbstractInfoset/AbstractInfoset.h"
 #include "../AbstractInfoset/ActionSeqIndexer.h"
+#include "../AbstractInfoset/ActionSeqSize.h"
 #include "../AbstractInfoset/GroupedActionSeqsInv.h"
 #include "../AbstractInfoset/TreeTraverser.h"
 #include "../Blueprint/Constants.h"
+#include "../Blueprint/BlueprintAIAdvisor.h"
 
 TEST(ActionSeqIndexerTest, HashIsMinimalPerfect)
 {
@@ -34,6 +37,86 @@ TEST(ActionSeqIndexerTest, HashIsMinimalPerfect)
 	}
 }
 
+TEST(ActionSeqIndexerTest, SharedIndexerIsLoadedOnce)
+{
+	std::shared_ptr<abc::ActionSeqIndexer> indexer = abc::ActionSeqIndexer::loadShared(
+		bp::MAX_PLAYERS, bp::ANTE, bp::BIG_BLIND,
+		bp::INITIAL_STAKE, bp::BET_SIZES, bp::BLUEPRINT_GAME_NAME);
+	std::shared_ptr<abc::ActionSeqIndexer> otherIndexer = abc::ActionSeqIndexer::loadShared(
+		bp::MAX_PLAYERS, bp::ANTE, bp::BIG_BLIND,
+		bp::INITIAL_STAKE, bp::BET_SIZES, bp::BLUEPRINT_GAME_NAME);
+	EXPECT_EQ(indexer, otherIndexer);
+	EXPECT_EQ(abc::ActionSeqIndexer::findShared(bp::BLUEPRINT_GAME_NAME), indexer);
+
+	// The sizes are the ones written with the MPHFs.
+	const abc::ActionSeqSize seqSizes(bp::BLUEPRINT_GAME_NAME);
+	EXPECT_EQ(seqSizes.preflopSize, indexer->preflopMPHF.nbKeys());
+	EXPECT_EQ(seqSizes.riverSize, indexer->riverMPHF.nbKeys());
+
+	// The indexer is freed with its last user.
+	indexer.reset();
+	otherIndexer.reset();
+	EXPECT_EQ(abc::ActionSeqIndexer::findShared(bp::BLUEPRINT_GAME_NAME), nullptr);
+}
+
+TEST(AbstractInfosetTest, RangeHandsContainAllHands)
+{
+	std::vector<bool> flags(omp::CARD_COUNT * omp::CARD_COUNT, false);
+	for (uint16_t h = 0; h < omp::COMBO_COUNT; ++h) {
+		const uint8_t c0 = abc::rangeHands[h][0], c1 = abc::rangeHands[h][1];
+		EXPECT_LT(c0, omp::CARD_COUNT);
+		EXPECT_LT(c1, c0);
+		EXPECT_EQ(c0 * (c0 - 1) / 2 + c1, h);
+		EXPECT_FALSE(flags[c0 * omp::CARD_COUNT + c1]);
+		flags[c0 * omp::CARD_COUNT + c1] = true;
+	}
+}
+
+TEST(AbstractInfosetTest, RangeAdvicesMatchHandAdvices)
+{
+	bp::BlueprintAIAdvisor advisor(1);
+
+	// Everyone calls preflop, and the first player acting on the flop is advised.
+	std::array<egn::chips, bp::MAX_PLAYERS> stakes;
+	stakes.fill(bp::INITIAL_STAKE);
+	const uint8_t hand[omp::HOLE_CARDS] = { 51, 46 };
+	const uint8_t board[omp::BOARD_CARDS] = { 0, 9, 18, 27, 36 };
+	const uint8_t dead[] = { 30, 35 };
+	std::array<uint8_t, bp::MAX_PLAYERS> history;
+	history.fill(egn::CALL);
+	const std::array<egn::chips, bp::MAX_PLAYERS> bets{};
+
+	bp::AdviceStatus status = bp::ADVICE_NOT_ACTING;
+	for (uint8_t pos = 0; pos < bp::MAX_PLAYERS && status == bp::ADVICE_NOT_ACTING; ++pos) {
+		status = advisor.adviseSpot(
+			bp::ANTE, bp::BIG_BLIND, stakes.data(), 0, pos, hand,
+			board, 3, history.data(), bets.data(), bp::MAX_PLAYERS);
+	}
+	ASSERT_EQ(status, bp::ADVICE_OK);
+	const uint8_t nActions = advisor.nActions;
+	const std::vector<uint8_t> handProbas(advisor.probas, advisor.probas + nActions);
+
+	std::vector<float> rangeProbas;
+	advisor.getRangeAdvices((1ull << dead[0]) | (1ull << dead[1]), rangeProbas);
+	ASSERT_EQ(rangeProbas.size(), (size_t)omp::COMBO_COUNT * nActions);
+
+	const uint64_t deadOrBoard = (1ull << dead[0]) | (1ull << dead[1])
+		| (1ull << board[0]) | (1ull << board[1]) | (1ull << board[2]);
+	for (uint16_t h = 0; h < omp::COMBO_COUNT; ++h) {
+		const float* row = rangeProbas.data() + h * nActions;
+		const uint64_t cards = (1ull << abc::rangeHands[h][0]) | (1ull << abc::rangeHands[h][1]);
+		float sum = 0;
+		for (uint8_t a = 0; a < nActions; ++a) sum += row[a];
+		if (cards & deadOrBoard) EXPECT_EQ(sum, 0.0f);
+		else EXPECT_NEAR(sum, 1.0f, 1e-4f);
+	}
+
+	// The row of the advised hand, rounded like calculateProbasPerc.
+	const uint16_t h = hand[0] * (hand[0] - 1) / 2 + hand[1];
+	for (uint8_t a = 0; a < nActions; ++a)
+		EXPECT_NEAR(100 * rangeProbas[h * nActions + a], handProbas[a], 1.0f);
+}
+
 class GroupedActionSeqsTest : public ::testing::Test
 {
 protected:
@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "../Blueprint/RegretTable.h"
+#include "../Blueprint/BlueprintCalculator.h"
+#include "../OMPEval/omp/Random.h"
+#include <cmath>
+#include <vector>
+
+// The lazy discounting of the rows must give the regrets
+// and the pruned masks of the eager one.
+class RegretTableTest : public ::testing::Test
+{
+protected:
+    typedef bp::regret_t regret_t;
+    typedef bp::prunedMask_t prunedMask_t;
+
+    void SetUp() override
+    {
+        omp::XoroShiro128Plus rng(1);
+        auto lenDist = omp::FastUniformIntDistribution<uint8_t>(1, 6);
+        auto regretDist = omp::FastUniformIntDistribution<uint32_t>(0, bp::maxRegret - bp::minRegret);
+        // Regrets below the pruning threshold, but above it once discounted.
+        auto prunedDist = omp::FastUniformIntDistribution<uint32_t>(0, bp::pruneThreshold - bp::minRegret);
+
+        gpSeqs.resize(egn::N_ROUNDS);
+        gpLens.resize(egn::N_ROUNDS);
+        for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+            gpSeqs[r].resize(nSeqs[r]);
+            for (uint32_t i = 0; i < nSeqs[r]; ++i) gpSeqs[r][i] = i;
+            for (uint32_t i = (uint32_t)nSeqs[r] - 1; i > 0; --i)
+                std::swap(gpSeqs[r][i], gpSeqs[r][omp::FastUniformIntDistribution<uint32_t>(0, i)(rng)]);
+            size_t n = 0;
+            while (n < nSeqs[r]) {
+                const uint8_t len = (uint8_t)(std::min)((size_t)lenDist(rng), nSeqs[r] - n);
+                gpLens[r].push_back(len);
+                n += len;
+            }
+        }
+
+        regrets.setLayout(nBcks, nSeqs);
+        regrets.allocate();
+        regrets.setPruneMasks(gpSeqs, gpLens, bp::pruneThreshold);
+        for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+            for (size_t b = 0; b < nBcks[r]; ++b) {
+                for (size_t i = 0; i < nSeqs[r]; ++i) {
+                    regrets(r, b, i) = (i % 3 == 0)
+                        ? bp::minRegret + (regret_t)prunedDist(rng)
+                        : bp::minRegret + (regret_t)regretDist(rng);
+                }
+            }
+        }
+    }
+
+    // Factors of BlueprintCalculator::setDiscountFactors.
+    void setFactors(bool dcfr)
+    {
+        posFactors.assign(nEpochs, 1);
+        negFactors.assign(nEpochs, 1);
+        for (uint32_t k = 1; k < nEpochs; ++k) {
+            if (dcfr) {
+                posFactors[k] = std::pow(k, bp::dcfrAlpha) / (std::pow(k, bp::dcfrAlpha) + 1);
+                negFactors[k] = std::pow(k, bp::dcfrBeta) / (std::pow(k, bp::dcfrBeta) + 1);
+            }
+            else posFactors[k] = negFactors[k] = 1 - 1 / (double)(k + 1);
+        }
+        regrets.setDiscountFactors(posFactors, negFactors);
+    }
+
+    // Move epoch by epoch, discounting a copy of the regrets eagerly, and refresh
+    // each row every 1 to 3 epochs, comparing it with the copy once refreshed.
+    void checkLazyDiscount()
+    {
+        std::vector<std::vector<regret_t>> eager;
+        for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+            for (size_t b = 0; b < nBcks[r]; ++b)
+                eager.emplace_back(regrets.row(r, b), regrets.row(r, b) + nSeqs[r]);
+        }
+
+        regrets.resetEpochs(0);
+        checkMasks();
+        for (uint32_t k = 1; k < nEpochs; ++k) {
+            regrets.setEpoch(k);
+            size_t rowIdx = 0;
+            for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+                for (size_t b = 0; b < nBcks[r]; ++b, ++rowIdx) {
+                    std::vector<regret_t>& row = eager[rowIdx];
+                    for (regret_t& x : row)
+                        x = (regret_t)std::round(x * (float)((x > 0) ? posFactors[k] : negFactors[k]));
+                    if (k % (1 + rowIdx % 3) != 0 && k != nEpochs - 1) continue;
+
+                    regrets.refreshRow(r, b);
+                    for (size_t i = 0; i < nSeqs[r]; ++i) {
+                        // Each eager discounting rounds the regrets and the lazy one
+                        // multiplies them by the product of the factors in float.
+                        EXPECT_NEAR(regrets(r, b, i), row[i], k + 1e-6 * std::abs(row[i]))
+                            << "round " << (int)r << ", bucket " << b << ", epoch " << k;
+                    }
+                }
+            }
+        }
+        checkMasks();
+    }
+
+    // The bit a of a mask is set if the regret of the a-th action of its infoset is pruned.
+    void checkMasks()
+    {
+        for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+            for (size_t b = 0; b < nBcks[r]; ++b) {
+                size_t groupPos = 0;
+                for (const uint8_t len : gpLens[r]) {
+                    prunedMask_t mask = 0;
+                    for (uint8_t a = 0; a < len; ++a) {
+                        if (regrets(r, b, gpSeqs[r][groupPos + a]) <= bp::pruneThreshold)
+                            mask |= (prunedMask_t)(1u << a);
+                    }
+                    EXPECT_EQ(regrets.prunedMask(r, b, gpSeqs[r][groupPos]), mask);
+                    groupPos += len;
+                }
+            }
+        }
+    }
+
+    const bp::RegretTable::roundSizes_t nBcks = { 4, 7, 5, 9 };
+    const bp::RegretTable::roundSizes_t nSeqs = { 13, 21, 17, 30 };
+    static const uint32_t nEpochs = 8;
+
+    std::vector<std::vector<uint32_t>> gpSeqs;
+    std::vector<std::vector<uint8_t>> gpLens;
+    bp::RegretTable regrets;
+    std::vector<double> posFactors, negFactors;
+};
+
+TEST_F(RegretTableTest, LazyDiscountMatchesEagerDCFR)
+{
+    setFactors(true);
+    checkLazyDiscount();
+}
+
+TEST_F(RegretTableTest, LazyDiscountMatchesEagerLinear)
+{
+    setFactors(false);
+    checkLazyDiscount();
+}
+
+// discountEpoch(n) is the number of iterations before n after which
+// the regrets are discounted, which can only be multiples of discountPeriod.
+TEST(DiscountTest, DiscountEpochCountsTheDiscountings)
+{
+    using bp::BlueprintCalculator;
+
+    uint32_t nDiscounts = 0;
+    const uint64_t lastIter = bp::discountStopIter + 2 * bp::discountPeriod;
+    for (uint64_t iter = 0; iter <= lastIter; iter += bp::discountPeriod) {
+        if (bp::discountPeriod > 1) {
+            if (iter) EXPECT_FALSE(BlueprintCalculator::mustDiscount(iter - 1));
+            EXPECT_FALSE(BlueprintCalculator::mustDiscount(iter + 1));
+        }
+        EXPECT_EQ(BlueprintCalculator::discountEpoch(iter), nDiscounts) << "iteration " << iter;
+        if (BlueprintCalculator::mustDiscount(iter)) ++nDiscounts;
+        EXPECT_EQ(BlueprintCalculator::discountEpoch(iter + 1), nDiscounts) << "iteration " << iter + 1;
+    }
+    // The regrets are discounted at least once before discountStopIter.
+    EXPECT_GT(nDiscounts, 0u);
+}
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "pch.h"
+#include "../Blueprint/StratFile.h"
+#include "../OMPEval/omp/Random.h"
+#include <filesystem>
+#include <vector>
+
+// Pack a small synthetic strategy in each encoding of StratFile
+// and read it back infoset by infoset.
+class StratFileTest : public ::testing::Test
+{
+protected:
+    typedef bp::strat_t strat_t;
+    static constexpr strat_t sumStrat = bp::sumStrat;
+
+    void SetUp() override
+    {
+        omp::XoroShiro128Plus rng(1);
+        auto lenDist = omp::FastUniformIntDistribution<uint8_t>(1, 5);
+        auto probaDist = omp::FastUniformIntDistribution<unsigned>(0, 100);
+
+        gpSeqs.seqs.resize(egn::N_ROUNDS);
+        gpSeqs.lens.resize(egn::N_ROUNDS);
+        for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+            // Group the sequences in a shuffled order, as in a real game.
+            auto& seqs = gpSeqs.seqs[r];
+            seqs.resize(nSeqs[r]);
+            for (uint32_t i = 0; i < nSeqs[r]; ++i) seqs[i] = i;
+            for (uint32_t i = nSeqs[r] - 1; i > 0; --i)
+                std::swap(seqs[i], seqs[omp::FastUniformIntDistribution<uint32_t>(0, i)(rng)]);
+            size_t n = 0;
+            while (n < nSeqs[r]) {
+                const uint8_t len = (uint8_t)(std::min)((size_t)lenDist(rng), nSeqs[r] - n);
+                gpSeqs.lens[r].push_back(len);
+                n += len;
+            }
+
+            // Random probabilities summing to sumStrat over each infoset.
+            strats[r].assign(nBcks[r] * nSeqs[r], 0);
+            for (size_t b = 0; b < nBcks[r]; ++b) {
+                size_t groupPos = 0;
+                for (const uint8_t len : gpSeqs.lens[r]) {
+                    std::vector<unsigned> w(len);
+                    unsigned sumW = 0;
+                    for (unsigned& x : w) sumW += x = probaDist(rng);
+                    if (sumW == 0) sumW = w[0] = 1;
+                    unsigned cum = 0, prevCum = 0;
+                    for (uint8_t k = 0; k < len; ++k) {
+                        cum += w[k];
+                        const unsigned roundedCum = (cum * sumStrat + sumW / 2) / sumW;
+                        strats[r][b * nSeqs[r] + seqs[groupPos + k]] = (strat_t)(roundedCum - prevCum);
+                        prevCum = roundedCum;
+                    }
+                    groupPos += len;
+                }
+            }
+        }
+
+        std::filesystem::create_directories(abc::groupedActionSeqsDir);
+        std::filesystem::create_directories(bp::blueprintDir(bpName));
+        gpSeqs.save();
+        for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+            opt::BinaryWriter file(bp::stratPath(bpName, r));
+            file.write(std::span(strats[r]));
+            file.close();
+        }
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(bp::blueprintDir(bpName));
+        std::filesystem::remove(abc::groupedActionSeqsDir + bpGameName + "_GROUPED_ACTION_SEQS.bin");
+    }
+
+    strat_t sourceProba(uint8_t r, size_t b, size_t seqIdx) const
+    {
+        return strats[r][b * nSeqs[r] + seqIdx];
+    }
+
+    uint64_t configHash() const { return bp::stratConfigHash(bpGameName, nBcks, nSeqs); }
+
+    const std::string bpGameName = "TEST_STRAT_FILE";
+    const std::string bpName = bp::blueprintName(bpGameName, "TEST");
+    // More than 64 hand buckets on some rounds for the bitsets of STRAT_PRUNED.
+    const bp::stratSizes_t nBcks = { 3, 70, 9, 130 };
+    const bp::stratSizes_t nSeqs = { 11, 17, 24, 31 };
+
+    abc::GroupedActionSeqs gpSeqs{ bpGameName };
+    std::array<std::vector<strat_t>, egn::N_ROUNDS> strats;
+};
+
+TEST_F(StratFileTest, U8RowsMatchTheStrategy)
+{
+    bp::packStratFile(bpGameName, bpName, nBcks, nSeqs, bp::STRAT_U8);
+    bp::StratFile file;
+    file.map(bp::stratFilePath(bpName), configHash());
+    ASSERT_EQ(file.encoding(), bp::STRAT_U8);
+
+    for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+        for (size_t b = 0; b < nBcks[r]; ++b) {
+            size_t groupPos = 0;
+            for (const uint8_t len : gpSeqs.lens[r]) {
+                unsigned cum = 0;
+                for (uint8_t k = 0; k < len; ++k) {
+                    const uint32_t seqIdx = gpSeqs.seqs[r][groupPos + k];
+                    EXPECT_EQ(file.proba(r, b, seqIdx), sourceProba(r, b, seqIdx));
+                    EXPECT_EQ(file.infosetPos(r, seqIdx), groupPos);
+                    EXPECT_EQ(file.infosetLen(r, seqIdx), len);
+                    cum += sourceProba(r, b, seqIdx);
+                    EXPECT_EQ(file.cumRow(r, b)[groupPos + k], cum);
+                }
+                groupPos += len;
+            }
+        }
+    }
+}
+
+TEST_F(StratFileTest, Q4ProbasSumToSumStrat)
+{
+    bp::packStratFile(bpGameName, bpName, nBcks, nSeqs, bp::STRAT_Q4);
+    bp::StratFile file;
+    file.map(bp::quantizedStratFilePath(bpName), configHash());
+    ASSERT_EQ(file.encoding(), bp::STRAT_Q4);
+
+    // The cumulated sums are rounded to the nearest step of sumStrat / 15,
+    // so each probability is at most one step away from its source.
+    const int step = sumStrat / 15;
+    for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+        for (size_t b = 0; b < nBcks[r]; ++b) {
+            size_t groupPos = 0;
+            for (const uint8_t len : gpSeqs.lens[r]) {
+                unsigned sum = 0;
+                for (uint8_t k = 0; k < len; ++k) {
+                    const uint32_t seqIdx = gpSeqs.seqs[r][groupPos + k];
+                    const strat_t p = file.proba(r, b, seqIdx);
+                    EXPECT_EQ(p % step, 0);
+                    EXPECT_LE(std::abs((int)p - (int)sourceProba(r, b, seqIdx)), step);
+                    sum += p;
+                }
+                EXPECT_EQ(sum, sumStrat);
+                groupPos += len;
+            }
+        }
+    }
+}
+
+TEST_F(StratFileTest, PrunedRowsFallBackToDefaultRow)
+{
+    // Keep one row out of three and weight the hand buckets unevenly.
+    bp::keptRows_t keptRows;
+    std::array<std::vector<double>, egn::N_ROUNDS> bckWeights;
+    for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+        const size_t nInfosets = gpSeqs.lens[r].size();
+        keptRows[r].resize(nBcks[r] * nInfosets);
+        bckWeights[r].resize(nBcks[r] * nInfosets);
+        for (size_t b = 0; b < nBcks[r]; ++b) {
+            for (size_t i = 0; i < nInfosets; ++i) {
+                keptRows[r][b * nInfosets + i] = (b + i) % 3 == 0;
+                bckWeights[r][b * nInfosets + i] = (double)(1 + (b * 7 + i) % 5);
+            }
+        }
+    }
+
+    bp::packPrunedStratFile(bpGameName, bpName, nBcks, nSeqs, keptRows, bckWeights);
+    bp::StratFile file;
+    file.map(bp::prunedStratFilePath(bpName), configHash());
+    ASSERT_EQ(file.encoding(), bp::STRAT_PRUNED);
+
+    for (uint8_t r = 0; r < egn::N_ROUNDS; ++r) {
+        const size_t nInfosets = gpSeqs.lens[r].size();
+        size_t groupPos = 0;
+        for (size_t i = 0; i < nInfosets; ++i) {
+            const uint8_t len = gpSeqs.lens[r][i];
+            double sumWeights = 0;
+            for (size_t b = 0; b < nBcks[r]; ++b) sumWeights += bckWeights[r][b * nInfosets + i];
+
+            for (uint8_t k = 0; k < len; ++k) {
+                const uint32_t seqIdx = gpSeqs.seqs[r][groupPos + k];
+                EXPECT_EQ(file.infosetLen(r, seqIdx), len);
+                double avg = 0;
+                for (size_t b = 0; b < nBcks[r]; ++b)
+                    avg += bckWeights[r][b * nInfosets + i] * sourceProba(r, b, seqIdx);
+                avg /= sumWeights;
+
+                for (size_t b = 0; b < nBcks[r]; ++b) {
+                    const strat_t p = file.proba(r, b, seqIdx);
+                    if (keptRows[r][b * nInfosets + i])
+                        EXPECT_EQ(p, sourceProba(r, b, seqIdx));
+                    // The cumulated sums of the default row are rounded.
+                    else EXPECT_LE(std::abs(p - avg), 1.0);
+                }
+            }
+
+            // The default row is a distribution too.
+            for (size_t b = 0; b < nBcks[r]; ++b) {
+                if (keptRows[r][b * nInfosets + i]) continue;
+                unsigned sum = 0;
+                for (uint8_t k = 0; k < len; ++k)
+                    sum += file.proba(r, b, gpSeqs.seqs[r][groupPos + k]);
+                EXPECT_EQ(sum, sumStrat);
+            }
+            groupPos += len;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#ifndef OPT_ASYNCWRITER_H
+#define OPT_ASYNCWRITER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+
+namespace opt {
+
+// Append lines to a text file from a background thread.
+// write() only pushes the line in a queue, so the caller
+// never waits for the disk.
+class AsyncWriter
+{
+public:
+	AsyncWriter() :
+		stopRequested(false)
+	{
+	}
+
+	~AsyncWriter()
+	{
+		close();
+	}
+
+	AsyncWriter(const AsyncWriter&) = delete;
+	AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+	void open(const std::string& path)
+	{
+		close();
+		file.open(path, std::ios::out | std::ios::app);
+		if (file.fail())
+			throw std::runtime_error("File could not be opened.");
+		stopRequested = false;
+		worker = std::thread(&AsyncWriter::run, this);
+	}
+
+	bool isOpen() const
+	{
+		return worker.joinable();
+	}
+
+	void write(std::string line)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			pending.push_back(std::move(line));
+		}
+		cv.notify_one();
+	}
+
+	// Write the remaining lines and close the file.
+	void close()
+	{
+		if (!worker.joinable()) return;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stopRequested = true;
+		}
+		cv.notify_one();
+		worker.join();
+		file.close();
+	}
+
+private:
+	void run()
+	{
+		std::vector<std::string> batch;
+		std::unique_lock<std::mutex> lock(mtx);
+		while (true) {
+			cv.wait(lock, [this] { return stopRequested || !pending.empty(); });
+			batch.swap(pending);
+			const bool mustStop = stopRequested;
+			lock.unlock();
+
+			for (const std::string& line : batch)
+				file << line << "\n";
+			file.flush();
+			batch.clear();
+
+			lock.lock();
+			if (mustStop && pending.empty()) return;
+		}
+	}
+
+	std::ofstream file;
+	std::thread worker;
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::vector<std::string> pending;
+	bool stopRequested;
+
+}; // AsyncWriter
+
+} // opt
+
+#endif // OPT_ASYNCWRITER_H
\ No newline at end of file
@@ -0,0 +1,137 @@
+#ifndef OPT_COMPRESSION_H
+#define OPT_COMPRESSION_H
+
+#include "io.h"
+#include "../tracy/zstd/zstd.h"
+#include <vector>
+#include <stdexcept>
+
+namespace opt {
+
+// Compress [src, src + size) in one zstd frame.
+// Low levels are the fastest, 1 is enough for most binary data.
+inline std::vector<char> zstdCompress(const void* src, size_t size, int level = 1)
+{
+	std::vector<char> res(ZSTD_compressBound(size));
+	const size_t n = ZSTD_compress(res.data(), res.size(), src, size, level);
+	if (ZSTD_isError(n))
+		throw std::runtime_error(std::string("Compression failed: ") + ZSTD_getErrorName(n));
+	res.resize(n);
+	return res;
+}
+
+// Decompress the zstd frame [src, src + size), which must hold exactly dstSize bytes.
+inline void zstdDecompress(const void* src, size_t size, void* dst, size_t dstSize)
+{
+	if (ZSTD_getFrameContentSize(src, size) != dstSize)
+		throw std::runtime_error("Compressed data of unexpected size.");
+	const size_t n = ZSTD_decompress(dst, dstSize, src, size);
+	if (ZSTD_isError(n))
+		throw std::runtime_error(std::string("Decompression failed: ") + ZSTD_getErrorName(n));
+}
+
+// Write a file compressed in one zstd frame, piece by piece.
+// Throw an exception if the file cannot be written: a truncated frame
+// would only be found when reading it.
+class ZstdWriter
+{
+public:
+	ZstdWriter(const std::string& path, int level = 1) :
+		file(path),
+		ctx(ZSTD_createCCtx()),
+		outBuf(ZSTD_CStreamOutSize())
+	{
+		ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+	}
+
+	~ZstdWriter()
+	{
+		ZSTD_freeCCtx(ctx);
+	}
+
+	ZstdWriter(const ZstdWriter&) = delete;
+	ZstdWriter& operator=(const ZstdWriter&) = delete;
+
+	void write(const void* src, size_t size)
+	{
+		ZSTD_inBuffer in{ src, size, 0 };
+		while (in.pos < in.size) compress(in, ZSTD_e_continue);
+	}
+
+	// End the frame. Nothing can be written afterwards.
+	void close()
+	{
+		ZSTD_inBuffer in{ nullptr, 0, 0 };
+		while (compress(in, ZSTD_e_end) != 0);
+		file.close();
+	}
+
+private:
+	size_t compress(ZSTD_inBuffer& in, ZSTD_EndDirective mode)
+	{
+		ZSTD_outBuffer out{ outBuf.data(), outBuf.size(), 0 };
+		const size_t res = ZSTD_compressStream2(ctx, &out, &in, mode);
+		if (ZSTD_isError(res))
+			throw std::runtime_error(std::string("Compression failed: ") + ZSTD_getErrorName(res));
+		file.write(outBuf.data(), out.pos);
+		return res;
+	}
+
+	BinaryWriter file;
+	ZSTD_CCtx* ctx;
+	std::vector<char> outBuf;
+
+}; // ZstdWriter
+
+// Read a file written by ZstdWriter, piece by piece.
+class ZstdReader
+{
+public:
+	ZstdReader(const std::string& path) :
+		file(opt::fstream(path, std::ios::in | std::ios::binary)),
+		ctx(ZSTD_createDCtx()),
+		inBuf(ZSTD_DStreamInSize()),
+		in{ inBuf.data(), 0, 0 }
+	{
+	}
+
+	~ZstdReader()
+	{
+		ZSTD_freeDCtx(ctx);
+	}
+
+	ZstdReader(const ZstdReader&) = delete;
+	ZstdReader& operator=(const ZstdReader&) = delete;
+
+	void read(void* dst, size_t size)
+	{
+		ZSTD_outBuffer out{ dst, size, 0 };
+		while (out.pos < out.size) {
+			const size_t prevPos = out.pos;
+			const size_t res = ZSTD_decompressStream(ctx, &out, &in);
+			if (ZSTD_isError(res))
+				throw std::runtime_error(std::string("Decompression failed: ") + ZSTD_getErrorName(res));
+			// Only read the file when the decompressor needs more input.
+			if (out.pos == prevPos && in.pos == in.size) {
+				file.read(inBuf.data(), inBuf.size());
+				if (file.bad())
+					throw std::runtime_error("Compressed file could not be read.");
+				in.size = (size_t)file.gcount();
+				in.pos = 0;
+				if (!in.size)
+					throw std::runtime_error("Compressed file shorter than expected.");
+			}
+		}
+	}
+
+private:
+	std::fstream file;
+	ZSTD_DCtx* ctx;
+	std::vector<char> inBuf;
+	ZSTD_inBuffer in;
+
+}; // ZstdReader
+
+} // opt
+
+#endif // OPT_COMPRESSION_H
\ No newline at end of file
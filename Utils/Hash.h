@@ -21,7 +21,7 @@ public:
 	template<typename C>
 	uint64_t operator()(const C& c, uint64_t seed = 0) const
 	{
-		return XXH3_64bits_withSeed(c.data(), c.size() * sizeof(C::value_type), seed);
+		return XXH3_64bits_withSeed(c.data(), c.size() * sizeof(typename C::value_type), seed);
 	}
 };
 
@@ -0,0 +1,129 @@
+#ifndef OPT_JSONLINE_H
+#define OPT_JSONLINE_H
+
+#include <string>
+#include <sstream>
+#include <cmath>
+
+namespace opt {
+
+// Build a flat JSON object on a single line, to be appended
+// to a JSON-lines file.
+class JsonLine
+{
+public:
+	JsonLine()
+	{
+		os.precision(10);
+	}
+
+	JsonLine& add(const std::string& key, const std::string& value)
+	{
+		addKey(key);
+		os << quote(value);
+		return *this;
+	}
+
+	JsonLine& add(const std::string& key, const char* value)
+	{
+		return add(key, std::string(value));
+	}
+
+	JsonLine& add(const std::string& key, const bool value)
+	{
+		addKey(key);
+		os << (value ? "true" : "false");
+		return *this;
+	}
+
+	JsonLine& add(const std::string& key, const double value)
+	{
+		addKey(key);
+		writeNum(value);
+		return *this;
+	}
+
+	JsonLine& add(const std::string& key, const float value)
+	{
+		return add(key, (double)value);
+	}
+
+	JsonLine& add(const std::string& key, const uint64_t value)
+	{
+		addKey(key);
+		os << value;
+		return *this;
+	}
+
+	JsonLine& add(const std::string& key, const int64_t value)
+	{
+		addKey(key);
+		os << value;
+		return *this;
+	}
+
+	JsonLine& add(const std::string& key, const unsigned value)
+	{
+		return add(key, (uint64_t)value);
+	}
+
+	JsonLine& add(const std::string& key, const int value)
+	{
+		return add(key, (int64_t)value);
+	}
+
+	// C is a container of numbers.
+	template<class C>
+	JsonLine& addArray(const std::string& key, const C& values)
+	{
+		addKey(key);
+		os << "[";
+		bool first = true;
+		for (const auto& x : values) {
+			if (!first) os << ",";
+			writeNum((double)x);
+			first = false;
+		}
+		os << "]";
+		return *this;
+	}
+
+	std::string str() const
+	{
+		return "{" + os.str() + "}";
+	}
+
+private:
+	void addKey(const std::string& key)
+	{
+		if (!empty) os << ",";
+		os << quote(key) << ":";
+		empty = false;
+	}
+
+	void writeNum(const double x)
+	{
+		// NaN and infinity are not valid JSON.
+		if (!std::isfinite(x)) os << "null";
+		else if (x == std::round(x) && std::abs(x) < 1e15) os << (int64_t)x;
+		else os << x;
+	}
+
+	static std::string quote(const std::string& s)
+	{
+		std::string res = "\"";
+		for (const char c : s) {
+			if (c == '"' || c == '\\') res += '\\';
+			res += c;
+		}
+		return res + "\"";
+	}
+
+	std::ostringstream os;
+	bool empty = true;
+
+}; // JsonLine
+
+} // opt
+
+#endif // OPT_JSONLINE_H
\ No newline at end of file
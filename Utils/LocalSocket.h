@@ -0,0 +1,198 @@
+#ifndef OPT_LOCALSOCKET_H
+#define OPT_LOCALSOCKET_H
+
+#include <string>
+#include <stdexcept>
+#include <mutex>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace opt {
+
+// Stream socket bound to a path of the file system (Unix domain socket),
+// to exchange data with the other processes of the machine.
+// The socket is closed when the object is destroyed.
+class LocalSocket
+{
+public:
+	LocalSocket() :
+		mSocket(INVALID)
+	{
+	}
+
+	~LocalSocket()
+	{
+		close();
+	}
+
+	LocalSocket(const LocalSocket&) = delete;
+	LocalSocket& operator=(const LocalSocket&) = delete;
+
+	LocalSocket(LocalSocket&& other) noexcept :
+		mSocket(other.mSocket)
+	{
+		other.mSocket = INVALID;
+	}
+
+	LocalSocket& operator=(LocalSocket&& other) noexcept
+	{
+		if (this != &other) {
+			close();
+			mSocket = other.mSocket;
+			other.mSocket = INVALID;
+		}
+		return *this;
+	}
+
+	// Listen at path, replacing the socket file left by a previous server.
+	void listen(const std::string& path, int backlog = 64)
+	{
+		open();
+		const sockaddr_un addr = address(path);
+		removeFile(path);
+		if (::bind(mSocket, (const sockaddr*)&addr, sizeof(addr)) != 0)
+			throw std::runtime_error("Socket could not be bound.");
+		if (::listen(mSocket, backlog) != 0)
+			throw std::runtime_error("Socket could not listen.");
+	}
+
+	// Block until a client connects to the listening socket.
+	LocalSocket accept() const
+	{
+		LocalSocket client;
+		client.mSocket = ::accept(mSocket, NULL, NULL);
+		if (client.mSocket == INVALID)
+			throw std::runtime_error("Connection could not be accepted.");
+		return client;
+	}
+
+	void connect(const std::string& path)
+	{
+		open();
+		const sockaddr_un addr = address(path);
+		if (::connect(mSocket, (const sockaddr*)&addr, sizeof(addr)) != 0)
+			throw std::runtime_error("Socket could not connect.");
+	}
+
+	// Return false if the peer closed the connection before size bytes were read.
+	bool readAll(void* dst, size_t size)
+	{
+		char* p = (char*)dst;
+		while (size) {
+			const int n = (int)::recv(mSocket, p, (int)std::min(size, maxChunk), 0);
+			if (n <= 0) return false;
+			p += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	// Return false if the peer closed the connection.
+	bool writeAll(const void* src, size_t size)
+	{
+		const char* p = (const char*)src;
+		while (size) {
+			const int n = (int)::send(mSocket, p, (int)std::min(size, maxChunk), sendFlags);
+			if (n <= 0) return false;
+			p += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	// Unblock the accept of another thread on the listening socket, which then throws.
+	// Only closing the socket does it on Windows, and only shutting it down on Linux.
+	void stopListening()
+	{
+#ifdef _WIN32
+		close();
+#else
+		shutdown();
+#endif
+	}
+
+	// Unblock the reads of the other threads and make them return false.
+	void shutdown()
+	{
+		if (mSocket == INVALID) return;
+#ifdef _WIN32
+		::shutdown(mSocket, SD_BOTH);
+#else
+		::shutdown(mSocket, SHUT_RDWR);
+#endif
+	}
+
+	void close()
+	{
+		if (mSocket == INVALID) return;
+#ifdef _WIN32
+		closesocket(mSocket);
+#else
+		::close(mSocket);
+#endif
+		mSocket = INVALID;
+	}
+
+	bool isOpen() const { return mSocket != INVALID; }
+
+	static void removeFile(const std::string& path)
+	{
+		std::remove(path.c_str());
+	}
+
+private:
+#ifdef _WIN32
+	typedef SOCKET socket_t;
+	static constexpr socket_t INVALID = INVALID_SOCKET;
+	static constexpr int sendFlags = 0;
+#else
+	typedef int socket_t;
+	static constexpr socket_t INVALID = -1;
+	// A write to a closed connection must not kill the process with SIGPIPE.
+	static constexpr int sendFlags = MSG_NOSIGNAL;
+#endif
+	static constexpr size_t maxChunk = 1 << 30;
+
+	void open()
+	{
+		close();
+#ifdef _WIN32
+		static std::once_flag wsaFlag;
+		std::call_once(wsaFlag, []() {
+			WSADATA wsaData;
+			if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+				throw std::runtime_error("Winsock could not be started.");
+		});
+#endif
+		mSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (mSocket == INVALID)
+			throw std::runtime_error("Socket could not be created.");
+	}
+
+	static sockaddr_un address(const std::string& path)
+	{
+		sockaddr_un addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (path.size() >= sizeof(addr.sun_path))
+			throw std::runtime_error("Socket path too long.");
+		std::memcpy(addr.sun_path, path.c_str(), path.size());
+		return addr;
+	}
+
+	socket_t mSocket;
+
+}; // LocalSocket
+
+} // opt
+
+#endif // OPT_LOCALSOCKET_H
\ No newline at end of file
@@ -0,0 +1,293 @@
+#ifndef OPT_MEMORYMAP_H
+#define OPT_MEMORYMAP_H
+
+#include <string>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace opt {
+
+// Map a file or a named shared memory segment in the address space
+// of the process. The mapping is released when the object is destroyed.
+class MemoryMap
+{
+public:
+	MemoryMap() :
+		mData(nullptr), mSize(0), mReadOnly(false), mCopyOnWrite(false)
+	{
+	}
+
+	~MemoryMap()
+	{
+		unmap();
+	}
+
+	MemoryMap(const MemoryMap&) = delete;
+	MemoryMap& operator=(const MemoryMap&) = delete;
+
+	// Map the file at path. If size is not 0, the file is created
+	// if needed and resized to size bytes. Otherwise, the whole
+	// existing file is mapped. With copyOnWrite, the writes are
+	// private to the process and never reach the file.
+	void mapFile(const std::string& path, size_t size = 0,
+		bool readOnly = false, bool copyOnWrite = false)
+	{
+		unmap();
+		mReadOnly = readOnly;
+		mCopyOnWrite = copyOnWrite;
+
+#ifdef _WIN32
+		mFile = CreateFileA(path.c_str(),
+			(readOnly || copyOnWrite) ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE,
+			FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+			(size && !readOnly && !copyOnWrite) ? OPEN_ALWAYS : OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+		if (mFile == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("File could not be opened.");
+		if (!size) {
+			LARGE_INTEGER fileSize;
+			GetFileSizeEx(mFile, &fileSize);
+			size = (size_t)fileSize.QuadPart;
+		}
+		mapHandle(mFile, size, NULL);
+#else
+		mFd = open(path.c_str(),
+			(readOnly || copyOnWrite) ? O_RDONLY : (size ? O_RDWR | O_CREAT : O_RDWR), 0644);
+		if (mFd < 0)
+			throw std::runtime_error("File could not be opened.");
+		if (size && !readOnly && !copyOnWrite) {
+			if (ftruncate(mFd, (off_t)size) != 0)
+				throw std::runtime_error("File could not be resized.");
+		}
+		else if (!size) {
+			struct stat st;
+			fstat(mFd, &st);
+			size = (size_t)st.st_size;
+		}
+		mapFd(size);
+#endif
+	}
+
+	// Create the shared memory segment called name, filled with zeros.
+	// Throw an exception if it already exists.
+	void createShared(const std::string& name, size_t size)
+	{
+		unmap();
+		mReadOnly = false;
+		mCopyOnWrite = false;
+
+#ifdef _WIN32
+		const HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+			(DWORD)((uint64_t)size >> 32), (DWORD)size, sharedName(name).c_str());
+		if (mapping == NULL)
+			throw std::runtime_error("Shared memory could not be created.");
+		if (GetLastError() == ERROR_ALREADY_EXISTS) {
+			CloseHandle(mapping);
+			throw std::runtime_error("Shared memory already exists.");
+		}
+		mapHandle(INVALID_HANDLE_VALUE, size, mapping);
+#else
+		mFd = shm_open(sharedName(name).c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (mFd < 0)
+			throw std::runtime_error("Shared memory could not be created.");
+		if (ftruncate(mFd, (off_t)size) != 0)
+			throw std::runtime_error("Shared memory could not be resized.");
+		mapFd(size);
+#endif
+	}
+
+	// Open the existing shared memory segment called name.
+	// Return false if it does not exist.
+	bool openShared(const std::string& name, size_t size)
+	{
+		unmap();
+		mReadOnly = false;
+		mCopyOnWrite = false;
+
+#ifdef _WIN32
+		const HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, sharedName(name).c_str());
+		if (mapping == NULL) return false;
+		mapHandle(INVALID_HANDLE_VALUE, size, mapping);
+#else
+		mFd = shm_open(sharedName(name).c_str(), O_RDWR, 0600);
+		if (mFd < 0) return false;
+		// The creator may not have resized the segment yet.
+		struct stat st;
+		if (fstat(mFd, &st) != 0 || (size_t)st.st_size < size) {
+			unmap();
+			return false;
+		}
+		mapFd(size);
+#endif
+
+		return true;
+	}
+
+	// Destroy the shared memory segment called name. The memory is freed
+	// once every process has unmapped it. It is a no-op on Windows, where
+	// the segment is destroyed with its last handle.
+	static void removeShared(const std::string& name)
+	{
+#ifndef _WIN32
+		shm_unlink(sharedName(name).c_str());
+#endif
+	}
+
+	// Write the modified pages in [offset, offset + len) to the file.
+	// len = 0 means until the end of the mapping.
+	void flush(size_t offset = 0, size_t len = 0)
+	{
+		if (!mData || mReadOnly || mCopyOnWrite) return;
+		if (!len) len = mSize - offset;
+#ifdef _WIN32
+		FlushViewOfFile((char*)mData + offset, len);
+		if (mFile != INVALID_HANDLE_VALUE) FlushFileBuffers(mFile);
+#else
+		// msync requires an address aligned on a page.
+		const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		const size_t begin = offset / pageSize * pageSize;
+		msync((char*)mData + begin, offset + len - begin, MS_SYNC);
+#endif
+	}
+
+	enum Advice { ADVICE_NORMAL, ADVICE_RANDOM, ADVICE_SEQUENTIAL, ADVICE_WILLNEED };
+
+	// Tell the system how the pages in [offset, offset + len) will be accessed.
+	// len = 0 means until the end of the mapping.
+	// On Windows, only ADVICE_WILLNEED has an effect.
+	void advise(Advice advice, size_t offset = 0, size_t len = 0)
+	{
+		if (!mData) return;
+		if (!len) len = mSize - offset;
+#ifdef _WIN32
+		if (advice == ADVICE_WILLNEED) {
+			WIN32_MEMORY_RANGE_ENTRY range{ (char*)mData + offset, len };
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+#else
+		static const int advices[] = { MADV_NORMAL, MADV_RANDOM, MADV_SEQUENTIAL, MADV_WILLNEED };
+		const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+		const size_t begin = offset / pageSize * pageSize;
+		madvise((char*)mData + begin, offset + len - begin, advices[advice]);
+#endif
+	}
+
+	// Keep the pages of [p, p + len) in RAM.
+	// Return false if the system refused, e.g. because of its limits.
+	static bool lock(void* p, size_t len)
+	{
+#ifdef _WIN32
+		return VirtualLock(p, len);
+#else
+		return mlock(p, len) == 0;
+#endif
+	}
+
+	void unmap()
+	{
+#ifdef _WIN32
+		if (mData) UnmapViewOfFile(mData);
+		if (mMapping != NULL) CloseHandle(mMapping);
+		if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+		mMapping = NULL;
+		mFile = INVALID_HANDLE_VALUE;
+#else
+		if (mData) munmap(mData, mSize);
+		if (mFd >= 0) close(mFd);
+		mFd = -1;
+#endif
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	void* data() { return mData; }
+	const void* data() const { return mData; }
+	size_t size() const { return mSize; }
+	bool isMapped() const { return mData != nullptr; }
+
+private:
+	static std::string sharedName(const std::string& name)
+	{
+#ifdef _WIN32
+		return "Local\\" + name;
+#else
+		return "/" + name;
+#endif
+	}
+
+#ifdef _WIN32
+	void mapHandle(HANDLE file, size_t size, HANDLE mapping)
+	{
+		if (mapping == NULL) {
+			mapping = CreateFileMappingA(file, NULL,
+				mReadOnly ? PAGE_READONLY : (mCopyOnWrite ? PAGE_WRITECOPY : PAGE_READWRITE),
+				(DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+			if (mapping == NULL)
+				throw std::runtime_error("File could not be mapped.");
+		}
+		mMapping = mapping;
+		mData = MapViewOfFile(mapping,
+			mReadOnly ? FILE_MAP_READ : (mCopyOnWrite ? FILE_MAP_COPY : FILE_MAP_ALL_ACCESS), 0, 0, size);
+		if (mData == NULL)
+			throw std::runtime_error("File could not be mapped.");
+		mSize = size;
+	}
+
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = NULL;
+#else
+	void mapFd(size_t size)
+	{
+		void* p = mmap(nullptr, size, mReadOnly ? PROT_READ : PROT_READ | PROT_WRITE,
+			mCopyOnWrite ? MAP_PRIVATE : MAP_SHARED, mFd, 0);
+		if (p == MAP_FAILED)
+			throw std::runtime_error("File could not be mapped.");
+		mData = p;
+		mSize = size;
+	}
+
+	int mFd = -1;
+#endif
+
+	void* mData;
+	size_t mSize;
+	bool mReadOnly;
+	bool mCopyOnWrite;
+
+}; // MemoryMap
+
+// Write the data of the file at path to the disk, or the entries of the
+// directory at path so that a file renamed in it survives a crash.
+// On Windows, the directories are not synced. Return false on failure.
+inline bool syncPath(const std::string& path)
+{
+#ifdef _WIN32
+	const DWORD attributes = GetFileAttributesA(path.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES) return false;
+	if (attributes & FILE_ATTRIBUTE_DIRECTORY) return true;
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE,
+		FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	const bool synced = FlushFileBuffers(file) != 0;
+	CloseHandle(file);
+	return synced;
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	const bool synced = ::fsync(fd) == 0;
+	::close(fd);
+	return synced;
+#endif
+}
+
+} // opt
+
+#endif // OPT_MEMORYMAP_H
\ No newline at end of file
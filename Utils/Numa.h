@@ -0,0 +1,131 @@
+#ifndef OPT_NUMA_H
+#define OPT_NUMA_H
+
+#include "NumaPolicy.h"
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace opt {
+
+inline unsigned numaNodesCount()
+{
+#ifdef _WIN32
+	ULONG highestNode;
+	if (!GetNumaHighestNodeNumber(&highestNode)) return 1;
+	return (unsigned)highestNode + 1;
+#else
+	unsigned n = 0;
+	while (std::filesystem::exists("/sys/devices/system/node/node" + std::to_string(n))) ++n;
+	return n ? n : 1;
+#endif
+}
+
+#ifndef _WIN32
+namespace detail {
+
+// Same values as in numaif.h, so that libnuma is not needed.
+static const int MPOL_BIND_ = 2;
+static const int MPOL_INTERLEAVE_ = 3;
+static const unsigned MPOL_MF_MOVE_ = 1 << 1;
+
+// Apply the memory policy mode to the pages fully inside [p, p + len)
+// and move the pages already touched. Return false if the kernel refused it.
+inline bool mbindPages(void* p, size_t len, int mode, uint64_t nodeMask)
+{
+	const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t begin = ((size_t)p + pageSize - 1) / pageSize * pageSize;
+	const size_t end = ((size_t)p + len) / pageSize * pageSize;
+	if (end <= begin) return true;
+	return syscall(SYS_mbind, begin, end - begin, mode, &nodeMask, 64, MPOL_MF_MOVE_) == 0;
+}
+
+} // detail
+#endif
+
+// Spread the pages of [p, p + len) over all the nodes.
+// It is a no-op on Windows, where the placement can only
+// be chosen at allocation time.
+// Return false if the pages could not be moved.
+inline bool interleaveMemory(void* p, size_t len)
+{
+#ifndef _WIN32
+	const unsigned nNodes = numaNodesCount();
+	if (nNodes < 2) return true;
+	const uint64_t nodeMask = (nNodes >= 64) ? ~0ull : (1ull << nNodes) - 1;
+	return detail::mbindPages(p, len, detail::MPOL_INTERLEAVE_, nodeMask);
+#else
+	return true;
+#endif
+}
+
+// Place the pages of [p, p + len) on node.
+// It is a no-op on Windows.
+// Return false if the pages could not be moved.
+inline bool bindMemory(void* p, size_t len, unsigned node)
+{
+#ifndef _WIN32
+	if (numaNodesCount() < 2 || node >= 64) return true;
+	return detail::mbindPages(p, len, detail::MPOL_BIND_, 1ull << node);
+#else
+	return true;
+#endif
+}
+
+// Restrict the whole process to the cpus of node: its current threads,
+// and the threads it starts later, which inherit the affinity.
+// Return false if the affinity could not be set.
+inline bool pinToNumaNode(unsigned node)
+{
+#ifdef _WIN32
+	GROUP_AFFINITY affinity;
+	if (!GetNumaNodeProcessorMaskEx((USHORT)node, &affinity)) return false;
+	// The new threads take the affinity of the process, which can only
+	// be set when the process and the node are in the same processor group.
+	USHORT group;
+	USHORT nGroups = 1;
+	if (GetProcessGroupAffinity(GetCurrentProcess(), &nGroups, &group) && group == affinity.Group
+		&& !SetProcessAffinityMask(GetCurrentProcess(), affinity.Mask)) return false;
+	return SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL) != 0;
+#else
+	// The cpus of the node are listed as ranges, e.g. "0-15,32-47".
+	std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+	std::string ranges;
+	if (!std::getline(file, ranges)) return false;
+
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	size_t pos = 0;
+	while (pos < ranges.size()) {
+		size_t end = ranges.find(',', pos);
+		if (end == std::string::npos) end = ranges.size();
+		const std::string range = ranges.substr(pos, end - pos);
+		const size_t dash = range.find('-');
+		const unsigned first = std::stoul(range.substr(0, dash));
+		const unsigned last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+		for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+			CPU_SET(cpu, &cpus);
+		pos = end + 1;
+	}
+
+	// sched_setaffinity only sets the affinity of one thread.
+	bool ok = true;
+	for (const auto& task : std::filesystem::directory_iterator("/proc/self/task")) {
+		const pid_t tid = (pid_t)std::stoul(task.path().filename().string());
+		ok &= sched_setaffinity(tid, sizeof(cpus), &cpus) == 0;
+	}
+	return ok;
+#endif
+}
+
+} // opt
+
+#endif // OPT_NUMA_H
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef OPT_NUMAPOLICY_H
+#define OPT_NUMAPOLICY_H
+
+#include <cstdint>
+
+namespace opt {
+
+// Placement of a large memory region on the NUMA nodes.
+enum NumaPolicy : uint8_t
+{
+	// Pages are placed on the node of the thread touching them first.
+	NUMA_LOCAL,
+	// Pages are spread round-robin over all the nodes.
+	NUMA_INTERLEAVE,
+	// The region is split in contiguous parts, one per node.
+	NUMA_PARTITION
+};
+
+} // opt
+
+#endif // OPT_NUMAPOLICY_H
\ No newline at end of file
@@ -0,0 +1,104 @@
+#ifndef OPT_OPENHASHMAP_H
+#define OPT_OPENHASHMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace opt {
+
+// Compact hash map from uint64_t keys to values, with open addressing
+// and linear probing. The key ~0 is reserved. Elements cannot be erased.
+template<typename V>
+class OpenHashMap
+{
+public:
+	static constexpr uint64_t EMPTY = ~0ull;
+
+	OpenHashMap() :
+		mSize(0)
+	{
+	}
+
+	// Return the value of key, inserting a default one if needed.
+	V& operator[](uint64_t key)
+	{
+		if ((mSize + 1) * 2 > mKeys.size()) grow();
+		size_t i = slot(key);
+		if (mKeys[i] == EMPTY) {
+			mKeys[i] = key;
+			mValues[i] = V();
+			++mSize;
+		}
+		return mValues[i];
+	}
+
+	// Return nullptr if key is not in the map.
+	const V* find(uint64_t key) const
+	{
+		if (mKeys.empty()) return nullptr;
+		const size_t i = slot(key);
+		return (mKeys[i] == EMPTY) ? nullptr : &mValues[i];
+	}
+
+	// Call f(key, value) for each element.
+	template<class F>
+	void forEach(F f)
+	{
+		for (size_t i = 0; i < mKeys.size(); ++i) {
+			if (mKeys[i] != EMPTY) f(mKeys[i], mValues[i]);
+		}
+	}
+
+	void clear()
+	{
+		std::vector<uint64_t>().swap(mKeys);
+		std::vector<V>().swap(mValues);
+		mSize = 0;
+	}
+
+	size_t size() const { return mSize; }
+	size_t nBytes() const { return mKeys.size() * (sizeof(uint64_t) + sizeof(V)); }
+
+private:
+	// Slot of key, or the empty slot where it would be inserted.
+	size_t slot(uint64_t key) const
+	{
+		const size_t mask = mKeys.size() - 1;
+		size_t i = mix(key) & mask;
+		while (mKeys[i] != key && mKeys[i] != EMPTY) i = (i + 1) & mask;
+		return i;
+	}
+
+	// Keep the load factor below 1/2.
+	void grow()
+	{
+		std::vector<uint64_t> oldKeys(mKeys.empty() ? 16 : 2 * mKeys.size(), EMPTY);
+		std::vector<V> oldValues(oldKeys.size());
+		oldKeys.swap(mKeys);
+		oldValues.swap(mValues);
+		for (size_t i = 0; i < oldKeys.size(); ++i) {
+			if (oldKeys[i] == EMPTY) continue;
+			const size_t j = slot(oldKeys[i]);
+			mKeys[j] = oldKeys[i];
+			mValues[j] = oldValues[i];
+		}
+	}
+
+	// Finalizer of splitmix64.
+	static uint64_t mix(uint64_t x)
+	{
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return x ^ (x >> 31);
+	}
+
+	std::vector<uint64_t> mKeys;
+	std::vector<V> mValues;
+	size_t mSize;
+
+}; // OpenHashMap
+
+} // opt
+
+#endif // OPT_OPENHASHMAP_H
\ No newline at end of file
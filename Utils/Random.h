@@ -2,6 +2,7 @@
 #define OPT_RANDOM_H
 
 #include <stdexcept>
+#include <cmath>
 #include "ioVar.h"
 
 namespace opt {
@@ -2,6 +2,7 @@
 #define OPT_STRINGMANIP_H
 
 #include <sstream>
+#include <cmath>
 
 namespace opt {
 
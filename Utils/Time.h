@@ -3,6 +3,7 @@
 
 #include <string>
 #include <chrono>
+#include <cmath>
 
 namespace opt {
 
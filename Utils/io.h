@@ -2,6 +2,21 @@
 #define OPT_IO_H
 
 #include <fstream>
+#include <string>
+#include <span>
+#include <vector>
+#include <thread>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <new>
+#include <exception>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace opt {
 
@@ -16,6 +31,352 @@ inline std::fstream fstream(const std::string& filename,
     return fs;
 }
 
+// Unbuffered file read and written at given offsets, so that several
+// threads can use their own RawFile on the same file.
+// With direct, the system cache is bypassed (O_DIRECT, only on Linux):
+// the buffers, sizes and offsets must then be multiples of ioAlignment.
+class RawFile
+{
+public:
+	enum Mode { READ, WRITE, UPDATE };
+
+	static constexpr size_t ioAlignment = 4096;
+
+	RawFile(const std::string& path, Mode mode, bool direct = false) :
+		mDirect(false)
+	{
+#ifdef _WIN32
+		static const char* modes[] = { "rb", "wb", "r+b" };
+		mFile = std::fopen(path.c_str(), modes[mode]);
+		if (!mFile)
+			throw std::runtime_error("File could not be opened.");
+		std::setvbuf(mFile, nullptr, _IONBF, 0);
+#else
+		static const int flags[] = { O_RDONLY, O_WRONLY | O_CREAT | O_TRUNC, O_WRONLY };
+#ifdef O_DIRECT
+		// Some file systems do not support O_DIRECT.
+		if (direct) {
+			mFd = open(path.c_str(), flags[mode] | O_DIRECT, 0644);
+			mDirect = mFd >= 0;
+		}
+#endif
+		if (mFd < 0) mFd = open(path.c_str(), flags[mode], 0644);
+		if (mFd < 0)
+			throw std::runtime_error("File could not be opened.");
+#endif
+	}
+
+	~RawFile()
+	{
+#ifdef _WIN32
+		if (mFile) std::fclose(mFile);
+#else
+		if (mFd >= 0) ::close(mFd);
+#endif
+	}
+
+	RawFile(const RawFile&) = delete;
+	RawFile& operator=(const RawFile&) = delete;
+
+	// Return the number of bytes read, less than size only at the end of the file.
+	size_t readAt(void* dst, size_t size, uint64_t offset)
+	{
+		size_t res = 0;
+		while (res < size) {
+#ifdef _WIN32
+			if (_fseeki64(mFile, (int64_t)(offset + res), SEEK_SET) != 0)
+				throw std::runtime_error("File could not be read.");
+			const size_t n = std::fread((char*)dst + res, 1, size - res, mFile);
+			if (n == 0 && std::ferror(mFile))
+				throw std::runtime_error("File could not be read.");
+#else
+			const ssize_t n = pread(mFd, (char*)dst + res, size - res, (off_t)(offset + res));
+			if (n < 0)
+				throw std::runtime_error("File could not be read.");
+#endif
+			if (n == 0) break;
+			res += (size_t)n;
+		}
+		return res;
+	}
+
+	void writeAt(const void* src, size_t size, uint64_t offset)
+	{
+		size_t done = 0;
+		while (done < size) {
+#ifdef _WIN32
+			if (_fseeki64(mFile, (int64_t)(offset + done), SEEK_SET) != 0)
+				throw std::runtime_error("File could not be written.");
+			const size_t n = std::fwrite((const char*)src + done, 1, size - done, mFile);
+			if (n == 0)
+				throw std::runtime_error("File could not be written.");
+#else
+			const ssize_t n = pwrite(mFd, (const char*)src + done, size - done, (off_t)(offset + done));
+			if (n <= 0)
+				throw std::runtime_error("File could not be written.");
+#endif
+			done += (size_t)n;
+		}
+	}
+
+	// Cut the file at size bytes.
+	void truncate(uint64_t size)
+	{
+#ifndef _WIN32
+		if (ftruncate(mFd, (off_t)size) != 0)
+			throw std::runtime_error("File could not be resized.");
+#endif
+	}
+
+	bool isDirect() const { return mDirect; }
+
+private:
+#ifdef _WIN32
+	FILE* mFile = nullptr;
+#else
+	int mFd = -1;
+#endif
+	bool mDirect;
+
+}; // RawFile
+
+// Buffer aligned on RawFile::ioAlignment.
+class AlignedBuffer
+{
+public:
+	AlignedBuffer(size_t size) :
+		mData((char*)::operator new(size, std::align_val_t(RawFile::ioAlignment))),
+		mSize(size)
+	{
+	}
+
+	~AlignedBuffer()
+	{
+		::operator delete(mData, std::align_val_t(RawFile::ioAlignment));
+	}
+
+	AlignedBuffer(const AlignedBuffer&) = delete;
+	AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+	char* data() { return mData; }
+	size_t size() const { return mSize; }
+
+private:
+	char* mData;
+	size_t mSize;
+
+}; // AlignedBuffer
+
+static const size_t ioBufferSize = 1 << 23;
+
+// Write a binary file sequentially through a large buffer.
+class BinaryWriter
+{
+public:
+	BinaryWriter(const std::string& path, bool direct = false, size_t bufferSize = ioBufferSize) :
+		mFile(path, RawFile::WRITE, direct),
+		mBuf((bufferSize + RawFile::ioAlignment - 1) / RawFile::ioAlignment * RawFile::ioAlignment),
+		mBufPos(0),
+		mOffset(0),
+		mIsOpen(true)
+	{
+	}
+
+	~BinaryWriter()
+	{
+		// Errors can only be reported by an explicit close.
+		try { close(); }
+		catch (...) {}
+	}
+
+	void write(const void* src, size_t size)
+	{
+		// Big writes skip the buffer when the alignment does not matter.
+		if (!mFile.isDirect() && size >= mBuf.size()) {
+			flushBuffer();
+			mFile.writeAt(src, size, mOffset);
+			mOffset += size;
+			return;
+		}
+		while (size) {
+			const size_t n = (std::min)(size, mBuf.size() - mBufPos);
+			std::memcpy(mBuf.data() + mBufPos, src, n);
+			mBufPos += n;
+			src = (const char*)src + n;
+			size -= n;
+			if (mBufPos == mBuf.size()) flushBuffer();
+		}
+	}
+
+	template<typename T, size_t N>
+	void write(std::span<T, N> values)
+	{
+		write(values.data(), values.size_bytes());
+	}
+
+	template<typename T>
+	void writeVar(const T& var)
+	{
+		write(&var, sizeof(var));
+	}
+
+	void close()
+	{
+		if (!mIsOpen) return;
+		mIsOpen = false;
+		const uint64_t size = mOffset + mBufPos;
+		if (mFile.isDirect() && mBufPos % RawFile::ioAlignment) {
+			// Direct writes must be whole blocks: pad, then cut the file.
+			const size_t padded = (mBufPos + RawFile::ioAlignment - 1) / RawFile::ioAlignment * RawFile::ioAlignment;
+			std::memset(mBuf.data() + mBufPos, 0, padded - mBufPos);
+			mBufPos = padded;
+			flushBuffer();
+			mFile.truncate(size);
+		}
+		else flushBuffer();
+	}
+
+private:
+	void flushBuffer()
+	{
+		if (!mBufPos) return;
+		mFile.writeAt(mBuf.data(), mBufPos, mOffset);
+		mOffset += mBufPos;
+		mBufPos = 0;
+	}
+
+	RawFile mFile;
+	AlignedBuffer mBuf;
+	size_t mBufPos;
+	uint64_t mOffset;
+	bool mIsOpen;
+
+}; // BinaryWriter
+
+// Read a binary file sequentially through a large buffer.
+class BinaryReader
+{
+public:
+	BinaryReader(const std::string& path, bool direct = false, size_t bufferSize = ioBufferSize) :
+		mFile(path, RawFile::READ, direct),
+		mBuf((bufferSize + RawFile::ioAlignment - 1) / RawFile::ioAlignment * RawFile::ioAlignment),
+		mBufPos(0),
+		mBufEnd(0),
+		mOffset(0)
+	{
+	}
+
+	// Throw an exception if the file ends before size bytes.
+	void read(void* dst, size_t size)
+	{
+		const size_t n = (std::min)(size, mBufEnd - mBufPos);
+		std::memcpy(dst, mBuf.data() + mBufPos, n);
+		mBufPos += n;
+		dst = (char*)dst + n;
+		size -= n;
+
+		// Big reads skip the buffer when the alignment does not matter.
+		if (!mFile.isDirect() && size >= mBuf.size()) {
+			if (mFile.readAt(dst, size, mOffset) != size)
+				throw std::runtime_error("File shorter than expected.");
+			mOffset += size;
+			return;
+		}
+		while (size) {
+			fillBuffer();
+			const size_t m = (std::min)(size, mBufEnd - mBufPos);
+			std::memcpy(dst, mBuf.data() + mBufPos, m);
+			mBufPos += m;
+			dst = (char*)dst + m;
+			size -= m;
+		}
+	}
+
+	template<typename T, size_t N>
+	void read(std::span<T, N> values)
+	{
+		read(values.data(), values.size_bytes());
+	}
+
+	template<typename T>
+	void readVar(T& var)
+	{
+		read(&var, sizeof(var));
+	}
+
+private:
+	void fillBuffer()
+	{
+		mBufPos = 0;
+		mBufEnd = mFile.readAt(mBuf.data(), mBuf.size(), mOffset);
+		mOffset += mBufEnd;
+		if (!mBufEnd)
+			throw std::runtime_error("File shorter than expected.");
+	}
+
+	RawFile mFile;
+	AlignedBuffer mBuf;
+	size_t mBufPos;
+	size_t mBufEnd;
+	uint64_t mOffset;
+
+}; // BinaryReader
+
+// Size of the pieces of a file written or read by one thread at a time.
+static const size_t ioChunkSize = 1 << 26;
+
+// Run f(offset, size) on the chunks of [0, size) with nThreads threads.
+template<class F>
+inline void forEachIoChunk(size_t size, unsigned nThreads, F f)
+{
+	const size_t nChunks = (size + ioChunkSize - 1) / ioChunkSize;
+	nThreads = (unsigned)(std::min)((size_t)(std::max)(nThreads, 1u), nChunks);
+	std::vector<std::exception_ptr> errors(nThreads);
+
+	auto work = [&](unsigned threadIdx) {
+		try {
+			for (size_t c = threadIdx; c < nChunks; c += nThreads) {
+				const size_t offset = c * ioChunkSize;
+				f(offset, (std::min)(ioChunkSize, size - offset));
+			}
+		}
+		catch (...) {
+			errors[threadIdx] = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < nThreads; ++t) threads.emplace_back(work, t);
+	if (nThreads) work(0);
+	for (auto& t : threads) t.join();
+	for (const auto& error : errors) {
+		if (error) std::rethrow_exception(error);
+	}
+}
+
+// Write [data, data + size) in the file at path with several threads,
+// each one writing its own chunks with its own handle.
+inline void writeFileParallel(const std::string& path, const void* data, size_t size,
+	unsigned nThreads = std::thread::hardware_concurrency())
+{
+	RawFile(path, RawFile::WRITE);
+	forEachIoChunk(size, nThreads, [&](size_t offset, size_t n) {
+		RawFile file(path, RawFile::UPDATE);
+		file.writeAt((const char*)data + offset, n, offset);
+	});
+}
+
+// Read size bytes of the file at path from offset fileOffset with several threads.
+inline void readFileParallel(const std::string& path, void* data, size_t size,
+	uint64_t fileOffset = 0, unsigned nThreads = std::thread::hardware_concurrency())
+{
+	forEachIoChunk(size, nThreads, [&](size_t offset, size_t n) {
+		RawFile file(path, RawFile::READ);
+		if (file.readAt((char*)data + offset, n, fileOffset + offset) != n)
+			throw std::runtime_error("File shorter than expected.");
+	});
+}
+
 } // opt
 
 #endif // OPT_IO_H
\ No newline at end of file
@@ -6,18 +6,28 @@
 
 namespace opt {
 
+// The helpers taking a path go through the buffered and parallel
+// functions of io.h, and the ones taking a BinaryWriter or a BinaryReader
+// through its buffer. The ones taking a std::fstream are kept for the
+// files also written by classes saving themselves in a std::fstream
+// (random generators, RegretTable, checkpoint states).
+
 template<typename A>
 inline void saveArray(const A& arr, std::fstream& file)
 {
 	file.write((char*)&arr[0], sizeof(arr));
 }
 
+template<typename A>
+inline void saveArray(const A& arr, BinaryWriter& file)
+{
+	file.write(&arr[0], sizeof(arr));
+}
+
 template<typename A>
 inline void saveArray(const A& arr, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::out | std::ios::binary);
-	saveArray(arr, file);
-	file.close();
+	writeFileParallel(path, &arr[0], sizeof(arr));
 }
 
 template<typename A>
@@ -26,12 +36,16 @@ inline void loadArray(A& arr, std::fstream& file)
 	file.read((char*)&arr[0], sizeof(arr));
 }
 
+template<typename A>
+inline void loadArray(A& arr, BinaryReader& file)
+{
+	file.read(&arr[0], sizeof(arr));
+}
+
 template<typename A>
 inline void loadArray(A& arr, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::in | std::ios::binary);
-	loadArray(arr, file);
-	file.close();
+	readFileParallel(path, &arr[0], sizeof(arr));
 }
 
 template<typename V>
@@ -40,12 +54,16 @@ inline void save1DVector(const V& v, std::fstream& file)
 	file.write((char*)&v[0], v.size() * sizeof(v[0]));
 }
 
+template<typename V>
+inline void save1DVector(const V& v, BinaryWriter& file)
+{
+	file.write(&v[0], v.size() * sizeof(v[0]));
+}
+
 template<typename V>
 inline void save1DVector(const V& v, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::out | std::ios::binary);
-	save1DVector(v, file);
-	file.close();
+	writeFileParallel(path, &v[0], v.size() * sizeof(v[0]));
 }
 
 template<typename V>
@@ -54,12 +72,16 @@ inline void load1DVector(V& v, std::fstream& file)
 	file.read((char*)&v[0], v.size() * sizeof(v[0]));
 }
 
+template<typename V>
+inline void load1DVector(V& v, BinaryReader& file)
+{
+	file.read(&v[0], v.size() * sizeof(v[0]));
+}
+
 template<typename V>
 inline void load1DVector(V& v, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::in | std::ios::binary);
-	load1DVector(v, file);
-	file.close();
+	readFileParallel(path, &v[0], v.size() * sizeof(v[0]));
 }
 
 // Warning: 2D vectors are NOT in contiguous memory.
@@ -70,10 +92,16 @@ inline void save2DVector(const V& v, std::fstream& file)
 	for (const auto& w : v) save1DVector(w, file);
 }
 
+template<typename V>
+inline void save2DVector(const V& v, BinaryWriter& file)
+{
+	for (const auto& w : v) save1DVector(w, file);
+}
+
 template<typename V>
 inline void save2DVector(const V& v, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::out | std::ios::binary);
+	BinaryWriter file(path);
 	save2DVector(v, file);
 	file.close();
 }
@@ -86,12 +114,17 @@ inline void load2DVector(V& v, std::fstream& file)
 	for (auto& w : v) load1DVector(w, file);
 }
 
+template<typename V>
+inline void load2DVector(V& v, BinaryReader& file)
+{
+	for (auto& w : v) load1DVector(w, file);
+}
+
 template<typename V>
 inline void load2DVector(V& v, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::in | std::ios::binary);
+	BinaryReader file(path);
 	load2DVector(v, file);
-	file.close();
 }
 
 template<typename V>
@@ -100,10 +133,16 @@ inline void save3DVector(const V& v, std::fstream& file)
 	for (const auto& w : v) save2DVector(w, file);
 }
 
+template<typename V>
+inline void save3DVector(const V& v, BinaryWriter& file)
+{
+	for (const auto& w : v) save2DVector(w, file);
+}
+
 template<typename V>
 inline void save3DVector(const V& v, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::out | std::ios::binary);
+	BinaryWriter file(path);
 	save3DVector(v, file);
 	file.close();
 }
@@ -114,12 +153,17 @@ inline void load3DVector(V& v, std::fstream& file)
 	for (auto& w : v) load2DVector(w, file);
 }
 
+template<typename V>
+inline void load3DVector(V& v, BinaryReader& file)
+{
+	for (auto& w : v) load2DVector(w, file);
+}
+
 template<typename V>
 inline void load3DVector(V& v, const std::string& path)
 {
-	auto file = opt::fstream(path, std::ios::in | std::ios::binary);
+	BinaryReader file(path);
 	load3DVector(v, file);
-	file.close();
 }
 
 } // opt
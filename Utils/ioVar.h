@@ -1,6 +1,7 @@
 #ifndef OPT_IOVAR_H
 #define OPT_IOVAR_H
 
+#include "io.h"
 #include <fstream>
 #include <vector>
 #include <string>
@@ -14,12 +15,24 @@ inline void saveVar(const T& var, std::fstream& file)
 	file.write((char*)&var, sizeof(var));
 }
 
+template<typename T>
+inline void saveVar(const T& var, BinaryWriter& file)
+{
+	file.writeVar(var);
+}
+
 template<typename T>
 inline void loadVar(T& var, std::fstream& file)
 {
 	file.read((char*)&var, sizeof(var));
 }
 
+template<typename T>
+inline void loadVar(T& var, BinaryReader& file)
+{
+	file.readVar(var);
+}
+
 #define WRITE_VAR(os, var) opt::writeVar(os, var, #var)
 
 inline std::ostream& operator<<(std::ostream& os, const uint8_t& n)
@@ -56,6 +69,20 @@ inline std::string extractVarValue(const std::string& var)
 		throw std::runtime_error("Variable's value not found.");
 }
 
+// Line written by writeVar for varName, or an empty string if is has none.
+inline std::string findVarLine(std::istream& is, const std::string& varName)
+{
+	is.clear();
+	is.seekg(0);
+	const std::string prefix = varName + " = ";
+	std::string line;
+	while (std::getline(is, line)) {
+		if (line.compare(0, prefix.size(), prefix) == 0)
+			return line;
+	}
+	return "";
+}
+
 inline void skipLine(std::istream& is)
 {
 	std::string line;
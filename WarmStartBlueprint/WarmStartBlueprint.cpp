@@ -0,0 +1,40 @@
+#include "../Blueprint/WarmStart.h"
+#include "../Utils/Progression.h"
+
+// Usage: WarmStartBlueprint coarseGame coarseBuildName [regretScale]
+// coarseGame is one of the game namespaces of Blueprint/Constants.h
+// (original, large, medium, simple or test), e.g. "medium MEDIUM_BUILD".
+// The regrets written are used by BuildBlueprint when the current
+// blueprint has no checkpoint.
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		std::cout << "Usage: WarmStartBlueprint coarseGame coarseBuildName [regretScale]\n";
+		return 1;
+	}
+	const std::string gameArg = argv[1];
+	bp::BlueprintGame coarseGame;
+	if (gameArg == "original") coarseGame = BP_BLUEPRINT_GAME(original);
+	else if (gameArg == "large") coarseGame = BP_BLUEPRINT_GAME(large);
+	else if (gameArg == "medium") coarseGame = BP_BLUEPRINT_GAME(medium);
+	else if (gameArg == "simple") coarseGame = BP_BLUEPRINT_GAME(simple);
+	else if (gameArg == "test") coarseGame = BP_BLUEPRINT_GAME(test);
+	else {
+		std::cout << "Unknown game: " << gameArg << "\n";
+		return 1;
+	}
+	const double regretScale = (argc > 3) ? std::stod(argv[3]) : 1;
+
+	opt::time_t startTime = opt::getTime();
+	bp::WarmStarter starter(coarseGame, argv[2], regretScale);
+	starter.warmStart();
+
+	std::cout
+		<< "Warm started " << bp::blueprintName() << " from "
+		<< bp::blueprintName(coarseGame.name, argv[2])
+		<< " in " << opt::prettyDuration(opt::getDuration(startTime)) << "\n";
+	for (uint8_t r = 0; r < egn::N_ROUNDS; ++r)
+		std::cout
+			<< egn::roundToString(r) << ": " << std::setprecision(3)
+			<< 100 * starter.mappedSeqsRatio[r] << "% of the action sequences mapped\n";
+}
\ No newline at end of file
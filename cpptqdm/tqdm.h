@@ -1,6 +1,10 @@
 #ifndef TQDM_H
 #define TQDM_H
+#ifdef _WIN32
 #include "unistd.h"
+#else
+#include <unistd.h>
+#endif
 #include <chrono>
 #include <ctime>
 #include <numeric>